@@ -62,14 +62,18 @@
 
   FILE * logFile; // FILE needed to use in fprintf (std stream does not work)
 
-  #define ARTI_ERRORWARNING 1
-  #define ARTI_DEBUG 1
-  #define ARTI_ANDBG 1
-  #define ARTI_RUNLOG 1
-  #define ARTI_MEMORY 1
-  #define ARTI_PRINT 1
+  #ifndef ARTI_BENCHMARK //no logging when measuring performance
+    #define ARTI_ERRORWARNING 1
+    #define ARTI_DEBUG 1
+    #define ARTI_ANDBG 1
+    #define ARTI_RUNLOG 1
+    #define ARTI_MEMORY 1
+    #define ARTI_PRINT 1
+  #endif
 
   #include <math.h>
+  #include <stdarg.h>
+  #include <chrono>
   #include <iostream>
   #include <fstream>
   #include <sstream>
@@ -142,7 +146,7 @@ void artiPrintf(char const * format, ...)
 #if ARTI_PLATFORM != ARTI_ARDUINO
   uint32_t millis()
   {
-    return std::chrono::system_clock::now().time_since_epoch().count();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
   }
 #endif
 
@@ -374,6 +378,9 @@ enum Nodes
     F_Increment,
     F_AssignOperator,
   #endif
+  F_Constant, //syntax tree only (see buildSyntaxTree)
+  F_Operator,
+  F_List,
   F_NoNode = 255
 };
 
@@ -436,6 +443,12 @@ const char * nodeToString(uint8_t key)
     case F_Actuals:
       return "actuals";
   #endif
+  case F_Constant:
+    return "constant";
+  case F_Operator:
+    return "operator";
+  case F_List:
+    return "list";
   }
   return "unknown key";
 }
@@ -489,47 +502,468 @@ uint8_t stringToNode(const char * node)
 
 bool errorOccurred = false;
 
-struct Token {
-    uint16_t lineno;
-    uint16_t column;
-    char type[charLength];
-    char value[charLength]; 
+#define nrOfTokenKinds 64 //tokens of a definition: bits of GrammarElement::first
+#define noKind 255 //no token
+#define endKind 254 //end of the program: no token of a definition has this kind
+#define noElement 65535
+
+#define G_Token 0
+#define G_Node 1
+#define G_Sequence 2 //array: all elements, or one of them if operatorx is '|'
+#define G_Object 3 //{"?" | "*" | "+" | "|": array}
+
+//expression of the definition: a token, a node, an array or an object
+struct GrammarElement {
+  uint64_t first; //token kinds this element can start with
+  uint16_t index; //G_Token: token kind, G_Node: index of nodes, G_Sequence: first element, G_Object: element of its array
+  uint8_t type;
+  char operatorx; //G_Sequence: '&' or the operator of its object, G_Object: the operator
+  uint8_t length; //G_Sequence: number of elements
+  bool nullable; //can succeed without tokens
+};
+
+struct GrammarNode {
+  const char * name;
+  uint16_t element; //expression of the node
+};
+
+#define nrOfTrieNodes 128
+#define noTrieNode 255
+
+//character of the tokens which do not start with a letter or a digit (operators), see Grammar::matchToken
+struct TrieNode {
+  char character;
+  uint8_t kind; //token ending at this character, noKind if none
+  uint8_t child; //first trie node of the next character
+  uint8_t next; //next trie node for the same position
 };
 
-struct LexerPosition {
-  uint16_t pos;
-  char current_char;
+//the definition (wled.json, pas.json) compiled for the lexer and the parser: token kinds instead of token names, nodes and expressions as indexes and FIRST sets
+class Grammar {
+  private:
+  public:
+    JsonObject definitionJson;
+    const char * tokenNames[nrOfTokenKinds]; //keys of TOKENS
+    const char * tokenValues[nrOfTokenKinds];
+    bool tokenSemantic[nrOfTokenKinds]; //added to the parse tree
+    uint8_t tokensLength = 0;
+    uint8_t idKind = noKind;
+    uint8_t integerKind = noKind;
+    uint8_t realKind = noKind;
+    uint8_t tokenTypes[nrOfTokenKinds]; //kind of the token named by the value of a token (keywords), noKind if none
+    uint8_t keywords[nrOfTokenKinds]; //tokens which are ids in uppercase e.g. PROGRAM, in the slots of a minimal perfect hash, see keyword
+    uint16_t keywordDisplacements[nrOfTokenKinds]; //per bucket of keywordHash, 0 if no keyword is in the bucket
+    uint8_t keywordsLength = 0;
+    TrieNode trie[nrOfTrieNodes];
+    uint8_t trieLength = 0;
+    uint8_t trieRoot[128]; //trie node of the first character of operators (ascii)
+    GrammarNode *nodes = nullptr;
+    uint16_t nodesLength = 0;
+    uint16_t nodesSize = 0;
+    GrammarElement *elements = nullptr;
+    uint16_t elementsLength = 0;
+    uint16_t elementsSize = 0;
+
+  Grammar(JsonObject definitionJson) {
+    this->definitionJson = definitionJson;
+
+    for (JsonPair tokenPair: definitionJson["TOKENS"].as<JsonObject>()) {
+      if (tokensLength >= nrOfTokenKinds) {
+        ERROR_ARTI("Definition error: more than %u tokens\n", nrOfTokenKinds);
+        errorOccurred = true;
+        break;
+      }
+      const char * name = tokenPair.key().c_str();
+      const char * value = tokenPair.value();
+      tokenNames[tokensLength] = name;
+      tokenValues[tokensLength] = value;
+
+      //only add 'semantic tokens'
+      const char * semantic[] = {"+", "-", "*", "/", "%", "+=", "-=", "*=", "/=", "<<", ">>", "==", "!=", "&&", "||", ">", ">=", "<", "<=", "++", "--"};
+      tokenSemantic[tokensLength] = strcmp(name, "ID") == 0 || strcmp(name, "INTEGER_CONST") == 0 || strcmp(name, "REAL_CONST") == 0 || strcmp(name, "INTEGER") == 0 || strcmp(name, "REAL") == 0;
+      for (uint8_t i = 0; i < sizeof(semantic) / sizeof(semantic[0]) && value != nullptr; i++)
+        if (strcmp(value, semantic[i]) == 0)
+          tokenSemantic[tokensLength] = true;
+
+      addTrie(value, tokensLength);
+
+      tokensLength++;
+    }
+
+    for (uint8_t kind = 0; kind < tokensLength; kind++)
+      tokenTypes[kind] = tokenValues[kind] != nullptr?tokenKind(tokenValues[kind]):noKind;
+
+    addKeywords();
+
+    idKind = tokenKind("ID");
+    integerKind = tokenKind("INTEGER_CONST");
+    realKind = tokenKind("REAL_CONST");
+    if (idKind == noKind || integerKind == noKind || realKind == noKind) {
+      ERROR_ARTI("Definition error: tokens ID, INTEGER_CONST and REAL_CONST are mandatory\n");
+      errorOccurred = true;
+    }
+  }
+
+  ~Grammar() {
+    free(nodes);
+    free(elements);
+    DEBUG_ARTI("Destruct Grammar\n");
+  }
+
+  //adds the characters of value to the trie if value does not start with a letter or digit (these are ids or numbers)
+  void addTrie(const char * value, uint8_t kind) {
+    if (trieLength == 0)
+      memset(trieRoot, noTrieNode, sizeof(trieRoot));
+    if (value == nullptr || value[0] <= 0 || isalnum(value[0])) return;
+
+    uint8_t *link = &trieRoot[(uint8_t)value[0]];
+    for (const char * c = value; *c != '\0'; c++) {
+      uint8_t node = *link;
+      while (node != noTrieNode && trie[node].character != *c)
+        node = trie[node].next;
+      if (node == noTrieNode) {
+        if (trieLength >= nrOfTrieNodes) {
+          ERROR_ARTI("Definition error: more than %u characters in tokens\n", nrOfTrieNodes);
+          errorOccurred = true;
+          return;
+        }
+        node = trieLength++;
+        trie[node].character = *c;
+        trie[node].kind = noKind;
+        trie[node].child = noTrieNode;
+        trie[node].next = *link; //in front of the other characters of this position
+        *link = node;
+      }
+      if (c[1] == '\0' && trie[node].kind == noKind) //the first token if tokens have the same value
+        trie[node].kind = kind;
+      link = &trie[node].child;
+    }
+  }
+
+  //kind of the longest token (not an id or number) at text, noKind if none, length: number of characters of the token
+  uint8_t matchToken(const char * text, uint8_t *length) {
+    uint8_t kind = noKind;
+    *length = 0;
+    if (text[0] <= 0) return kind;
+    uint8_t node = trieRoot[(uint8_t)text[0]];
+    for (uint8_t i = 0; node != noTrieNode; i++) {
+      while (node != noTrieNode && trie[node].character != text[i])
+        node = trie[node].next;
+      if (node == noTrieNode) break;
+      if (trie[node].kind != noKind) {
+        kind = trie[node].kind;
+        *length = i + 1;
+      }
+      node = trie[node].child;
+    }
+    return kind;
+  }
+
+  //hash of the characters of an id in uppercase, add each character: hash = keywordHash(hash, c), start with keywordHash()
+  static uint32_t keywordHash(uint32_t hash = 2166136261, char c = 0) {
+    return c == 0?hash:(hash ^ (uint8_t)toupper(c)) * 16777619; //FNV-1a
+  }
+
+  //slot of a keyword with hash using displacement
+  uint8_t keywordSlot(uint32_t hash, uint16_t displacement) {
+    hash ^= displacement * 0x9E3779B9;
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6B;
+    hash ^= hash >> 13;
+    return hash % keywordsLength;
+  }
+
+  //minimal perfect hash of the tokens which can be ids (hash and displace): the keywords of a bucket are placed by the first displacement which puts them in free slots, largest buckets first
+  void addKeywords() {
+    uint8_t candidates[nrOfTokenKinds];
+    uint32_t hashes[nrOfTokenKinds];
+    uint8_t buckets[nrOfTokenKinds];
+    keywordsLength = 0;
+    memset(keywords, noKind, sizeof(keywords));
+    memset(keywordDisplacements, 0, sizeof(keywordDisplacements));
+    for (uint8_t kind = 0; kind < tokensLength; kind++) {
+      const char * name = tokenNames[kind];
+      bool isKeyword = isalpha(name[0]);
+      uint32_t hash = keywordHash();
+      for (const char * c = name; *c != '\0' && isKeyword; c++) {
+        isKeyword = (isalnum(*c) || *c == '_') && !islower(*c); //only uppercase names are found by id
+        hash = keywordHash(hash, *c);
+      }
+      if (isKeyword) {
+        candidates[keywordsLength] = kind;
+        hashes[keywordsLength++] = hash;
+      }
+    }
+    if (keywordsLength == 0) return;
+
+    for (uint8_t i = 0; i < keywordsLength; i++)
+      buckets[i] = keywordSlot(hashes[i], 0);
+
+    for (uint8_t size = keywordsLength; size > 0; size--) {
+      for (uint8_t bucket = 0; bucket < keywordsLength; bucket++) {
+        uint8_t bucketSize = 0;
+        for (uint8_t i = 0; i < keywordsLength; i++)
+          if (buckets[i] == bucket) bucketSize++;
+        if (bucketSize != size) continue;
+
+        bool placed = false;
+        for (uint16_t displacement = 1; displacement != 0 && !placed; displacement++) {
+          uint8_t slots[nrOfTokenKinds];
+          uint8_t slotsLength = 0;
+          placed = true;
+          for (uint8_t i = 0; i < keywordsLength && placed; i++) {
+            if (buckets[i] != bucket) continue;
+            uint8_t slot = keywordSlot(hashes[i], displacement);
+            placed = keywords[slot] == noKind;
+            for (uint8_t j = 0; j < slotsLength && placed; j++)
+              placed = slots[j] != slot;
+            slots[slotsLength++] = slot;
+          }
+          if (placed) {
+            keywordDisplacements[bucket] = displacement;
+            uint8_t j = 0;
+            for (uint8_t i = 0; i < keywordsLength; i++)
+              if (buckets[i] == bucket)
+                keywords[slots[j++]] = candidates[i];
+          }
+        }
+        if (!placed) {
+          ERROR_ARTI("Definition error: no perfect hash for %u keywords\n", keywordsLength);
+          errorOccurred = true;
+          return;
+        }
+      }
+    }
+  }
+
+  //token of the id at text (length characters, hash: keywordHash of them), noKind if not a keyword
+  uint8_t keyword(const char * text, uint16_t length, uint32_t hash) {
+    if (keywordsLength == 0) return noKind;
+    uint16_t displacement = keywordDisplacements[keywordSlot(hash, 0)];
+    if (displacement == 0) return noKind; //no keyword in the bucket
+    uint8_t kind = keywords[keywordSlot(hash, displacement)];
+    if (kind == noKind) return noKind;
+    const char * name = tokenNames[kind];
+    for (uint16_t i = 0; i < length; i++)
+      if (name[i] != toupper(text[i])) //also if name is shorter
+        return noKind;
+    return name[length] == '\0'?kind:noKind;
+  }
+
+  //kind of the token with name, noKind if not a token
+  uint8_t tokenKind(const char * name) {
+    for (uint8_t kind = 0; kind < tokensLength; kind++)
+      if (strcmp(tokenNames[kind], name) == 0)
+        return kind;
+    return noKind;
+  }
+
+  uint16_t add() {
+    if (elementsLength >= elementsSize) {
+      uint16_t newSize = elementsSize == 0 ? 128 : (elementsSize >= noElement / 2 ? noElement : elementsSize * 2);
+      GrammarElement *newElements = (GrammarElement *)realloc(elements, newSize * sizeof(GrammarElement));
+      if (newElements == nullptr || elementsLength >= newSize) {
+        ERROR_ARTI("Grammar: no memory for %u elements\n", newSize);
+        errorOccurred = true;
+        return noElement;
+      }
+      elements = newElements;
+      elementsSize = newSize;
+    }
+    memset(&elements[elementsLength], 0, sizeof(GrammarElement));
+    return elementsLength++;
+  }
+
+  //index of the node with name, compiled the first time, noElement if not a node
+  uint16_t node(const char * name) {
+    for (uint16_t i = 0; i < nodesLength; i++)
+      if (strcmp(nodes[i].name, name) == 0)
+        return i;
+
+    JsonVariant expression = definitionJson[name];
+    if (expression.isNull())
+      return noElement;
+
+    if (nodesLength >= nodesSize) {
+      uint16_t newSize = nodesSize == 0 ? 32 : nodesSize * 2;
+      GrammarNode *newNodes = (GrammarNode *)realloc(nodes, newSize * sizeof(GrammarNode));
+      if (newNodes == nullptr) {
+        ERROR_ARTI("Grammar: no memory for %u nodes\n", newSize);
+        errorOccurred = true;
+        return noElement;
+      }
+      nodes = newNodes;
+      nodesSize = newSize;
+    }
+
+    uint16_t node = nodesLength++;
+    nodes[node].name = name;
+    nodes[node].element = add(); //before compiling: the node can be used in its own expression
+    if (nodes[node].element != noElement)
+      compile(nodes[node].element, expression, '&', name);
+    return node;
+  }
+
+  //compiles expression into element: strings in an array are nodes or tokens, other strings tokens
+  void compile(uint16_t element, JsonVariant expression, char operatorx, const char * node_name, bool inArray = false) {
+    if (errorOccurred) return;
+
+    if (expression.is<JsonArray>()) { // e.g. ["LPAREN", "expr*", "RPAREN"]
+      JsonArray array = expression.as<JsonArray>();
+      uint16_t first = elementsLength;
+      for (uint8_t i = 0; i < array.size(); i++) //the elements of an array are consecutive
+        add();
+      elements[element].type = G_Sequence;
+      elements[element].operatorx = operatorx;
+      elements[element].index = first;
+      elements[element].length = array.size();
+      uint8_t i = 0;
+      for (JsonVariant arrayElement: array)
+        compile(first + i++, arrayElement, '&', node_name, true);
+    }
+    else if (expression.is<JsonObject>()) { // e.g. {"?":["LPAREN","formals*","RPAREN"]}
+      JsonObject::iterator objectIterator = expression.as<JsonObject>().begin();
+      char objectOperator = objectIterator->key().c_str()[0];
+      JsonVariant objectElement = objectIterator->value();
+
+      if (!objectElement.is<JsonArray>()) {
+        ERROR_ARTI("Definition error: should be an array %s %c %s\n", stringOrEmpty(node_name), objectOperator, objectElement.as<std::string>().c_str());
+        errorOccurred = true;
+      }
+      else if (objectOperator != '?' && objectOperator != '*' && objectOperator != '+' && objectOperator != '|') {
+        ERROR_ARTI("Definition error: undefined %c in %s\n", objectOperator, stringOrEmpty(node_name));
+        errorOccurred = true;
+      }
+      else {
+        uint16_t array = add();
+        elements[element].type = G_Object;
+        elements[element].operatorx = objectOperator;
+        elements[element].index = array;
+        if (array != noElement)
+          compile(array, objectElement, objectOperator, node_name);
+      }
+    }
+    else {
+      const char * name = expression.as<const char *>();
+      uint16_t node = (inArray && name != nullptr)?this->node(name):noElement; //e.g. block
+      uint8_t kind = name != nullptr?tokenKind(name):noKind; // e.g. "ID"
+      if (node != noElement) {
+        elements[element].type = G_Node;
+        elements[element].index = node;
+      }
+      else if (kind != noKind) {
+        elements[element].type = G_Token;
+        elements[element].index = kind;
+      }
+      else if (!errorOccurred) {
+        if (name != nullptr && definitionJson.containsKey(name))
+          ERROR_ARTI("Definition error: \"%s\": \"%s\" node should be embedded in array\n", stringOrEmpty(node_name), name);
+        else
+          ERROR_ARTI("Definition error: %s not a node, token, array or object in %s\n", expression.as<std::string>().c_str(), stringOrEmpty(node_name));
+        errorOccurred = true;
+      }
+    }
+  }
+
+  //compiles the nodes used by startNode and the FIRST sets of their elements, returns the index of startNode
+  uint16_t compile(const char * startNode) {
+    uint16_t start = node(startNode);
+    if (start == noElement) {
+      ERROR_ARTI("Definition error: start node %s not found\n", startNode);
+      errorOccurred = true;
+    }
+    if (errorOccurred) return noElement;
+
+    //FIRST sets and nullable: repeat until nothing changes as nodes can use each other
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (uint16_t i = 0; i < elementsLength; i++) {
+        GrammarElement *element = &elements[i];
+        uint64_t first = 0;
+        bool nullable = false;
+        switch (element->type) {
+          case G_Token:
+            first = (uint64_t)1 << element->index;
+            break;
+          case G_Node:
+            first = elements[nodes[element->index].element].first;
+            nullable = elements[nodes[element->index].element].nullable;
+            break;
+          case G_Sequence:
+            nullable = element->operatorx != '|';
+            for (uint16_t j = element->index; j < element->index + element->length; j++) {
+              first |= elements[j].first;
+              if (element->operatorx == '|')
+                nullable = nullable || elements[j].nullable;
+              else if (!elements[j].nullable) { //the next elements do not start the sequence
+                nullable = false;
+                break;
+              }
+            }
+            break;
+          case G_Object:
+            first = elements[element->index].first;
+            nullable = element->operatorx == '?' || element->operatorx == '*' || elements[element->index].nullable;
+            break;
+        }
+        if (first != element->first || nullable != element->nullable) {
+          element->first = first;
+          element->nullable = nullable;
+          changed = true;
+        }
+      }
+    }
+
+    MEMORY_ARTI("Grammar %u nodes %u elements %u tokens (%u bytes)\n", nodesLength, elementsLength, tokensLength, (unsigned int)(nodesLength * sizeof(GrammarNode) + elementsLength * sizeof(GrammarElement)));
+
+    return start;
+  }
+
+  //false if element fails on a token of kind without trying it
+  bool canStart(uint16_t element, uint8_t kind) {
+    return elements[element].nullable || (kind < nrOfTokenKinds && (elements[element].first >> kind & 1));
+  }
+
+}; //Grammar
+
+//token of the program, see Lexer::tokenize
+struct Token {
+  uint16_t pos; //of the first character in the program
+  uint16_t length; //characters
   uint16_t lineno;
   uint16_t column;
-  char type[charLength];
-  char value[charLength];
+  uint8_t kind; //index of the tokens of the grammar, endKind: end of the program
+  uint8_t match; //token of the grammar found for keywords and operators, noKind for ids and numbers
 };
 
-#define nrOfPositions 20
-
 class Lexer {
   private:
   public:
     const char * text;
+    uint16_t length; //of text
     uint16_t pos;
     char current_char;
     uint16_t lineno;
     uint16_t column;
-    JsonObject definitionJson;
-    Token current_token;
-    LexerPosition positions[nrOfPositions]; //should be array of pointers but for some reason get seg fault (because a struct and not a class...)
-    uint8_t positions_index = 0;
+    Grammar *grammar;
+    Token *tokens = nullptr; //made by tokenize
+    uint16_t tokensLength = 0;
+    uint16_t tokensSize = 0;
+    uint16_t token = 0; //current token of the parser: backtracking sets it back
 
-  Lexer(const char * programText, JsonObject definitionJson) {
+  Lexer(const char * programText, Grammar *grammar) {
     this->text = programText;
-    this->definitionJson = definitionJson;
+    this->length = strlen(programText);
+    this->grammar = grammar;
     this->pos = 0;
-    this->current_char = this->text[this->pos];
+    this->current_char = this->length > 0?this->text[this->pos]:-1;
     this->lineno = 1;
     this->column = 1;
   }
 
   ~Lexer() {
+    free(tokens);
     DEBUG_ARTI("Destruct Lexer\n");
   }
 
@@ -541,7 +975,7 @@ class Lexer {
     }
     this->pos++;
 
-    if (this->pos > strlen(this->text) - 1)
+    if (this->pos >= this->length)
       this->current_char = -1;
     else 
     {
@@ -558,90 +992,62 @@ class Lexer {
 
   void skip_comment(const char * endTokens) 
   {
-    while (strncmp(this->text + this->pos, endTokens, strlen(endTokens)) != 0)
+    size_t endLength = strlen(endTokens);
+    while (this->current_char != -1 && strncmp(this->text + this->pos, endTokens, endLength) != 0)
       this->advance();
-    for (int i=0; i<strlen(endTokens); i++)
+    for (size_t i=0; i<endLength; i++)
       this->advance();
   }
 
-  void number() 
+  void number(Token *token) 
   {
-    current_token.lineno = this->lineno;
-    current_token.column = this->column;
-    strcpy(current_token.type, "");
-    strcpy(current_token.value, "");
-
-    char result[charLength] = "";
     while (this->current_char != -1 && isdigit(this->current_char)) 
-    {
-      result[strlen(result)] = this->current_char;
       this->advance();
-    }
+
     if (this->current_char == '.') 
     {
-      result[strlen(result)] = this->current_char;
       this->advance();
 
       while (this->current_char != -1 && isdigit(this->current_char)) 
-      {
-        result[strlen(result)] = this->current_char;
         this->advance();
-      }
 
-      result[strlen(result)] = '\0';
-      strcpy(current_token.type, "REAL_CONST");
-      strcpy(current_token.value, result);
+      token->kind = grammar->realKind;
     }
     else 
-    {
-      result[strlen(result)] = '\0';
-      strcpy(current_token.type, "INTEGER_CONST");
-      strcpy(current_token.value, result);
-    }
-
+      token->kind = grammar->integerKind;
   }
 
-  void id() 
+  void id(Token *token) 
   {
-    current_token.lineno = this->lineno;
-    current_token.column = this->column;
-    strcpy(current_token.type, "");
-    strcpy(current_token.value, "");
-
-    char result[charLength] = "";
+    uint32_t hash = Grammar::keywordHash();
     while (this->current_char != -1 && (isalnum(this->current_char) || this->current_char == '_')) 
     {
-        result[strlen(result)] = this->current_char;
+        hash = Grammar::keywordHash(hash, this->current_char);
         this->advance();
     }
-    result[strlen(result)] = '\0';
-
-    char resultUpper[charLength];
-    strcpy(resultUpper, result);
-    strupr(resultUpper);
 
-    if (definitionJson["TOKENS"].containsKey(resultUpper)) 
+    uint8_t kind = grammar->keyword(this->text + token->pos, this->pos - token->pos, hash);
+    if (kind != noKind && grammar->tokenTypes[kind] == noKind) //e.g. plus: its value + is no token name
     {
-      strcpy(current_token.type, definitionJson["TOKENS"][resultUpper]);
-      strcpy(current_token.value, resultUpper);
+      ERROR_ARTI("Lexer error: %.*s is not a keyword line %u col %u\n", this->pos - token->pos, this->text + token->pos, token->lineno, token->column);
+      errorOccurred = true;
     }
-    else 
+    else if (kind != noKind) 
     {
-      strcpy(current_token.type, "ID");
-      strcpy(current_token.value, result);
+      token->kind = grammar->tokenTypes[kind];
+      token->match = kind;
     }
+    else
+      token->kind = grammar->idKind;
   }
 
-  void get_next_token() 
+  //next token of the program in token, kind endKind if the end of the program
+  void get_next_token(Token *token) 
   {
-    current_token.lineno = this->lineno;
-    current_token.column = this->column;
-    strcpy(current_token.type, "");
-    strcpy(current_token.value, "");
-
-    if (errorOccurred) return;
+    token->kind = endKind;
+    token->match = noKind;
 
-    while (this->current_char != -1 && this->pos <= strlen(this->text) - 1 && !errorOccurred) 
+    while (this->current_char != -1 && this->pos < this->length && !errorOccurred) 
     {
       if (isspace(this->current_char)) {
         this->skip_whitespace();
@@ -662,89 +1068,89 @@ class Lexer {
         continue;
       }
 
-      if (isalpha(this->current_char)) 
-      {
-        this->id();
-        return;
-      }
-      
-      if (isdigit(this->current_char) || (this->current_char == '.' && isdigit(this->text[this->pos+1])))
-      {
-        this->number();
-        return;
-      }
-
-      // findLongestMatchingToken
-      char token_type[charLength] = "";
-      char token_value[charLength] = "";
+      break;
+    }
 
-      uint8_t longestTokenLength = 0;
+    token->pos = this->pos;
+    token->lineno = this->lineno;
+    token->column = this->column;
 
-      for (JsonPair tokenPair: definitionJson["TOKENS"].as<JsonObject>()) {
-        const char * value = tokenPair.value();
-        char currentValue[charLength];
-        strncpy(currentValue, this->text + this->pos, charLength);
-        currentValue[strlen(value)] = '\0';
-        if (strcmp(value, currentValue) == 0 && strlen(value) > longestTokenLength) {
-          strcpy(token_type, tokenPair.key().c_str());
-          strcpy(token_value, value);
-          longestTokenLength = strlen(value);
-        }
-      }
+    if (this->current_char == -1 || this->pos >= this->length || errorOccurred)
+      ;
+    else if (isalpha(this->current_char)) 
+      this->id(token);
+    else if (isdigit(this->current_char) || (this->current_char == '.' && isdigit(this->text[this->pos+1])))
+      this->number(token);
+    else
+    {
+      // findLongestMatchingToken
+      uint8_t tokenLength;
+      uint8_t kind = grammar->matchToken(this->text + this->pos, &tokenLength);
 
-      if (strcmp(token_type, "") != 0 && strcmp(token_value, "") != 0) 
+      if (kind != noKind) 
       {
-        strcpy(current_token.type, token_type);
-        strcpy(current_token.value, token_value);
-        for (int i=0; i<strlen(token_value); i++)
+        token->kind = kind;
+        token->match = kind;
+        for (uint8_t i=0; i<tokenLength; i++)
           this->advance();
-        return;
       }
       else {
         ERROR_ARTI("Lexer error on %c line %u col %u\n", this->current_char, this->lineno, this->column);
         errorOccurred = true;
       }
     }
+
+    token->length = this->pos - token->pos;
   } //get_next_token
 
-  void eat(const char * token_type) {
-    // DEBUG_ARTI("try to eat %s %s\n", lexer->current_token.type, token_type);
-    if (strcmp(current_token.type, token_type) == 0) {
-      get_next_token();
-      // DEBUG_ARTI("eating %s -> %s %s\n", token_type, lexer->current_token.type, lexer->current_token.value);
-    }
-    else {
-      ERROR_ARTI("Lexer Error: Unexpected token %s %s\n", current_token.type, current_token.value);
-      errorOccurred = true;
-    }
+  //lexes the program once into tokens, the last token is the end of the program (endKind), false if lexer error
+  bool tokenize() {
+    Token *token;
+    do {
+      if (tokensLength >= tokensSize) {
+        uint16_t newSize = tokensSize == 0 ? 256 : (tokensSize >= noElement / 2 ? noElement : tokensSize * 2);
+        Token *newTokens = (Token *)realloc(tokens, newSize * sizeof(Token));
+        if (newTokens == nullptr || tokensLength >= newSize) {
+          ERROR_ARTI("Lexer: no memory for %u tokens\n", newSize);
+          errorOccurred = true;
+          return false;
+        }
+        tokens = newTokens;
+        tokensSize = newSize;
+      }
+      token = &tokens[tokensLength++];
+      get_next_token(token);
+    } while (token->kind != endKind && !errorOccurred);
+
+    MEMORY_ARTI("Lexer %u tokens (%u bytes)\n", tokensLength, (unsigned int)(tokensLength * sizeof(Token)));
+
+    return !errorOccurred;
   }
 
-  void push_position() {
-    if (positions_index < nrOfPositions) {
-      positions[positions_index].pos = this->pos;
-      positions[positions_index].current_char = this->current_char;
-      positions[positions_index].lineno = this->lineno;
-      positions[positions_index].column = this->column;
-      strcpy(positions[positions_index].type, current_token.type);
-      strcpy(positions[positions_index].value, current_token.value);
-      positions_index++;
-    }
+  Token *current_token() {
+    return &tokens[token];
+  }
+
+  //value of the current token in the parse tree (copied by ArduinoJson): an uppercase keyword, an operator or the text of ids and numbers
+  std::string value() {
+    Token *current = current_token();
+    if (current->match == noKind)
+      return std::string(this->text + current->pos, current->length);
+    else if (isalpha(this->text[current->pos]))
+      return grammar->tokenNames[current->match];
     else
-      ERROR_ARTI("not enough positions %u\n", nrOfPositions);
+      return grammar->tokenValues[current->match];
   }
 
-  void pop_position() {
-    if (positions_index > 0) {
-      positions_index--;
-      this->pos = positions[positions_index].pos;
-      this->current_char = positions[positions_index].current_char;
-      this->lineno = positions[positions_index].lineno;
-      this->column = positions[positions_index].column;
-      strcpy(current_token.type, positions[positions_index].type);
-      strcpy(current_token.value, positions[positions_index].value);
+  void eat(uint8_t kind) {
+    // DEBUG_ARTI("try to eat %s %s\n", grammar->tokenNames[current_token()->kind], grammar->tokenNames[kind]);
+    if (current_token()->kind == kind) {
+      token++;
+    }
+    else {
+      ERROR_ARTI("Lexer Error: Unexpected token %.*s line %u col %u\n", current_token()->length, this->text + current_token()->pos, current_token()->lineno, current_token()->column);
+      errorOccurred = true;
     }
-    else
-      ERROR_ARTI("no positions saved\n");
   }
 
 }; //Lexer
@@ -755,29 +1161,36 @@ class Lexer {
 
 class ScopedSymbolTable; //forward declaration
 
+struct Closure;
+
+#define noNode 65535
+
 class Symbol {
   private:
   public:
   
   uint8_t symbol_type;
-  char name[charLength];
+  char * name; //any length, see Lexer::id
   uint8_t type;
   uint8_t scope_level;
   uint8_t scope_index;
   ScopedSymbolTable* scope = nullptr;
   ScopedSymbolTable* function_scope = nullptr; //used to find the formal parameters in the scope of a function node
 
-  JsonVariant block;
+  uint16_t block_node = noNode; //block of the function in the syntax tree (see buildSyntaxTree)
+  uint16_t code_entry = 0; //start of the function in the bytecode (see compile)
+  Closure *closure = nullptr; //block of the function (see buildClosures)
 
   Symbol(uint8_t symbol_type, const char * name, uint8_t type = 9) {
     this->symbol_type = symbol_type;
-    strcpy(this->name, name);
+    this->name = strdup(name);
     this->type = type;
     this->scope_level = 0;
   }
 
   ~Symbol() {
     MEMORY_ARTI("Destruct Symbol %s (%u)\n", name, FREE_SIZE);
+    free(name); name = nullptr;
   }
 
 }; //Symbol
@@ -792,14 +1205,14 @@ class ScopedSymbolTable {
   Symbol* symbols[nrOfSymbolsPerScope];
   uint8_t symbolsIndex = 0;
   uint8_t nrOfFormals = 0;
-  char scope_name[charLength];
+  char * scope_name; //any length, see Lexer::id
   uint8_t scope_level;
   ScopedSymbolTable *enclosing_scope;
   ScopedSymbolTable *child_scopes[nrOfChildScope];
   uint8_t child_scopesIndex = 0;
 
   ScopedSymbolTable(const char * scope_name, int scope_level, ScopedSymbolTable *enclosing_scope = nullptr) {
-    strcpy(this->scope_name, scope_name);
+    this->scope_name = strdup(scope_name);
     this->scope_level = scope_level;
     this->enclosing_scope = enclosing_scope;
   }
@@ -812,6 +1225,7 @@ class ScopedSymbolTable {
       delete symbols[i]; symbols[i] = nullptr;
     }
     MEMORY_ARTI("Destruct ScopedSymbolTable %s (%u)\n", scope_name, FREE_SIZE);
+    free(scope_name); scope_name = nullptr;
   }
 
   void init_builtins() {
@@ -849,39 +1263,39 @@ class ScopedSymbolTable {
     return nullptr;
   } //lookup
 
+  //floats of an activation record of the scope: a variable is at its scope_index, at least one for variables not found (level 0, see ARTI::activationRecord)
+  uint8_t recordSize()
+  {
+    return symbolsIndex > 0?symbolsIndex:1;
+  }
+
+  //largest recordSize of this scope and the scopes in it
+  uint8_t maxRecordSize()
+  {
+    uint8_t result = recordSize();
+    for (uint8_t i=0; i<child_scopesIndex; i++)
+    {
+      uint8_t size = child_scopes[i]->maxRecordSize();
+      if (size > result)
+        result = size;
+    }
+    return result;
+  }
+
 }; //ScopedSymbolTable
 
 #define nrOfVariables 20
 
+//the variables of a call, allocated by CallStack::allocate
 class ActivationRecord 
 {
   private:
   public:
-    char name[charLength];
-    char type[charLength];
+    const char *name; //of the function or program, not copied: symbols live as long as the program
     int nesting_level;
-    // char charMembers[charLength][nrOfVariables];
-    float floatMembers[nrOfVariables];
-    char lastSet[charLength];
-    uint8_t lastSetIndex;
-
-    ActivationRecord(const char * name, const char * type, int nesting_level) 
-    {
-        strcpy(this->name, name);
-        strcpy(this->type, type);
-        this->nesting_level = nesting_level;
-    }
-
-    ~ActivationRecord() 
-    {
-      RUNLOG_ARTI("Destruct activation record %s\n", name);
-    }
-
-    // void set(uint8_t index,  const char * value) 
-    // {
-    //   lastSetIndex = index;
-    //   strcpy(charMembers[index], value);
-    // }
+    float *floatMembers = nullptr; //in the arena of the CallStack
+    uint8_t size = 0; //number of floatMembers
+    uint8_t lastSetIndex = 0;
 
     void set(uint8_t index, float value) 
     {
@@ -889,11 +1303,6 @@ class ActivationRecord
       floatMembers[index] = value;
     }
 
-    // const char * getChar(uint8_t index) 
-    // {
-    //   return charMembers[index];
-    // }
-
     float getFloat(uint8_t index) 
     {
       return floatMembers[index];
@@ -903,19 +1312,69 @@ class ActivationRecord
 
 #define nrOfRecords 20
 
+//records of the calls: allocated from preallocated frames and an arena of floats, so calls and returns do not use the heap
 class CallStack {
 public:
-  ActivationRecord* records[nrOfRecords];
+  ActivationRecord* records[nrOfRecords]; //pushed records
   uint8_t recordsCounter = 0;
-
-  CallStack() {
+  ActivationRecord frames[nrOfRecords]; //allocated records, released in reverse order
+  uint8_t framesCounter = 0;
+  float *arena = nullptr; //floatMembers of the allocated records
+  uint16_t arenaLength = 0;
+  uint16_t arenaIndex = 0; //first free float
+
+  //arenaLength: floats of the records of the deepest calls, see ARTI::arenaLength
+  CallStack(uint16_t arenaLength) 
+  {
+    arena = (float *)malloc(arenaLength * sizeof(float));
+    if (arena == nullptr && arenaLength > 0)
+    {
+      ERROR_ARTI("CallStack: no memory for %u variables\n", arenaLength);
+      errorOccurred = true;
+    }
+    else
+      this->arenaLength = arenaLength;
   }
 
   ~CallStack() 
   {
+    free(arena);
     RUNLOG_ARTI("Destruct callstack\n");
   }
 
+  //a record of size variables, undefined variables read as 0. nullptr if no space left
+  ActivationRecord* allocate(const char * name, int nesting_level, uint8_t size)
+  {
+    if (framesCounter >= nrOfRecords || arenaIndex + size > arenaLength)
+    {
+      errorOccurred = true;
+      ERROR_ARTI("no space left for activation record %s (%u of %u)\n", name, arenaIndex, arenaLength);
+      return nullptr;
+    }
+    ActivationRecord* ar = &frames[framesCounter++];
+    ar->name = name;
+    ar->nesting_level = nesting_level;
+    ar->floatMembers = arena + arenaIndex;
+    ar->size = size;
+    ar->lastSetIndex = 0;
+    memset(ar->floatMembers, 0, size * sizeof(float));
+    arenaIndex += size;
+    return ar;
+  }
+
+  //the last allocated record
+  void release(ActivationRecord* ar)
+  {
+    if (framesCounter == 0 || ar != &frames[framesCounter - 1])
+    {
+      ERROR_ARTI("Programming error: activation record %s not released last\n", ar->name);
+      errorOccurred = true;
+      return;
+    }
+    framesCounter--;
+    arenaIndex = ar->floatMembers - arena;
+  }
+
   void push(ActivationRecord* ar) 
   {
     if (recordsCounter < nrOfRecords) 
@@ -935,7 +1394,7 @@ public:
     if (recordsCounter > 0)
     {
       // RUNLOG_ARTI("%s\n", "Pop ", this->peek()->name);
-      return this->records[recordsCounter--];
+      return this->records[--recordsCounter];
     }
     else 
     {
@@ -948,6 +1407,15 @@ public:
   {
     return this->records[recordsCounter-1];
   }
+
+  //the last pushed record of nesting_level: a function can be called by a function of the same or a deeper level, so not always the record below the caller
+  ActivationRecord* find(int nesting_level)
+  {
+    for (uint8_t i = recordsCounter; i > 0; i--)
+      if (records[i-1]->nesting_level == nesting_level)
+        return records[i-1];
+    return nullptr;
+  }
 }; //CallStack
 
 class ValueStack 
@@ -1035,1387 +1503,7359 @@ public:
 
 }; //ValueStack
 
-#define programTextSize 5000
+#define noExternal 255
+
+//node of the syntax tree, children and siblings are indices in the nodes of the SyntaxTree
+struct Node {
+  uint8_t kind; //Nodes
+  uint8_t token; //F_Operator: operator, F_Assign: assignoperator
+  uint8_t level; //F_VarRef, F_Assign: variable
+  uint8_t index; //F_VarRef, F_Assign: variable, F_Operator: number of operands (1: unary minus)
+  uint8_t external; //F_Call, F_VarRef, F_Assign: external function or variable, noExternal if not
+  uint16_t child; //first child
+  uint16_t next; //next sibling
+  union {
+    float value; //F_Constant
+    Symbol *symbol; //F_Function, F_Call: function
+  };
+};
 
-class ARTI {
+// Children of the nodes (F_List unless mentioned):
+// program: block
+// function: block
+// call: actuals
+// varref: indices
+// assign: indices, expr
+// expr, term: values (constant, varref, call, expr, term, cex) and operators in postfix order (see buildPostfix)
+// operator: && and ||: the right operand (value and unary minuses, not a list), only evaluated if needed
+// for: assign, expr, block, increment
+// if: expr, block, elseBlock
+// cex: expr, trueExpr, falseExpr
+
+//the analyzed program in a contiguous array of nodes, see buildSyntaxTree
+class SyntaxTree
+{
 private:
-  Lexer *lexer = nullptr;
-
-  DynamicJsonDocument *definitionJsonDoc = nullptr;
-  DynamicJsonDocument *parseTreeJsonDoc = nullptr;
-  JsonObject definitionJson;
-  JsonVariant parseTreeJson;
-
-  ScopedSymbolTable *global_scope = nullptr;
-  CallStack *callStack = nullptr;
-  ValueStack *valueStack = nullptr;
-
-  uint8_t stages = 5; //for debugging: 0:parseFile, 1:Lexer, 2:parse, 3:optimize, 4:analyze, 5:interpret should be 5 if no debugging
-
-  char logFileName[fileNameLength];
-
-  uint32_t startMillis;
-
 public:
-  ARTI() 
+  Node *nodes = nullptr;
+  uint16_t nodesIndex = 0;
+  uint16_t nodesSize = 0;
+
+  SyntaxTree()
   {
-    // MEMORY_ARTI("new Arti < %u\n", FREE_SIZE); //logfile not open here
   }
 
-  ~ARTI() 
+  ~SyntaxTree()
   {
-    MEMORY_ARTI("Destruct ARTI\n");
+    free(nodes);
+    MEMORY_ARTI("Destruct SyntaxTree (%u)\n", FREE_SIZE);
   }
 
-  //defined in arti_definition.h e.g. arti_wled.h!
-  float arti_external_function(uint8_t function, float par1 = floatNull, float par2 = floatNull, float par3 = floatNull, float par4 = floatNull, float par5 = floatNull);
-  float arti_get_external_variable(uint8_t variable, float par1 = floatNull, float par2 = floatNull, float par3 = floatNull);
-  void arti_set_external_variable(float value, uint8_t variable, float par1 = floatNull, float par2 = floatNull, float par3 = floatNull);
-  bool loop(); 
-  
-  uint8_t parse(JsonVariant parseTree, const char * node_name, char operatorx, JsonVariant expression, uint8_t depth = 0) 
+  uint16_t add(uint8_t kind)
   {
-    if (depth > 50) 
+    if (nodesIndex >= nodesSize)
     {
-      ERROR_ARTI("Error: Parse recursion level too deep at %s (%u)\n", parseTree.as<std::string>().c_str(), depth);
-      errorOccurred = true;
+      uint16_t newSize = nodesSize == 0 ? 64 : (nodesSize >= noNode / 2 ? noNode : nodesSize * 2);
+      Node *newNodes = (Node *)realloc(nodes, newSize * sizeof(Node));
+      if (newNodes == nullptr || nodesIndex >= newSize)
+      {
+        ERROR_ARTI("SyntaxTree: no memory for %u nodes\n", newSize);
+        errorOccurred = true;
+        return noNode;
+      }
+      nodes = newNodes;
+      nodesSize = newSize;
     }
-    if (errorOccurred) return ResultFail;
 
-    uint8_t result = ResultContinue;
+    Node *node = &nodes[nodesIndex];
+    memset(node, 0, sizeof(Node));
+    node->kind = kind;
+    node->token = F_NoToken;
+    node->external = noExternal;
+    node->child = noNode;
+    node->next = noNode;
+    return nodesIndex++;
+  }
 
-    uint8_t resultChild = ResultContinue;
+  //child number i of node, noNode if not existing
+  uint16_t child(uint16_t node, uint8_t i = 0)
+  {
+    uint16_t child = nodes[node].child;
+    for (; i > 0 && child != noNode; i--)
+      child = nodes[child].next;
+    return child;
+  }
+
+  uint16_t lastChild(uint16_t node)
+  {
+    uint16_t child = nodes[node].child;
+    while (child != noNode && nodes[child].next != noNode)
+      child = nodes[child].next;
+    return child;
+  }
 
-    if (expression.is<JsonArray>()) //should always be the case
+  void dump(uint16_t node, uint8_t depth = 0)
+  {
+    for (; node != noNode && depth < 50; node = nodes[node].next)
     {
-      for (JsonVariant expressionElement: expression.as<JsonArray>()) //e.g. ["PROGRAM","ID","block"]
+      Node *n = &nodes[node];
+      DEBUG_ARTI("%s%u %s", spaces+50-depth, node, nodeToString(n->kind));
+      switch (n->kind)
       {
-        const char * nextNode_name = node_name; //e.g. "program": 
-        JsonVariant nextExpression = expressionElement; // e.g. block
-        JsonVariant nextParseTree = parseTree;
+        case F_Constant:
+          DEBUG_ARTI(" %f", n->value);
+          break;
+        case F_Operator:
+          DEBUG_ARTI(" %s%s", n->index == 1?"unary ":"", tokenToString(n->token));
+          break;
+        case F_Function:
+        case F_Call:
+          if (n->external != noExternal)
+            DEBUG_ARTI(" e%u", n->external);
+          else
+            DEBUG_ARTI(" %s", n->symbol->name);
+          break;
+        case F_VarRef:
+        case F_Assign:
+          if (n->external != noExternal)
+            DEBUG_ARTI(" e%u", n->external);
+          else
+            DEBUG_ARTI(" v%u.%u", n->level, n->index);
+          if (n->token != F_NoToken)
+            DEBUG_ARTI(" %s=", tokenToString(n->token));
+          break;
+      }
+      DEBUG_ARTI("\n");
+      dump(n->child, depth + 1);
+    }
+  }
 
-        JsonVariant nodeExpression = lexer->definitionJson[expressionElement.as<const char *>()];
+}; //SyntaxTree
 
-        if (!nodeExpression.isNull()) //is expressionElement a Node e.g. "block" : ["LCURL",{"*": ["statement"]},"RCURL"]
-        {
-          nextNode_name = expressionElement; //e.g. block
-          nextExpression = nodeExpression; // e.g. ["LCURL",{"*": ["statement"]},"RCURL"]
+enum Engines
+{
+  E_TreeWalker, //interpret walks the json parseTree
+  E_StackVM,    //compile lowers the parseTree to bytecode, execute runs it
+  E_RegisterVM, //the bytecode is translated to register code, executeRegisters runs it
+  E_Closures,   //buildClosures binds each node to a function, runClosures calls them (no code buffer)
+  E_JIT         //the register code is translated to machine code (ARTI_JIT hosts only, else E_RegisterVM)
+};
 
-          // DEBUG_ARTI("%s %s %u\n", spaces+50-depth, nextNode_name, depth); //, parseTree.as<std::string>().c_str()
+#ifndef ARTI_ENGINE
+  #define ARTI_ENGINE E_RegisterVM
+#endif
 
-          if (parseTree.is<JsonArray>()) 
-          {
-            parseTree[parseTree.size()][nextNode_name]["connect"] = "array";
-            nextParseTree = parseTree[parseTree.size()-1]; //nextparsetree is last element in the array (which is always an object)
-          }
-          else //no list, create object
-          { 
-            if (parseTree[node_name].isNull()) //no object yet
-              parseTree[node_name]["connect"] = "object"; //make the connection, new object item
+enum OpCodes
+{
+  O_Halt,        //end of main program
+  O_Return,      //end of function
+  O_Const,       //float: push constant
+  O_Load,        //level, index: push variable
+  O_Store,       //level, index, assignoperator: pop value into variable
+  O_LoadExt,     //external, nrOfIndices: pop indices, push external variable
+  O_LoadUniform, //uniform: push external variable of this frame, see ARTI::snapshotUniforms
+  O_StoreExt,    //external, nrOfIndices: pop indices and value, set external variable
+  O_CallExt,     //external, nrOfArgs, keep: pop arguments, call external function, push result if keep
+  O_Call,        //function: pop actuals, run function
+  O_Pop,         //count
+  O_Jump,        //address
+  O_JumpIfNot,   //address: pop condition, jump if not 1
+  O_ForLoop,     //address: check and increment iteration counter on top of stack
+  O_ForCond,     //address: pop condition, push loop mode or jump to end of loop
+  O_ForNext,     //address: pop loop mode, pascal mode: increment loop variable and jump to address
+  O_Neg,
+  O_Add,
+  O_Sub,
+  O_Mul,
+  O_Div,
+  O_Mod,
+  O_Shl,
+  O_Shr,
+  O_Eq,
+  O_Ne,
+  O_Lt,
+  O_Le,
+  O_Gt,
+  O_Ge,
+  O_And,
+  O_Or,
+  O_NoOpCode = 255
+};
 
-            nextParseTree = parseTree[node_name];
-          }
-        }
+const char * opCodeToString(uint8_t opCode)
+{
+  switch (opCode) {
+  case O_Halt:
+    return "halt";
+  case O_Return:
+    return "return";
+  case O_Const:
+    return "const";
+  case O_Load:
+    return "load";
+  case O_Store:
+    return "store";
+  case O_LoadExt:
+    return "loadext";
+  case O_LoadUniform:
+    return "loaduniform";
+  case O_StoreExt:
+    return "storeext";
+  case O_CallExt:
+    return "callext";
+  case O_Call:
+    return "call";
+  case O_Pop:
+    return "pop";
+  case O_Jump:
+    return "jump";
+  case O_JumpIfNot:
+    return "jumpifnot";
+  case O_ForLoop:
+    return "forloop";
+  case O_ForCond:
+    return "forcond";
+  case O_ForNext:
+    return "fornext";
+  case O_Neg:
+    return "neg";
+  }
+  if (opCode >= O_Add && opCode <= O_Or)
+    return tokenToString(opCode - O_Add + F_plus);
+  return "unknown opcode";
+}
 
-        if (operatorx == '|')
-          lexer->push_position();
+//binary operators in the same order as the Tokens enum
+uint8_t tokenToOpCode(uint8_t token)
+{
+  if (token >= F_plus && token <= F_or)
+    return token - F_plus + O_Add;
+  return O_NoOpCode;
+}
 
-        if (nextExpression.is<JsonObject>()) // e.g. {"?":["LPAREN","formals*","RPAREN"]}
-        {
-          JsonObject::iterator objectIterator = nextExpression.as<JsonObject>().begin();
-          char objectOperator = objectIterator->key().c_str()[0];
-          JsonVariant objectElement = objectIterator->value();
+#define nrOfFunctions 20
+#define maxForIterations 2000
 
-          if (objectElement.is<JsonArray>()) 
-          {
-            if (objectOperator == '*' || objectOperator == '+') 
-            {
-              nextParseTree[nextNode_name]["*"][0] = "multiple"; // * is another object in the list of objects
-              nextParseTree = nextParseTree[nextNode_name]["*"];
-            }
+//division and modulo like interpret, also used by transpiled programs (see ARTI::transpile)
+float artiDivision(float left, float right)
+{
+  if (right == 0)
+  {
+    right = 1;
+    ERROR_ARTI("division by 0 not possible, divisor ignored for %f\n", left);
+  }
+  return left / right;
+}
 
-            //and: see 'is array'
-            if (objectOperator == '|') 
-            {
-              resultChild = parse(nextParseTree, nextNode_name, objectOperator, objectElement, depth + 1);
-              if (resultChild != ResultFail) resultChild = ResultContinue;
-            }
-            else 
-            {
-              uint8_t resultChild2 = ResultContinue;
-              uint8_t counter = 0;
-              while (resultChild2 == ResultContinue) 
-              {
-                resultChild2 = parse(nextParseTree, nextNode_name, objectOperator, objectElement, depth + 1); //no assign to result as optional
+float artiModulo(float left, float right)
+{
+  if (right == 0) {
+    ERROR_ARTI("mod 0 not possible, mod ignored %f\n", left);
+    return left;
+  }
+  return fmod(left, right);
+}
 
-                if (objectOperator == '?') { //zero or one iteration, also continue if parse not continue
-                  resultChild2 = ResultContinue;
-                  break; 
-                }
-                else if (objectOperator == '+') { //one or more iterations, stop if first parse not continue
-                  if (counter == 0) {
-                    if (resultChild2 != ResultContinue)
-                      break;
-                  } 
-                  else 
-                  {
-                    if (resultChild2 != ResultContinue) 
-                    {
-                      resultChild2 = ResultContinue;  //always continue
-                      break;
-                    }
-                  }
-                }
-                else if (objectOperator == '*') //zero or more iterations, stop if parse not continue
-                {
-                  if (resultChild2 != ResultContinue) 
-                  {
-                    resultChild2 = ResultContinue;  //always continue
-                    break;
-                  }
-                }
-                else 
-                {
-                  ERROR_ARTI("%s Programming error: undefined %c %s\n", spaces+50-depth, objectOperator, objectElement.as<std::string>().c_str());
-                  resultChild2 = ResultFail;
-                }
-                counter++;
-              } //while
-              resultChild = resultChild2;
-            } //not or
-          } // element is array
-          else
-            ERROR_ARTI("%s Definition error: should be an array %s %c %s\n", spaces+50-depth, stringOrEmpty(nextNode_name), operatorx, objectElement.as<std::string>().c_str());
-        }
-        else if (nextExpression.is<JsonArray>()) // e.g. ["LPAREN", "expr*", "RPAREN"]
+class ByteCode
+{
+private:
+public:
+  uint8_t *code = nullptr;
+  uint16_t size = 0; //allocated bytes
+  uint16_t length = 0; //used bytes
+  Symbol* functions[nrOfFunctions]; //called functions, referenced by index in O_Call
+  uint8_t functionsIndex = 0;
+  uint8_t stackDepth = 0; //tracked while compiling
+  uint8_t maxStackDepth = 0;
+
+  ByteCode()
+  {
+  }
+
+  ~ByteCode()
+  {
+    free(code);
+    MEMORY_ARTI("Destruct ByteCode (%u)\n", FREE_SIZE);
+  }
+
+  void emit(uint8_t byte)
+  {
+    if (length >= size)
+    {
+      uint16_t newSize = size == 0 ? 256 : size * 2;
+      uint8_t *newCode = (uint8_t *)realloc(code, newSize);
+      if (newCode == nullptr)
+      {
+        ERROR_ARTI("ByteCode: no memory for %u bytes\n", newSize);
+        errorOccurred = true;
+        return;
+      }
+      code = newCode;
+      size = newSize;
+    }
+    code[length++] = byte;
+  }
+
+  void emitUint16(uint16_t value)
+  {
+    emit(value & 0xFF);
+    emit(value >> 8);
+  }
+
+  void emitFloat(float value)
+  {
+    uint8_t bytes[sizeof(float)];
+    memcpy(bytes, &value, sizeof(float));
+    for (uint8_t i=0; i<sizeof(float); i++)
+      emit(bytes[i]);
+  }
+
+  void patchUint16(uint16_t pos, uint16_t value)
+  {
+    code[pos] = value & 0xFF;
+    code[pos+1] = value >> 8;
+  }
+
+  //keep track of the values on the stack at run time
+  void stack(int8_t delta)
+  {
+    stackDepth += delta;
+    if (stackDepth > maxStackDepth)
+      maxStackDepth = stackDepth;
+  }
+
+  uint8_t functionIndex(Symbol* function_symbol)
+  {
+    for (uint8_t i=0; i<functionsIndex; i++)
+      if (functions[i] == function_symbol)
+        return i;
+    if (functionsIndex < nrOfFunctions)
+      functions[functionsIndex] = function_symbol;
+    else
+    {
+      ERROR_ARTI("ByteCode functions full (%d)\n", nrOfFunctions);
+      errorOccurred = true;
+    }
+    return functionsIndex++;
+  }
+
+  //size of the instruction at pc, used by dump
+  uint8_t instructionLength(uint16_t pc)
+  {
+    switch (code[pc])
+    {
+      case O_Const:
+        return 1 + sizeof(float);
+      case O_Load:
+      case O_LoadExt:
+      case O_StoreExt:
+      case O_Jump:
+      case O_JumpIfNot:
+      case O_ForLoop:
+      case O_ForCond:
+      case O_ForNext:
+        return 3;
+      case O_Store:
+      case O_CallExt:
+        return 4;
+      case O_LoadUniform:
+      case O_Call:
+      case O_Pop:
+        return 2;
+      default:
+        return 1;
+    }
+  }
+
+  void dump()
+  {
+    uint16_t pc = 0;
+    while (pc < length)
+    {
+      uint8_t opCode = code[pc];
+      switch (opCode)
+      {
+        case O_Const:
         {
-          resultChild = parse(nextParseTree, nextNode_name, '&', nextExpression, depth + 1); // every array element starts with '&' (operatorx is for result of all elements of array)
+          float value;
+          memcpy(&value, code + pc + 1, sizeof(float));
+          DEBUG_ARTI("%u %s %f\n", pc, opCodeToString(opCode), value);
+          break;
         }
-        else if (lexer->definitionJson["TOKENS"].containsKey(nextExpression.as<const char *>())) // token e.g. "ID"
+        case O_Jump:
+        case O_JumpIfNot:
+        case O_ForLoop:
+        case O_ForCond:
+        case O_ForNext:
+          DEBUG_ARTI("%u %s %u\n", pc, opCodeToString(opCode), code[pc+1] | (code[pc+2] << 8));
+          break;
+        case O_Call:
+          DEBUG_ARTI("%u %s %s\n", pc, opCodeToString(opCode), functions[code[pc+1]]->name);
+          break;
+        default:
         {
-          const char * token_type = nextExpression;
-          if (strcmp(lexer->current_token.type, token_type) == 0) 
-          {
-            DEBUG_ARTI("%s %s %s", spaces+50-depth, lexer->current_token.type, lexer->current_token.value);
-
-            //only add 'semantic tokens'
-            if (strcmp(lexer->current_token.type, "ID") != 0 && strcmp(lexer->current_token.type, "INTEGER_CONST") != 0 && strcmp(lexer->current_token.type, "REAL_CONST") != 0 && 
-                          strcmp(lexer->current_token.type, "INTEGER") != 0 && strcmp(lexer->current_token.type, "REAL") != 0 && 
-                          strcmp(lexer->current_token.value, "+") != 0 && strcmp(lexer->current_token.value, "-") != 0 && strcmp(lexer->current_token.value, "*") != 0 && strcmp(lexer->current_token.value, "/") != 0 && strcmp(lexer->current_token.value, "%") != 0 && 
-                          strcmp(lexer->current_token.value, "+=") != 0 && strcmp(lexer->current_token.value, "-=") != 0 && strcmp(lexer->current_token.value, "*=") != 0 && strcmp(lexer->current_token.value, "/=") != 0 &&
-                          strcmp(lexer->current_token.value, "<<") != 0 && strcmp(lexer->current_token.value, ">>") != 0 && 
-                          strcmp(lexer->current_token.value, "==") != 0 && strcmp(lexer->current_token.value, "!=") != 0 && 
-                          strcmp(lexer->current_token.value, "&&") != 0 && strcmp(lexer->current_token.value, "||") != 0 && 
-                          strcmp(lexer->current_token.value, ">") != 0 && strcmp(lexer->current_token.value, ">=") != 0 && strcmp(lexer->current_token.value, "<") != 0 && strcmp(lexer->current_token.value, "<=") != 0 &&
-                          strcmp(lexer->current_token.value, "++") != 0 && strcmp(lexer->current_token.value, "--") != 0
-            )
-            {}
-            else
-            {
-              if (nextParseTree.is<JsonArray>()) 
-                nextParseTree.as<JsonArray>()[nextParseTree.size()][lexer->current_token.type] = lexer->current_token.value; //add in last element of array
-              else
-                nextParseTree[nextNode_name][lexer->current_token.type] = lexer->current_token.value;
-            }
+          DEBUG_ARTI("%u %s", pc, opCodeToString(opCode));
+          for (uint8_t i=1; i<instructionLength(pc); i++)
+            DEBUG_ARTI(" %u", code[pc+i]);
+          DEBUG_ARTI("\n");
+        }
+      }
+      pc += instructionLength(pc);
+    }
+  }
 
-            lexer->eat(token_type);
+}; //ByteCode
 
-            DEBUG_ARTI(" -> [%s %s] %d\n", lexer->current_token.type, lexer->current_token.value, depth);
+enum RegisterOpCodes
+{
+  R_Halt,        //end of main program
+  R_Return,      //end of function
+  R_Move,        //dst, src
+  R_LoadExt,     //dst, external, index1, index2
+  R_StoreExt,    //src, external, index1, index2
+  R_CallExt,     //dst, external, nrOfArgs, arg*
+  R_Call,        //function, nrOfArgs, arg*
+  R_Jump,        //address
+  R_JumpIfNot,   //condition, address
+  R_ForLoop,     //temp, address: iteration counter in temp, loop mode in temp+1, pascal loop value in temp+2
+  R_ForCond,     //condition, temp, loop variable, address
+  R_ForNext,     //temp, loop variable, address
+  R_Neg,         //dst, src
+  R_Add,         //dst, left, right (binary operators in the same order as the Tokens enum)
+  R_Sub,
+  R_Mul,
+  R_Div,
+  R_Mod,
+  R_Shl,
+  R_Shr,
+  R_Eq,
+  R_Ne,
+  R_Lt,
+  R_Le,
+  R_Gt,
+  R_Ge,
+  R_And,
+  R_Or,
+  R_MulAdd,      //dst, a, b, c: dst = a * b + c (superinstructions: two instructions fused by RegisterCode::fuse)
+  R_MulSub,      //dst = a * b - c
+  R_MulMul,      //dst = a * b * c
+  R_DivMul,      //dst = a / b * c
+  R_AddMul,      //dst = (a + b) * c
+  R_CallExtStore, //-, arg1, arg2, arg3, index1, index2: external variable = external function, e.g. leds[i] = hsv(h, s, v)
+  R_NoOpCode = 255
+};
 
-            resultChild = ResultContinue;
-          }
-          else //deadend
-            resultChild = ResultFail;
-        } // if token
-        else //expressionElement is not a node, not a token, not an array and not an object
-        {
-          if (lexer->definitionJson.containsKey(nextExpression.as<const char *>()))
-            ERROR_ARTI("%s Programming error: %s not a node, token, array or object in %s\n", spaces+50-depth, nextExpression.as<std::string>().c_str(), stringOrEmpty(nextNode_name));
-          else
-            ERROR_ARTI("%s Definition error: \"%s\": \"%s\" node should be embedded in array\n", spaces+50-depth, stringOrEmpty(nextNode_name), nextExpression.as<std::string>().c_str());
-        } //nextExpression is not a token
+const char * registerOpCodeToString(uint8_t opCode)
+{
+  switch (opCode) {
+  case R_Halt:
+    return "halt";
+  case R_Return:
+    return "return";
+  case R_Move:
+    return "move";
+  case R_LoadExt:
+    return "loadext";
+  case R_StoreExt:
+    return "storeext";
+  case R_CallExt:
+    return "callext";
+  case R_Call:
+    return "call";
+  case R_Jump:
+    return "jump";
+  case R_JumpIfNot:
+    return "jumpifnot";
+  case R_ForLoop:
+    return "forloop";
+  case R_ForCond:
+    return "forcond";
+  case R_ForNext:
+    return "fornext";
+  case R_Neg:
+    return "neg";
+  case R_MulAdd:
+    return "muladd";
+  case R_MulSub:
+    return "mulsub";
+  case R_MulMul:
+    return "mulmul";
+  case R_DivMul:
+    return "divmul";
+  case R_AddMul:
+    return "addmul";
+  case R_CallExtStore:
+    return "callextstore";
+  }
+  if (opCode >= R_Add && opCode <= R_Or)
+    return tokenToString(opCode - R_Add + F_plus);
+  return "unknown opcode";
+}
 
-        if (!nodeExpression.isNull()) //if node
-        {
-          if (nextParseTree.containsKey("connect"))
-            nextParseTree.remove("connect"); //remove connector
-          // for values which are not parsed deeper. e.g. : {"formal": {"ID": "z"}}
-          for (JsonPair parseTreePair : nextParseTree.as<JsonObject>()) 
-          {
-            JsonVariant value = parseTreePair.value();
-            if (value.containsKey("connect"))
-              value.remove("connect"); //remove connector
-          }
+//an operand (slot) is a base and an index: bases[base][index]
+#define S_Constants 0 //registerCode constants
+#define S_Temps 1 //intermediate results, part of the valueStack
+#define S_Level0 2 //S_Level0 + level: floatMembers of the activation record of the level
+#define S_Uniforms (S_Level0 + nrOfRecords) //externals read once per frame, see ARTI::snapshotUniforms
+#define nrOfBases (S_Uniforms + 1)
+#define nrOfUniforms 16
+
+//how an external depends on the frame, see arti_external_frame and ARTI::skipFrame
+#define frameIndependent 0 //same result for the same parameters, or only sets e.g. fill
+#define frameInput 1 //can change between frames e.g. segcolor: the results read are compared in the next frame
+#define frameDependent 2 //changes each frame or uses the leds of the previous frame e.g. millis, random, fadeToBlackBy: frames are not skipped
+
+#define nrOfFrameInputs 16
+
+//result of a frameInput external read during a frame, see ARTI::skipFrame
+struct FrameInput {
+  uint8_t external;
+  float par1, par2, par3;
+  float result;
+};
 
-          if (resultChild == ResultFail) { //remove result of parse
-            nextParseTree.remove(nextNode_name); //remove the failed stuff
+#define slotLength 2
+#define slot(base, index) (((base) << 8) | (index))
 
-            // DEBUG_ARTI("%s fail %s\n", spaces+50-depth, nextNode_name);
-          }
-          else //success
-          {
-            DEBUG_ARTI("%s found %s\n", spaces+50-depth, nextNode_name);//, nextParseTree.as<std::string>().c_str());
-            //parseTree optimization moved to optimize function
+//dispatch of the instructions in executeRegisters
+#define ARTI_SWITCH 1 //switch on the opCode in a loop, portable
+#define ARTI_THREADED 2 //each instruction jumps to the label of the next one (labels as values, gcc and clang)
 
-            // if (nextParseTree.is<JsonObject>())
-            // {
+#ifndef ARTI_DISPATCH
+  #if defined(__GNUC__) //also xtensa-gcc (esp32)
+    #define ARTI_DISPATCH ARTI_THREADED
+  #else
+    #define ARTI_DISPATCH ARTI_SWITCH
+  #endif
+#endif
 
-            //   // optimize(nextParseTree, depth);
+//count the instructions run by executeRegisters in RegisterCode::executedInstructions (see arti_wled_superinstructions.cpp)
+#ifndef ARTI_COUNT
+  #define ARTI_COUNT 0
+#endif
 
-            //   JsonObject innerObject = nextParseTree[nextNode_name].as<JsonObject>();
+//E_RegisterVM: renderLed runs for ARTI_LANES pixels at once (see ARTI::runLanes), 1: one pixel at a time
+#ifndef ARTI_LANES
+  #if ARTI_PLATFORM == ARTI_ARDUINO
+    #define ARTI_LANES 4
+  #else
+    #define ARTI_LANES 8
+  #endif
+#endif
 
-            //   JsonObject::iterator begin = innerObject.begin();
-            //   if (fnextParseTree.size() == 1 && nextParseTree[nextNode_name].size() == 1 && lexer->definitionJson.containsKey(nextNode_name) && lexer->definitionJson.containsKey(nextNode_name) && lexer->definitionJson.containsKey(begin->key()))
-            //   {
-            //     // JsonObject nextParseTreeObject = nextParseTree.as<JsonObject>();
+//E_JIT translates the register code to machine code: x86-64 hosts with the System V calling convention (not Windows)
+#ifndef ARTI_JIT
+  #if ARTI_PLATFORM != ARTI_ARDUINO && defined(__x86_64__) && !defined(_WIN32)
+    #define ARTI_JIT 1
+  #else
+    #define ARTI_JIT 0
+  #endif
+#endif
 
-            //     DEBUG_ARTI("%s found %s:%s\n", spaces+50-depth, node_name, parseTree.as<std::string>().c_str());
-            //     DEBUG_ARTI("%s found replace %s by %s %s\n", spaces+50-depth, nextNode_name, begin->key().c_str(), nextParseTree.as<std::string>().c_str());
-            //     DEBUG_ARTI("%s expression %s\n", spaces+50-depth, expression.as<std::string>().c_str());
-            //     DEBUG_ARTI("%s found %s\n", spaces+50-depth, nextParseTree[nextNode_name].as<std::string>().c_str());
+#if ARTI_JIT
+  #include <sys/mman.h>
+#endif
 
-            //     nextParseTree.remove(nextNode_name);
-            //     // char temp[charLength];
-            //     // strcpy(temp, nextNode_name);
-            //     // strcat(temp, "-");
-            //     // strcat(temp, begin->key().c_str());
-            //     nextParseTree[begin->key()] = begin->value();
+//renderLed runs on ARTI::threads threads (see ARTI::runParallel): hosts only
+#ifndef ARTI_THREADS
+  #if ARTI_PLATFORM != ARTI_ARDUINO
+    #define ARTI_THREADS 1
+  #else
+    #define ARTI_THREADS 0
+  #endif
+#endif
 
-            //     DEBUG_ARTI("%s found %s:%s\n", spaces+50-depth, node_name, parseTree.as<std::string>().c_str());
-            //   }
-            // }
-            // else
-            //   DEBUG_ARTI("%s no jsonobject??? %s\n", spaces+50-depth, parseTree.as<std::string>().c_str());
+#if ARTI_THREADS
+  #include <thread>
+  #include <mutex>
+  #include <condition_variable>
+  #include <atomic>
+#endif
 
-          }
-        } // if node
+//packed 32-bit colors (RGB or WRGB) as values of the engines, which are floats: exact integers only up to 2^24
+//colors without white are the number itself, so numbers used as colors keep their meaning (0 black, 255 blue)
+//colors with white are kept in the ColorTable of the ARTI, their value is a handle: a number from 2^33 on, 1024 apart (the distance of floats there), never a color as a number
+//a handle is the generation, owner and slot of the color: the colors of a frame are reclaimed by the next frame (see reclaim)
+#define colorHandles 8589934592.0f //2^33
+#define colorNumbers 4294967296.0f //2^32: numbers from here on are no color
+#define nrOfColorSlots 2048 //colors with white of a table (11 bits of a handle)
+#define nrOfColorOwners 32 //0: the ARTI, 1..nrOfThreads: its workers (5 bits)
+#define nrOfColorGenerations 128 //0: colors of setup, 1..127: of a frame (7 bits)
+
+//the colors with white of an ARTI or of a worker of it (see ARTI::newWorker), only used by the thread running it
+struct ColorTable
+{
+  uint32_t *colors = nullptr; //color of each slot
+  uint16_t *buckets = nullptr; //open addressing on the color: slot + 1, 0 if empty, 2 * size buckets
+  uint16_t size = 0; //allocated slots
+  uint16_t length = 0; //slots used
+  uint16_t kept = 0; //slots of the colors of setup, not reclaimed
+  uint8_t generation = 0; //of the slots from kept on
+  uint8_t owner = 0; //in the handles
+  bool framesStarted = false; //colors from here on are of a frame
+  uint16_t noColors = 0; //values used as color which are no color, reported by reclaim
+  ColorTable *shared = nullptr; //workers: the table of the ARTI they are copied from, e.g. colors of renderFrame used by renderLed
+
+  static uint16_t hash(uint32_t color)
+  {
+    return (color * 2654435761u) >> 16;
+  }
 
-        //determine result of expressionElement
-        if (operatorx == '|') {
-          if (resultChild == ResultFail) {//if fail, go back and try another
-            // result = ResultContinue;
-            lexer->pop_position();
-          }
-          else {
-            result = ResultStop;  //Stop or continue is enough for an or
-            lexer->positions_index--;
-          }
-        }
-        else {
-          if (resultChild != ResultContinue) //for and, ?, + and *; each result should continue
-            result = ResultFail;
-        } 
+  float handle(uint16_t slot)
+  {
+    uint32_t number = (uint32_t)(slot < kept?0:generation) << 16 | (uint32_t)owner << 11 | slot;
+    return colorHandles + number * 1024.0f; //exact: a multiple of 1024 below 2^34
+  }
 
-        if (result != ResultContinue) //if no reason to continue then stop
-          break;
+  void insert(uint16_t slot)
+  {
+    uint16_t mask = 2 * size - 1;
+    uint16_t bucket = hash(colors[slot]) & mask;
+    while (buckets[bucket] != 0)
+      bucket = (bucket + 1) & mask;
+    buckets[bucket] = slot + 1;
+  }
 
-      } //for expressionElement
+  void rebuild()
+  {
+    if (size == 0)
+      return;
+    memset(buckets, 0, 2 * size * sizeof(uint16_t));
+    for (uint16_t slot = 0; slot < length; slot++)
+      insert(slot);
+  }
 
-      if (operatorx == '|') 
-      {
-        if (result != ResultStop) //still looking but nothing to look for
-          result = ResultFail;
-      }
+  //twice as many slots: an error if more than nrOfColorSlots (no color is rounded)
+  bool grow()
+  {
+    if (size >= nrOfColorSlots)
+    {
+      ERROR_ARTI("More than %u colors with white in a frame\n", nrOfColorSlots);
+      errorOccurred = true;
+      return false;
     }
-    else { //should never happen
-      ERROR_ARTI("%s Programming error: no array %s %c %s\n", spaces+50-depth, stringOrEmpty(node_name), operatorx, expression.as<std::string>().c_str());
+    uint16_t newSize = size == 0?16:size * 2;
+    uint32_t *newColors = (uint32_t *)realloc(colors, newSize * sizeof(uint32_t));
+    uint16_t *newBuckets = (uint16_t *)malloc(2 * newSize * sizeof(uint16_t));
+    if (newColors != nullptr)
+      colors = newColors;
+    if (newColors == nullptr || newBuckets == nullptr)
+    {
+      ERROR_ARTI("ColorTable: no memory for %u colors\n", newSize);
+      errorOccurred = true;
+      free(newBuckets);
+      return false;
     }
+    free(buckets);
+    buckets = newBuckets;
+    size = newSize;
+    rebuild();
+    return true;
+  }
 
-    return result;
+  //the value of a color: the same handle for the same color
+  float value(uint32_t color)
+  {
+    if (color < 0x1000000)
+      return color;
 
-  } //parse
+    if (size > 0)
+    {
+      uint16_t mask = 2 * size - 1;
+      for (uint16_t bucket = hash(color) & mask; buckets[bucket] != 0; bucket = (bucket + 1) & mask)
+        if (colors[buckets[bucket] - 1] == color)
+          return handle(buckets[bucket] - 1);
+    }
+    if (length == size && !grow())
+      return 0;
+    colors[length] = color;
+    insert(length);
+    return handle(length++);
+  }
 
-  bool analyze(JsonVariant parseTree, const char * treeElement = nullptr, ScopedSymbolTable* current_scope = nullptr, uint8_t depth = 0) 
+  //the color of a value: numbers are truncated (negative numbers wrap, e.g. -1 is 0xFFFFFFFF), a handle of a reclaimed color or a number from 2^32 on (e.g. a handle times 2) is black and counted in noColors
+  uint32_t color(float value)
   {
-    // ANDBG_ARTI("%s Depth %u %s\n", spaces+50-depth, depth, parseTree.as<std::string>().c_str());
-    if (depth > 24) //otherwise stack canary errors on Arduino (value determined after testing, should be revisited)
+    if (value >= colorNumbers)
     {
-      ERROR_ARTI("Error: Analyze recursion level too deep at %s (%u)\n", parseTree.as<std::string>().c_str(), depth);
-      errorOccurred = true;
+      if (value >= colorHandles && value < 2 * colorHandles)
+      {
+        uint32_t number = (value - colorHandles) / 1024.0f; //exact: floats there are multiples of 1024
+        uint16_t slot = number & (nrOfColorSlots - 1);
+        uint8_t owner = number >> 11 & (nrOfColorOwners - 1);
+        ColorTable *table = owner == this->owner?this:owner == 0?shared:nullptr;
+        if (table != nullptr && slot < table->length && number >> 16 == (slot < table->kept?0:table->generation))
+          return table->colors[slot];
+      }
+      noColors++;
+      return 0;
     }
-    if (errorOccurred) return false;
+    if (value >= 0)
+      return (uint32_t)value;
+    if (value > -2147483648.0f) //-2^31
+      return (uint32_t)(int32_t)value;
+    return value < 0?0x80000000:0; //also nan
+  }
 
-    if (parseTree.is<JsonObject>()) 
+  //start of a frame: the colors made by the previous frame are not used anymore, the colors made before the first frame (by setup) are kept
+  void reclaim()
+  {
+    if (noColors > 0)
     {
-      for (JsonPair parseTreePair : parseTree.as<JsonObject>()) 
-      {
-        const char * key = parseTreePair.key().c_str();
-        JsonVariant value = parseTreePair.value();
-        if (treeElement == nullptr || strcmp(treeElement, key) == 0 ) //in case there are more elements in the object and you want to analyze only one
+      WARNING_ARTI("%u values used as color were no color: a color with white of a previous frame or a calculated one\n", noColors);
+      noColors = 0;
+    }
+    if (!framesStarted)
+    {
+      kept = length;
+      framesStarted = true;
+    }
+    else if (length > kept)
+    {
+      length = kept;
+      rebuild();
+    }
+    generation = generation % (nrOfColorGenerations - 1) + 1;
+  }
+
+  //no colors, e.g. for a new program
+  void reset()
+  {
+    length = 0;
+    kept = 0;
+    generation = 0;
+    framesStarted = false;
+    noColors = 0;
+    rebuild();
+  }
+
+  void release()
+  {
+    free(colors); colors = nullptr;
+    free(buckets); buckets = nullptr;
+    size = 0;
+    reset();
+  }
+}; //ColorTable
+
+#define nrOfOperands 6 //dst and 5 parameters of an external function
+
+struct Operand {
+  uint8_t base;
+  uint8_t index;
+};
+
+//an instruction of the register code decoded to fixed size, see RegisterCode::decode
+struct Instruction {
+  const void *handler; //ARTI_THREADED: label of the opCode in executeRegisters
+  uint8_t opCode;
+  uint8_t index; //external, function or temp of a for loop
+  uint8_t nrOfArgs;
+  uint8_t external; //R_CallExtStore: external variable set to the result of the call
+  uint16_t address; //jump target: index in instructions
+  Operand operands[nrOfOperands];
+};
+
+//register code: each instruction names its operands, translated from the stack based byteCode
+class RegisterCode: public ByteCode
+{
+private:
+  //translate state: the values on the stack are not pushed but remembered as operand
+  uint16_t operands[arrayLength];
+  uint8_t depth = 0;
+  uint16_t lastDst = 0; //position of the dst of the last instruction, 0 if no retarget possible
+
+public:
+  float *constants = nullptr;
+  uint8_t constantsIndex = 0;
+  uint8_t constantsSize = 0;
+  uint8_t constNull = 0; //index of floatNull in constants
+  uint8_t maxLevel = 0;
+  //maxStackDepth: number of temps of a function call
+
+  Instruction *instructions = nullptr; //decoded code
+  uint16_t instructionsLength = 0;
+  bool handlersSet = false; //ARTI_THREADED: handler of instructions set by executeRegisters
+  uint32_t executedInstructions = 0; //ARTI_COUNT: instructions run by executeRegisters
+
+  RegisterCode()
+  {
+  }
+
+  ~RegisterCode()
+  {
+    free(constants);
+    free(instructions);
+    MEMORY_ARTI("Destruct RegisterCode (%u)\n", FREE_SIZE);
+  }
+
+  uint8_t constantIndex(float value)
+  {
+    for (uint8_t i=0; i<constantsIndex; i++)
+      if (memcmp(&constants[i], &value, sizeof(float)) == 0)
+        return i;
+
+    if (constantsIndex == 255)
+    {
+      ERROR_ARTI("RegisterCode: too many constants\n");
+      errorOccurred = true;
+      return 0;
+    }
+    if (constantsIndex >= constantsSize)
+    {
+      uint8_t newSize = constantsSize == 0 ? 16 : (constantsSize >= 128 ? 255 : constantsSize * 2);
+      float *newConstants = (float *)realloc(constants, newSize * sizeof(float));
+      if (newConstants == nullptr)
+      {
+        ERROR_ARTI("RegisterCode: no memory for %u constants\n", newSize);
+        errorOccurred = true;
+        return 0;
+      }
+      constants = newConstants;
+      constantsSize = newSize;
+    }
+    constants[constantsIndex] = value;
+    return constantsIndex++;
+  }
+
+  void emitSlot(uint16_t slot)
+  {
+    emit(slot >> 8);
+    emit(slot & 0xFF);
+  }
+
+  //result of an instruction is written to the temp of the current depth
+  void emitDst()
+  {
+    lastDst = length;
+    emitSlot(slot(S_Temps, depth));
+    if (depth + 1 > maxStackDepth)
+      maxStackDepth = depth + 1;
+  }
+
+  void push(uint16_t slot)
+  {
+    if (depth >= arrayLength)
+    {
+      ERROR_ARTI("RegisterCode: stack full\n");
+      errorOccurred = true;
+      return;
+    }
+    operands[depth++] = slot;
+  }
+
+  uint16_t pop()
+  {
+    if (depth == 0)
+    {
+      ERROR_ARTI("RegisterCode: stack empty\n");
+      errorOccurred = true;
+      return slot(S_Constants, 0);
+    }
+    return operands[--depth];
+  }
+
+  //values which are not in their temp yet (constants, variables) are moved there, e.g. before a jump
+  void materialize(uint8_t from = 0)
+  {
+    for (uint8_t i=from; i<depth; i++)
+    {
+      if (operands[i] != slot(S_Temps, i))
+      {
+        emit(R_Move);
+        emitSlot(slot(S_Temps, i));
+        emitSlot(operands[i]);
+        operands[i] = slot(S_Temps, i);
+        if (i + 1 > maxStackDepth)
+          maxStackDepth = i + 1;
+        lastDst = 0;
+      }
+    }
+  }
+
+  //size of the instruction at pc
+  uint8_t instructionLength(uint16_t pc)
+  {
+    switch (code[pc])
+    {
+      case R_Move:
+      case R_Neg:
+        return 1 + 2 * slotLength;
+      case R_LoadExt:
+      case R_StoreExt:
+        return 2 + 3 * slotLength;
+      case R_CallExt:
+        return 3 + slotLength + code[pc + 1 + slotLength + 1] * slotLength;
+      case R_Call:
+        return 3 + code[pc+2] * slotLength;
+      case R_Jump:
+        return 3;
+      case R_JumpIfNot:
+        return 3 + slotLength;
+      case R_ForLoop:
+        return 4;
+      case R_ForCond:
+        return 4 + 2 * slotLength;
+      case R_ForNext:
+        return 4 + slotLength;
+      case R_Halt:
+      case R_Return:
+        return 1;
+      default: //binary operators
+        return 1 + 3 * slotLength;
+    }
+  }
+
+  //position of the address of a jump instruction at pc, 0 if none
+  uint8_t addressOffset(uint16_t pc)
+  {
+    switch (code[pc])
+    {
+      case R_Jump:
+        return 1;
+      case R_JumpIfNot:
+        return 1 + slotLength;
+      case R_ForLoop:
+        return 2;
+      case R_ForCond:
+        return 2 + 2 * slotLength;
+      case R_ForNext:
+        return 2 + slotLength;
+      default:
+        return 0;
+    }
+  }
+
+  //simulates the stack of the byteCode: constants and variables are used directly as operand, results go to temps
+  bool translate(ByteCode *stackCode)
+  {
+    uint16_t *pcMap = (uint16_t *)malloc(stackCode->length * sizeof(uint16_t)); //stack code pc -> register code pc
+    uint8_t *depthAt = (uint8_t *)calloc(stackCode->length, 1); //stack depth at jump targets
+    bool *isTarget = (bool *)calloc(stackCode->length, sizeof(bool));
+    if (pcMap == nullptr || depthAt == nullptr || isTarget == nullptr)
+    {
+      ERROR_ARTI("RegisterCode: no memory to translate %u bytes\n", stackCode->length);
+      errorOccurred = true;
+    }
+
+    const uint8_t *sCode = stackCode->code;
+    uint16_t pc = 0;
+
+    //jump targets: pending operands are materialized there
+    while (!errorOccurred && pc < stackCode->length)
+    {
+      switch (sCode[pc])
+      {
+        case O_Jump:
+        case O_JumpIfNot:
+        case O_ForLoop:
+        case O_ForCond:
+        case O_ForNext:
+          isTarget[sCode[pc+1] | (sCode[pc+2] << 8)] = true;
+      }
+      pc += stackCode->instructionLength(pc);
+    }
+
+    for (uint8_t i=0; i<stackCode->functionsIndex; i++)
+    {
+      functionIndex(stackCode->functions[i]); //same order
+      isTarget[stackCode->functions[i]->code_entry] = true;
+    }
+
+    constNull = constantIndex(floatNull);
+    uint16_t loopVariable = slot(S_Temps, 0); //variable assigned last before a for loop (pascal)
+    bool reachable = true;
+    bool supported = true;
+    depth = 0;
+    lastDst = 0;
+    pc = 0;
+
+    while (supported && !errorOccurred && pc < stackCode->length)
+    {
+      if (isTarget[pc])
+      {
+        if (reachable)
+          materialize();
+        else
+        {
+          depth = depthAt[pc];
+          for (uint8_t i=0; i<depth; i++)
+            operands[i] = slot(S_Temps, i);
+        }
+        reachable = true;
+        lastDst = 0;
+      }
+
+      pcMap[pc] = length;
+      uint8_t opCode = sCode[pc];
+
+      switch (opCode)
+      {
+        case O_Halt:
+          emit(R_Halt);
+          reachable = false;
+          break;
+        case O_Return:
+          emit(R_Return);
+          reachable = false;
+          break;
+        case O_Const:
+        {
+          float value;
+          memcpy(&value, sCode + pc + 1, sizeof(float));
+          push(slot(S_Constants, constantIndex(value)));
+          break;
+        }
+        case O_Load:
+          if (sCode[pc+1] > maxLevel)
+            maxLevel = sCode[pc+1];
+          push(slot(S_Level0 + sCode[pc+1], sCode[pc+2]));
+          break;
+        case O_LoadUniform:
+          push(slot(S_Uniforms, sCode[pc+1]));
+          break;
+        case O_Store:
+        {
+          uint16_t variable = slot(S_Level0 + sCode[pc+1], sCode[pc+2]);
+          if (sCode[pc+1] > maxLevel)
+            maxLevel = sCode[pc+1];
+          uint8_t assignOperator = sCode[pc+3];
+          uint16_t value = (assignOperator == F_plusplus || assignOperator == F_minmin)?slot(S_Constants, constantIndex(1)):pop();
+
+          for (uint8_t i=0; i<depth; i++) //the old value is still needed
+            if (operands[i] == variable)
+              materialize(i);
+
+          if (assignOperator == F_plus || assignOperator == F_minus || assignOperator == F_multiplication || assignOperator == F_division
+            || assignOperator == F_plusplus || assignOperator == F_minmin)
+          {
+            if (assignOperator == F_plusplus)
+              emit(R_Add);
+            else if (assignOperator == F_minmin)
+              emit(R_Sub);
+            else
+              emit(tokenToOpCode(assignOperator) - O_Add + R_Add);
+            emitSlot(variable);
+            emitSlot(variable);
+            emitSlot(value);
+          }
+          else if (lastDst != 0 && value == slot(S_Temps, depth) && code[lastDst] == S_Temps && code[lastDst+1] == depth)
+          {
+            //the value is the result of the previous instruction: let it write to the variable directly
+            code[lastDst] = variable >> 8;
+            code[lastDst+1] = variable & 0xFF;
+          }
+          else
+          {
+            emit(R_Move);
+            emitSlot(variable);
+            emitSlot(value);
+          }
+          lastDst = 0;
+          loopVariable = variable;
+          break;
+        }
+        case O_LoadExt:
+        case O_StoreExt:
+        {
+          uint8_t nrOfIndices = sCode[pc+2];
+          uint16_t index2 = nrOfIndices > 1?pop():slot(S_Constants, constNull);
+          uint16_t index1 = nrOfIndices > 0?pop():slot(S_Constants, constNull);
+          if (opCode == O_LoadExt)
+          {
+            emit(R_LoadExt);
+            emitDst();
+          }
+          else
+          {
+            emit(R_StoreExt);
+            emitSlot(pop());
+            lastDst = 0;
+          }
+          emit(sCode[pc+1]);
+          emitSlot(index1);
+          emitSlot(index2);
+          if (opCode == O_LoadExt)
+            push(slot(S_Temps, depth));
+          break;
+        }
+        case O_CallExt:
+        {
+          uint8_t nrOfArgs = sCode[pc+2];
+          depth -= nrOfArgs;
+          emit(R_CallExt);
+          emitDst();
+          emit(sCode[pc+1]);
+          emit(nrOfArgs);
+          for (uint8_t i=0; i<nrOfArgs; i++)
+            emitSlot(operands[depth + i]);
+          if (sCode[pc+3]) //keep result
+            push(slot(S_Temps, depth));
+          else
+            lastDst = 0;
+          break;
+        }
+        case O_Call:
+        {
+          Symbol* function_symbol = stackCode->functions[sCode[pc+1]];
+          uint8_t nrOfArgs = function_symbol->function_scope->nrOfFormals;
+          if (nrOfArgs > nrOfOperands)
+          {
+            WARNING_ARTI("RegisterCode: call of %s with more than %u arguments not supported\n", function_symbol->name, nrOfOperands);
+            supported = false;
+          }
+          depth -= nrOfArgs;
+          materialize(); //values below the actuals, the function can change variables
+          emit(R_Call);
+          emit(sCode[pc+1]);
+          emit(nrOfArgs);
+          for (uint8_t i=0; i<nrOfArgs; i++)
+            emitSlot(operands[depth + i]);
+          lastDst = 0;
+          break;
+        }
+        case O_Pop:
+          depth -= sCode[pc+1];
+          break;
+        case O_Jump:
+        case O_JumpIfNot:
+        {
+          uint16_t condition = opCode == O_JumpIfNot?pop():0;
+          materialize();
+          emit(opCode == O_Jump?R_Jump:R_JumpIfNot);
+          if (opCode == O_JumpIfNot)
+            emitSlot(condition);
+          emit(sCode[pc+1]); //stack code address, mapped below
+          emit(sCode[pc+2]);
+          depthAt[sCode[pc+1] | (sCode[pc+2] << 8)] = depth;
+          if (opCode == O_Jump)
+            reachable = false;
+          lastDst = 0;
+          break;
+        }
+        case O_ForLoop:
+        case O_ForCond:
+        case O_ForNext:
+        {
+          uint16_t condition = opCode == O_ForCond?pop():0;
+          materialize();
+          emit(opCode - O_ForLoop + R_ForLoop);
+          if (opCode == O_ForCond)
+            emitSlot(condition);
+          emit(depth - 3);
+          if (opCode != O_ForLoop)
+            emitSlot(loopVariable);
+          emit(sCode[pc+1]);
+          emit(sCode[pc+2]);
+          depthAt[sCode[pc+1] | (sCode[pc+2] << 8)] = depth;
+          lastDst = 0;
+          break;
+        }
+        case O_Neg:
+        {
+          uint16_t value = pop();
+          emit(R_Neg);
+          emitDst();
+          emitSlot(value);
+          push(slot(S_Temps, depth));
+          break;
+        }
+        default:
+          if (opCode >= O_Add && opCode <= O_Or)
+          {
+            uint16_t right = pop();
+            uint16_t left = pop();
+            emit(opCode - O_Add + R_Add);
+            emitDst();
+            emitSlot(left);
+            emitSlot(right);
+            push(slot(S_Temps, depth));
+          }
+          else
+          {
+            ERROR_ARTI("RegisterCode: unknown opcode %u at %u\n", opCode, pc);
+            errorOccurred = true;
+          }
+      }
+      pc += stackCode->instructionLength(pc);
+    }
+
+    //map the jump addresses and function entries to the register code
+    pc = 0;
+    while (supported && !errorOccurred && pc < length)
+    {
+      uint8_t offset = addressOffset(pc);
+      if (offset > 0)
+        patchUint16(pc + offset, pcMap[code[pc + offset] | (code[pc + offset + 1] << 8)]);
+      pc += instructionLength(pc);
+    }
+    for (uint8_t i=0; supported && !errorOccurred && i<functionsIndex; i++)
+      functions[i]->code_entry = pcMap[functions[i]->code_entry];
+
+    if (maxLevel >= nrOfRecords)
+    {
+      ERROR_ARTI("RegisterCode: level %u too deep\n", maxLevel);
+      errorOccurred = true;
+    }
+
+    free(pcMap);
+    free(depthAt);
+    free(isTarget);
+
+    return supported && !errorOccurred;
+  }
+
+  Operand operand(uint16_t pc)
+  {
+    Operand operand;
+    operand.base = code[pc];
+    operand.index = code[pc+1];
+    return operand;
+  }
+
+  //converts code to instructions which can be executed without decoding the bytes, code is freed
+  bool decode()
+  {
+    uint16_t *indexMap = (uint16_t *)malloc(length * sizeof(uint16_t)); //code pc -> instruction index
+    if (indexMap == nullptr)
+    {
+      ERROR_ARTI("RegisterCode: no memory to decode %u bytes\n", length);
+      errorOccurred = true;
+      return false;
+    }
+
+    uint16_t pc = 0;
+    instructionsLength = 0;
+    while (pc < length)
+    {
+      indexMap[pc] = instructionsLength++;
+      pc += instructionLength(pc);
+    }
+
+    instructions = (Instruction *)calloc(instructionsLength, sizeof(Instruction));
+    if (instructions == nullptr)
+    {
+      ERROR_ARTI("RegisterCode: no memory for %u instructions\n", instructionsLength);
+      errorOccurred = true;
+    }
+
+    pc = 0;
+    for (uint16_t i=0; !errorOccurred && i<instructionsLength; i++)
+    {
+      Instruction *instruction = &instructions[i];
+      uint8_t opCode = code[pc];
+      instruction->opCode = opCode;
+
+      switch (opCode)
+      {
+        case R_Halt:
+        case R_Return:
+        case R_Jump:
+          break;
+        case R_Move:
+        case R_Neg:
+          instruction->operands[0] = operand(pc+1);
+          instruction->operands[1] = operand(pc+3);
+          break;
+        case R_LoadExt:
+        case R_StoreExt:
+          instruction->operands[0] = operand(pc+1);
+          instruction->index = code[pc+3];
+          instruction->operands[1] = operand(pc+4);
+          instruction->operands[2] = operand(pc+6);
+          break;
+        case R_CallExt:
+          instruction->operands[0] = operand(pc+1);
+          instruction->index = code[pc+3];
+          instruction->nrOfArgs = code[pc+4];
+          for (uint8_t j=0; j<nrOfOperands-1; j++)
+          {
+            if (j < instruction->nrOfArgs)
+              instruction->operands[j+1] = operand(pc + 5 + j * slotLength);
+            else
+            {
+              instruction->operands[j+1].base = S_Constants; //missing parameters are floatNull
+              instruction->operands[j+1].index = constNull;
+            }
+          }
+          break;
+        case R_Call:
+          instruction->index = code[pc+1];
+          instruction->nrOfArgs = code[pc+2];
+          for (uint8_t j=0; j<instruction->nrOfArgs; j++)
+            instruction->operands[j] = operand(pc + 3 + j * slotLength);
+          break;
+        case R_JumpIfNot:
+          instruction->operands[0] = operand(pc+1);
+          break;
+        case R_ForLoop:
+          instruction->index = code[pc+1];
+          break;
+        case R_ForCond:
+          instruction->operands[0] = operand(pc+1);
+          instruction->index = code[pc+3];
+          instruction->operands[1] = operand(pc+4);
+          break;
+        case R_ForNext:
+          instruction->index = code[pc+1];
+          instruction->operands[0] = operand(pc+2);
+          break;
+        default: //binary operators
+          instruction->operands[0] = operand(pc+1);
+          instruction->operands[1] = operand(pc+3);
+          instruction->operands[2] = operand(pc+5);
+      }
+
+      uint8_t offset = addressOffset(pc);
+      if (offset > 0)
+        instruction->address = indexMap[code[pc + offset] | (code[pc + offset + 1] << 8)];
+
+      pc += instructionLength(pc);
+    }
+
+    for (uint8_t i=0; !errorOccurred && i<functionsIndex; i++)
+      functions[i]->code_entry = indexMap[functions[i]->code_entry];
+
+    free(indexMap);
+    free(code); code = nullptr;
+    size = 0;
+
+    return !errorOccurred;
+  }
+
+  bool sameOperand(Operand operand1, Operand operand2)
+  {
+    return operand1.base == operand2.base && operand1.index == operand2.index;
+  }
+
+  //first and second become a superinstruction in first if second uses the temp computed by first (and nothing else does, a temp is used once)
+  bool fusePair(Instruction *first, const Instruction *second)
+  {
+    Operand temp = first->operands[0];
+    if (temp.base != S_Temps)
+      return false;
+
+    //leds[i] = hsv(h, s, v): the result of the call is stored without temp
+    if (first->opCode == R_CallExt && second->opCode == R_StoreExt && first->nrOfArgs <= 3
+      && sameOperand(second->operands[0], temp) && !sameOperand(second->operands[1], temp) && !sameOperand(second->operands[2], temp))
+    {
+      first->opCode = R_CallExtStore;
+      first->external = second->index;
+      first->operands[4] = second->operands[1];
+      first->operands[5] = second->operands[2];
+      return true;
+    }
+
+    //the most frequent pairs of operators in the Examples
+    static const uint8_t pairs[][3] = {{R_Mul, R_Add, R_MulAdd}, {R_Mul, R_Sub, R_MulSub}, {R_Mul, R_Mul, R_MulMul}, {R_Div, R_Mul, R_DivMul}, {R_Add, R_Mul, R_AddMul}};
+
+    for (uint8_t i=0; i<sizeof(pairs) / sizeof(pairs[0]); i++)
+    {
+      if (first->opCode != pairs[i][0] || second->opCode != pairs[i][1])
+        continue;
+
+      Operand other;
+      if (sameOperand(second->operands[1], temp) && !sameOperand(second->operands[2], temp))
+        other = second->operands[2];
+      else if (sameOperand(second->operands[2], temp) && !sameOperand(second->operands[1], temp) && second->opCode != R_Sub) //c + a * b is a * b + c
+        other = second->operands[1];
+      else
+        return false;
+
+      first->opCode = pairs[i][2];
+      first->operands[0] = second->operands[0];
+      first->operands[3] = other;
+      return true;
+    }
+    return false;
+  }
+
+  //superinstructions: fuses pairs of decoded instructions into one, less dispatches in executeRegisters (the JIT does not need this), returns the number of fused pairs
+  uint16_t fuse()
+  {
+    bool *isTarget = (bool *)calloc(instructionsLength, sizeof(bool)); //a jump target cannot be the second of a pair
+    uint16_t *indexMap = (uint16_t *)malloc(instructionsLength * sizeof(uint16_t)); //old index -> new index
+    if (isTarget == nullptr || indexMap == nullptr)
+    {
+      ERROR_ARTI("RegisterCode: no memory to fuse %u instructions\n", instructionsLength);
+      errorOccurred = true;
+      free(isTarget);
+      free(indexMap);
+      return 0;
+    }
+
+    for (uint16_t i=0; i<instructionsLength; i++)
+      if (instructions[i].opCode >= R_Jump && instructions[i].opCode <= R_ForNext)
+        isTarget[instructions[i].address] = true;
+    for (uint8_t i=0; i<functionsIndex; i++)
+      isTarget[functions[i]->code_entry] = true;
+
+    uint16_t fusedLength = 0;
+    for (uint16_t i=0; i<instructionsLength; i++)
+    {
+      Instruction instruction = instructions[i];
+      indexMap[i] = fusedLength;
+      if (i + 1 < instructionsLength && !isTarget[i + 1] && fusePair(&instruction, &instructions[i + 1]))
+        indexMap[++i] = fusedLength;
+      instructions[fusedLength++] = instruction;
+    }
+
+    for (uint16_t i=0; i<fusedLength; i++)
+      if (instructions[i].opCode >= R_Jump && instructions[i].opCode <= R_ForNext)
+        instructions[i].address = indexMap[instructions[i].address];
+    for (uint8_t i=0; i<functionsIndex; i++)
+      functions[i]->code_entry = indexMap[functions[i]->code_entry];
+
+    uint16_t fused = instructionsLength - fusedLength;
+    instructionsLength = fusedLength;
+
+    free(isTarget);
+    free(indexMap);
+
+    return fused;
+  }
+
+  void dumpSlot(uint16_t pc)
+  {
+    if (code[pc] == S_Constants)
+      DEBUG_ARTI(" %f", constants[code[pc+1]]);
+    else if (code[pc] == S_Temps)
+      DEBUG_ARTI(" t%u", code[pc+1]);
+    else if (code[pc] == S_Uniforms)
+      DEBUG_ARTI(" u%u", code[pc+1]);
+    else
+      DEBUG_ARTI(" v%u.%u", code[pc] - S_Level0, code[pc+1]);
+  }
+
+  void dump()
+  {
+    uint16_t pc = 0;
+    while (pc < length)
+    {
+      uint8_t opCode = code[pc];
+      uint8_t offset = addressOffset(pc);
+      DEBUG_ARTI("%u %s", pc, registerOpCodeToString(opCode));
+      switch (opCode)
+      {
+        case R_LoadExt:
+        case R_StoreExt:
+          dumpSlot(pc+1);
+          DEBUG_ARTI(" e%u", code[pc+3]);
+          dumpSlot(pc+4);
+          dumpSlot(pc+6);
+          break;
+        case R_CallExt:
+          dumpSlot(pc+1);
+          DEBUG_ARTI(" e%u", code[pc+3]);
+          for (uint8_t i=0; i<code[pc+4]; i++)
+            dumpSlot(pc + 5 + i * slotLength);
+          break;
+        case R_Call:
+          DEBUG_ARTI(" %s", functions[code[pc+1]]->name);
+          for (uint8_t i=0; i<code[pc+2]; i++)
+            dumpSlot(pc + 3 + i * slotLength);
+          break;
+        case R_ForLoop:
+          DEBUG_ARTI(" t%u", code[pc+1]);
+          break;
+        case R_ForCond:
+          dumpSlot(pc+1);
+          DEBUG_ARTI(" t%u", code[pc+3]);
+          dumpSlot(pc+4);
+          break;
+        case R_ForNext:
+          DEBUG_ARTI(" t%u", code[pc+1]);
+          dumpSlot(pc+2);
+          break;
+        default:
+          for (uint8_t i=1; i + 1 < instructionLength(pc) - (offset > 0?2:0); i+=slotLength)
+            dumpSlot(pc + i);
+      }
+      if (offset > 0)
+        DEBUG_ARTI(" %u", code[pc + offset] | (code[pc + offset + 1] << 8));
+      DEBUG_ARTI("\n");
+      pc += instructionLength(pc);
+    }
+  }
+
+}; //RegisterCode
+
+#define laneSlotsLength 64 //operands of a function run in lanes, a variable is a bit in ARTI::buildLanes
+#define noTarget 65535
+
+//kinds of lane slots
+#define L_Temp 0
+#define L_Constant 1
+#define L_Uniform 2 //variable only read by the function: same value in all lanes
+#define L_Input 3 //formal set by the caller for each lane
+#define L_Varying 4 //variable written by the function
+
+//the register code of a function (renderLed) run for ARTI_LANES calls at once: each operand is a lane slot holding a value per lane (structure of arrays), see ARTI::runLanes
+class LaneCode
+{
+public:
+  Symbol *function_symbol;
+  uint16_t entry; //first instruction
+  uint16_t end; //R_Return
+  uint8_t (*slots)[nrOfOperands] = nullptr; //lane slot of the operands of instructions entry..end
+  Operand operands[laneSlotsLength]; //operand of each lane slot
+  uint8_t kinds[laneSlotsLength];
+  uint8_t slotsLength = 0;
+  uint64_t written = 0; //lane slots of the variables written, the value of the last lane is stored after a run
+  float (*values)[ARTI_LANES] = nullptr; //value of each lane slot per lane
+
+  LaneCode(Symbol *function_symbol, uint16_t entry, uint16_t end)
+  {
+    this->function_symbol = function_symbol;
+    this->entry = entry;
+    this->end = end;
+    slots = (uint8_t (*)[nrOfOperands])calloc(end - entry + 1, sizeof(slots[0]));
+    values = (float (*)[ARTI_LANES])calloc(laneSlotsLength, sizeof(values[0]));
+    if (slots == nullptr || values == nullptr)
+    {
+      ERROR_ARTI("LaneCode: no memory for %u instructions\n", end - entry + 1);
+      errorOccurred = true;
+    }
+  }
+
+  ~LaneCode()
+  {
+    free(slots);
+    free(values);
+    MEMORY_ARTI("Destruct LaneCode (%u)\n", FREE_SIZE);
+  }
+
+  //lane slot of an operand, added if new, laneSlotsLength if no slots left
+  uint8_t laneSlot(Operand operand, uint8_t kind)
+  {
+    for (uint8_t i=0; i<slotsLength; i++)
+      if (operands[i].base == operand.base && operands[i].index == operand.index)
+        return i;
+    if (slotsLength >= laneSlotsLength)
+      return laneSlotsLength;
+    operands[slotsLength] = operand;
+    kinds[slotsLength] = kind;
+    return slotsLength++;
+  }
+
+  //operands read by an instruction which can run in lanes (bit i: operands[i]), noTarget if it cannot
+  static uint16_t readOperands(uint8_t opCode)
+  {
+    switch (opCode)
+    {
+      case R_Return:
+      case R_Jump:
+        return 0;
+      case R_JumpIfNot:
+        return 0x01;
+      case R_Move:
+      case R_Neg:
+        return 0x02;
+      case R_StoreExt:
+        return 0x07;
+      case R_CallExt:
+      case R_CallExtStore:
+        return 0x3E;
+      case R_MulAdd:
+      case R_MulSub:
+      case R_MulMul:
+      case R_DivMul:
+      case R_AddMul:
+        return 0x0E;
+      default:
+        if (opCode == R_LoadExt || (opCode >= R_Add && opCode <= R_Or))
+          return 0x06;
+        return noTarget; //calls and for loops run per call
+    }
+  }
+
+  //operands[0] is the result
+  static bool writesOperand(uint8_t opCode)
+  {
+    return opCode != R_Return && opCode != R_Jump && opCode != R_JumpIfNot && opCode != R_StoreExt && opCode != R_CallExtStore;
+  }
+
+}; //LaneCode
+
+#if ARTI_THREADS
+
+#define parallelChunk 64 //calls per chunk of work, a multiple of ARTI_LANES
+#define nrOfThreads 16
+
+class ARTI;
+
+//sets the formals of a call of a function run by ARTI::runParallel
+typedef void (*FormalsFunction)(uint16_t call, float *formals);
+
+//threads running the calls of a function (renderLed), see ARTI::runParallel
+//the chunks of calls are divided over the workers, a worker done with its own chunks steals the chunks left of the others. Worker 0 runs on the calling thread
+struct ParallelPool
+{
+  ARTI *workers[nrOfThreads]; //copies of the ARTI with their own stacks, see ARTI::newWorker
+  std::thread threads[nrOfThreads]; //threads[0] not used
+  std::atomic<uint32_t> next[nrOfThreads]; //next chunk of each worker
+  uint32_t end[nrOfThreads]; //after the last chunk of each worker
+  uint8_t size = 0;
+
+  std::mutex mutex;
+  std::condition_variable started;
+  std::condition_variable finished;
+  uint32_t generation = 0; //incremented for each run
+  uint8_t running = 0; //threads still working on the run
+  bool stop = false;
+
+  //the run
+  Symbol *function_symbol = nullptr;
+  uint8_t nrOfFormals = 0;
+  uint16_t count = 0;
+  FormalsFunction setFormals = nullptr;
+  std::atomic<bool> failed;
+  std::atomic<uint8_t> last; //worker which ran the last call
+};
+
+#endif
+
+#if ARTI_JIT
+
+//native code of an entry of the register code (program or function): bases as in executeRegisters, arti for the helpers
+typedef bool (*JitFunction)(float **bases, void *arti);
+
+//jump targets which are not instructions, see JitCode::finish
+#define jitReturn 65535 //return !errorOccurred
+#define jitFalse 65534 //return false
+
+struct JitFixup {
+  uint32_t pos; //rel32 to patch
+  uint16_t target; //instruction index, jitReturn or jitFalse
+};
+
+//x86-64 machine code of the decoded register code (System V calling convention), see ARTI::jit
+//rbx: bases, r12: arti, operands are loaded in xmm registers and stored after each instruction like executeRegisters
+class JitCode
+{
+public:
+  uint8_t *code = nullptr;
+  uint32_t size = 0; //allocated bytes
+  uint32_t length = 0; //used bytes
+  uint8_t *executable = nullptr; //mapped copy of code, see finish
+  uint32_t *labels = nullptr; //offset of each instruction
+  uint32_t *entries = nullptr; //offset of the entry of an instruction, 0 if no entry
+  JitFixup *fixups = nullptr;
+  uint16_t fixupsLength = 0;
+  uint16_t fixupsSize = 0;
+  uint32_t returnLabel = 0;
+  uint32_t falseLabel = 0;
+
+  JitCode(uint16_t instructionsLength)
+  {
+    labels = (uint32_t *)calloc(instructionsLength, sizeof(uint32_t));
+    entries = (uint32_t *)calloc(instructionsLength, sizeof(uint32_t));
+    if (labels == nullptr || entries == nullptr)
+    {
+      ERROR_ARTI("JitCode: no memory for %u instructions\n", instructionsLength);
+      errorOccurred = true;
+    }
+  }
+
+  ~JitCode()
+  {
+    free(code);
+    free(labels);
+    free(entries);
+    free(fixups);
+    if (executable != nullptr)
+      munmap(executable, length);
+    MEMORY_ARTI("Destruct JitCode (%u)\n", FREE_SIZE);
+  }
+
+  void emit(uint8_t byte)
+  {
+    if (length >= size)
+    {
+      uint32_t newSize = size == 0 ? 1024 : size * 2;
+      uint8_t *newCode = (uint8_t *)realloc(code, newSize);
+      if (newCode == nullptr)
+      {
+        ERROR_ARTI("JitCode: no memory for %u bytes\n", newSize);
+        errorOccurred = true;
+        return;
+      }
+      code = newCode;
+      size = newSize;
+    }
+    code[length++] = byte;
+  }
+
+  //count bytes of machine code
+  void emitBytes(uint8_t count, ...)
+  {
+    va_list argp;
+    va_start(argp, count);
+    for (uint8_t i=0; i<count; i++)
+      emit(va_arg(argp, int));
+    va_end(argp);
+  }
+
+  void emitUint32(uint32_t value)
+  {
+    for (uint8_t i=0; i<4; i++)
+      emit((value >> (8 * i)) & 0xFF);
+  }
+
+  void emitUint64(uint64_t value)
+  {
+    for (uint8_t i=0; i<8; i++)
+      emit((value >> (8 * i)) & 0xFF);
+  }
+
+  //rel32 of a jump to target, patched in finish
+  void emitTarget(uint16_t target)
+  {
+    if (fixupsLength >= fixupsSize)
+    {
+      uint16_t newSize = fixupsSize == 0 ? 64 : fixupsSize * 2;
+      JitFixup *newFixups = (JitFixup *)realloc(fixups, newSize * sizeof(JitFixup));
+      if (newFixups == nullptr)
+      {
+        ERROR_ARTI("JitCode: no memory for %u jumps\n", newSize);
+        errorOccurred = true;
+        return;
+      }
+      fixups = newFixups;
+      fixupsSize = newSize;
+    }
+    fixups[fixupsLength].pos = length;
+    fixups[fixupsLength].target = target;
+    fixupsLength++;
+    emitUint32(0);
+  }
+
+  void jump(uint16_t target) //jmp rel32
+  {
+    emit(0xE9);
+    emitTarget(target);
+  }
+
+  void jumpIf(uint8_t condition, uint16_t target) //jcc rel32 e.g. 0x84 jz, 0x85 jnz, 0x8A jp
+  {
+    emitBytes(2, 0x0F, condition);
+    emitTarget(target);
+  }
+
+  void loadBits(uint8_t xmm, uint32_t bits)
+  {
+    emit(0xB8); //mov eax, imm32
+    emitUint32(bits);
+    emitBytes(4, 0x66, 0x0F, 0x6E, 0xC0 | (xmm << 3)); //movd xmm, eax
+  }
+
+  void loadFloat(uint8_t xmm, float value)
+  {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+    loadBits(xmm, bits);
+  }
+
+  void loadBase(uint8_t base)
+  {
+    emitBytes(3, 0x48, 0x8B, 0x83); //mov rax, [rbx + disp32]: S_Uniforms * 8 does not fit in a signed byte
+    emitUint32(base * sizeof(float *));
+  }
+
+  //constants are immediates, other operands are read from their base
+  void loadOperand(uint8_t xmm, Operand operand, float *constants)
+  {
+    if (operand.base == S_Constants)
+      loadFloat(xmm, constants[operand.index]);
+    else
+    {
+      loadBase(operand.base);
+      emitBytes(4, 0xF3, 0x0F, 0x10, 0x80 | (xmm << 3)); //movss xmm, [rax + disp32]
+      emitUint32(operand.index * sizeof(float));
+    }
+  }
+
+  void storeOperand(Operand operand)
+  {
+    loadBase(operand.base);
+    emitBytes(4, 0xF3, 0x0F, 0x11, 0x80); //movss [rax + disp32], xmm0
+    emitUint32(operand.index * sizeof(float));
+  }
+
+  //address of bases[base][index] in rdi (7) or rsi (6)
+  void loadAddress(uint8_t reg, uint8_t base, uint8_t index)
+  {
+    loadBase(base);
+    emitBytes(3, 0x48, 0x8D, 0x80 | (reg << 3)); //lea reg, [rax + disp32]
+    emitUint32(index * sizeof(float));
+  }
+
+  void call(const void *function)
+  {
+    emitBytes(2, 0x48, 0xB8); //mov rax, imm64
+    emitUint64((uintptr_t)function);
+    emitBytes(2, 0xFF, 0xD0); //call rax
+  }
+
+  void jumpIfError()
+  {
+    emitBytes(2, 0x48, 0xB8); //mov rax, &errorOccurred
+    emitUint64((uintptr_t)&errorOccurred);
+    emitBytes(3, 0x80, 0x38, 0x00); //cmp byte [rax], 0
+    jumpIf(0x85, jitFalse);
+  }
+
+  //shared exits of all entries
+  void exits()
+  {
+    returnLabel = length;
+    emitBytes(2, 0x48, 0xB8); //mov rax, &errorOccurred
+    emitUint64((uintptr_t)&errorOccurred);
+    emitBytes(3, 0x0F, 0xB6, 0x00); //movzx eax, byte [rax]
+    emitBytes(3, 0x83, 0xF0, 0x01); //xor eax, 1
+    emitBytes(2, 0xEB, 0x02); //jmp exit
+    falseLabel = length;
+    emitBytes(2, 0x31, 0xC0); //xor eax, eax
+    emitBytes(4, 0x48, 0x83, 0xC4, 0x08); //exit: add rsp, 8
+    emitBytes(2, 0x41, 0x5C); //pop r12
+    emit(0x5B); //pop rbx
+    emit(0xC3); //ret
+  }
+
+  //entry of the program or a function: save registers, rbx = bases, r12 = arti, jump to the instruction
+  void entry(uint16_t index)
+  {
+    entries[index] = length;
+    emit(0x53); //push rbx
+    emitBytes(2, 0x41, 0x54); //push r12
+    emitBytes(4, 0x48, 0x83, 0xEC, 0x08); //sub rsp, 8: stack aligned at calls
+    emitBytes(3, 0x48, 0x89, 0xFB); //mov rbx, rdi
+    emitBytes(3, 0x49, 0x89, 0xF4); //mov r12, rsi
+    jump(index);
+  }
+
+  //patches the jumps and maps the code executable
+  bool finish()
+  {
+    if (errorOccurred) return false;
+
+    for (uint16_t i=0; i<fixupsLength; i++)
+    {
+      uint32_t target = fixups[i].target == jitReturn?returnLabel:fixups[i].target == jitFalse?falseLabel:labels[fixups[i].target];
+      int32_t rel = (int32_t)target - (int32_t)(fixups[i].pos + 4);
+      memcpy(code + fixups[i].pos, &rel, sizeof(int32_t));
+    }
+
+    void *memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+      WARNING_ARTI("JitCode: no executable memory for %u bytes\n", length);
+      return false;
+    }
+    memcpy(memory, code, length);
+    if (mprotect(memory, length, PROT_READ | PROT_EXEC) != 0)
+    {
+      WARNING_ARTI("JitCode: memory of %u bytes cannot be executed\n", length);
+      munmap(memory, length);
+      return false;
+    }
+    executable = (uint8_t *)memory;
+
+    //only the executable copy is needed
+    free(code); code = nullptr;
+    size = 0;
+    return true;
+  }
+
+  JitFunction function(uint16_t index)
+  {
+    return (JitFunction)(executable + entries[index]);
+  }
+
+}; //JitCode
+
+#endif
+
+//values on the stack while compiling
+#define C_Statements 0 //values are not used (e.g. call as statement)
+#define C_Values 1 //values are counted (e.g. actuals, indices, conditions)
+#define C_Expression 2 //values are combined by the operators into one value (expr, term in postfix order)
+
+struct CompileContext {
+  uint8_t kind;
+  uint8_t values;
+};
+
+#define nrOfContexts 50
+
+class ARTI;
+struct Closure;
+
+typedef float (*ClosureFunction)(ARTI *arti, Closure *closure);
+
+//a node of the program bound to the function which executes it, see buildClosures
+struct Closure {
+  ClosureFunction function;
+  Closure *children[3]; //operands, arguments, indices, condition and blocks
+  Closure *next; //next statement in a block or next argument or index
+  Symbol *symbol; //called function
+  float value; //constant
+  uint8_t level; //variable
+  uint8_t index; //variable
+  uint8_t external; //external function or variable
+  uint8_t count; //number of arguments or indices
+};
+
+#define closuresPerChunk 32
+
+//closures are allocated in chunks and freed all at once
+struct ClosureChunk {
+  ClosureChunk *next;
+  Closure closures[closuresPerChunk];
+};
+
+class ARTI {
+private:
+  Grammar *grammar = nullptr; //only used while parsing
+  Lexer *lexer = nullptr;
+
+  DynamicJsonDocument *definitionJsonDoc = nullptr;
+  DynamicJsonDocument *parseTreeJsonDoc = nullptr;
+  JsonObject definitionJson;
+  JsonVariant parseTreeJson;
+
+  ScopedSymbolTable *global_scope = nullptr;
+  SyntaxTree *syntaxTree = nullptr;
+  uint16_t astParent = noNode; //only used while building the syntax tree
+  uint16_t astLast = noNode; //only used while building the syntax tree
+  Symbol *hoistFunction = nullptr; //only used while hoisting, see hoist
+  Symbol *hoistInvariants = nullptr; //only used while hoisting
+  uint16_t hoistLast = noNode; //only used while hoisting: last assignment of hoistInvariants
+  uint16_t hoistWritten[arrayLength]; //only used while hoisting: variables assigned by hoistFunction (level << 8 | index)
+  uint8_t hoistWrittenLength = 0;
+  uint8_t hoistCount = 0;
+  CallStack *callStack = nullptr;
+  uint16_t arenaLength = 0; //floats of the arena of the callStack, see sizeArena
+  Symbol *arenaVisiting[nrOfRecords]; //only used while sizing the arena: functions being called
+  bool arenaRecursive = false; //only used while sizing the arena
+  float uniforms[nrOfUniforms]; //values of the frame constant externals, see snapshotUniforms
+  uint8_t uniformExternals[nrOfUniforms]; //external of each uniform: marked frameConstant in the definition
+  uint8_t uniformsLength = 0;
+  const char *frameNotSkippable = nullptr; //why frames cannot be skipped, see checkFrameSkipping
+  uint32_t uniformsRead = 0; //bit of each uniform read by the program
+  float previousUniforms[nrOfUniforms]; //uniforms of the previous frame, see skipFrame
+  float *previousRecord = nullptr; //program record at the start of the previous frame
+  FrameInput frameInputs[nrOfFrameInputs]; //frameInput externals read in the previous frame
+  uint8_t frameInputsLength = 0;
+  bool frameInputsRecording = false; //only used while running a frame
+  bool frameInputsOverflow = false; //more than nrOfFrameInputs read (or on threads), not compared
+  bool frameInputsValid = false; //the previous frame ran completely
+  ValueStack *valueStack = nullptr;
+  ColorTable colors; //colors with white made by the externals, see colorToValue
+
+  uint8_t engine = E_TreeWalker;
+  ByteCode *byteCode = nullptr;
+  RegisterCode *registerCode = nullptr;
+  #if ARTI_JIT
+    JitCode *jitCode = nullptr;
+  #endif
+  LaneCode *laneCode = nullptr; //see buildLanes
+  bool lanesBuilt = false;
+  #if ARTI_THREADS
+    ParallelPool *parallelPool = nullptr; //see runParallel
+    Symbol *parallelFunction = nullptr; //function whose calls can run in parallel, see checkParallel
+    uint8_t parallelIndices = 0; //see parallelSupported
+    uint32_t parallelAssigned = 0; //only used while checking: variables of the program record assigned by parallelFunction
+    const char *parallelNotSupported = nullptr; //only used while checking
+  #endif
+
+  Closure *closureProgram = nullptr; //main block, see buildClosures
+  ClosureChunk *closureChunks = nullptr;
+  uint8_t closureChunkIndex = 0;
+  uint16_t closuresLength = 0;
+  Closure *closureValues[arrayLength]; //only used while building
+  uint8_t closureValuesIndex = 0;
+  Closure **statementsTail = nullptr; //only used while building
+  Closure *lastAssigned = nullptr; //only used while building
+  uint8_t closureMaxLevel = 0;
+  float *closureBases[nrOfRecords]; //floatMembers of the activation record of each level
+  CompileContext contexts[nrOfContexts]; //only used while compiling
+  uint8_t contextsIndex = 0;
+  bool compileError = false; //construct not supported by compile: fall back to interpret
+
+  #if ARTI_PLATFORM != ARTI_ARDUINO
+    FILE *transpileFile = nullptr; //only used while transpiling
+    const char *transpileReceiver = ""; //object of the external functions and variables e.g. strip.
+    uint16_t transpileTemps = 0;
+    bool transpileMain = false; //in the main block all variables are in the program record
+    bool transpileError = false;
+    bool transpileUsesAr = false; //the function uses its record, see transpile
+    bool transpileUsesParent = false;
+  #endif
+
+  uint8_t stages = 5; //for debugging: 0:parseFile, 1:Lexer, 2:parse, 3:optimize, 4:analyze, 5:interpret should be 5 if no debugging
+
+  char logFileName[fileNameLength];
+
+  uint32_t startMillis;
+
+public:
+  bool superinstructions = true; //E_RegisterVM: fuse frequent pairs of instructions (see RegisterCode::fuse)
+  bool lanes = true; //E_RegisterVM: run renderLed for ARTI_LANES pixels at once (see runLanes)
+  bool hoisting = true; //subexpressions of renderLed which are the same for all leds run once per frame (see hoist)
+  uint8_t threads = 1; //ARTI_THREADS: renderLed runs on this many threads (see runParallel), 1: on the calling thread only
+  bool frameSkipping = true; //frames the same as the previous frame are not run (see skipFrame)
+  bool fastMath = false; //math externals use lookup tables instead of libm (see the definition plugin), also set by "fastMath": true in the meta of the definition
+
+  ARTI() 
+  {
+    // MEMORY_ARTI("new Arti < %u\n", FREE_SIZE); //logfile not open here
+  }
+
+  ~ARTI() 
+  {
+    MEMORY_ARTI("Destruct ARTI\n");
+  }
+
+  //a color as a value of the program and back, see ColorTable. The definition reclaims the colors of a frame at the start of the next one
+  float colorToValue(uint32_t color)
+  {
+    return colors.value(color);
+  }
+
+  uint32_t valueToColor(float value)
+  {
+    return colors.color(value);
+  }
+
+  //defined in arti_definition.h e.g. arti_wled.h!
+  float arti_external_function(uint8_t function, float par1 = floatNull, float par2 = floatNull, float par3 = floatNull, float par4 = floatNull, float par5 = floatNull);
+  float arti_get_external_variable(uint8_t variable, float par1 = floatNull, float par2 = floatNull, float par3 = floatNull);
+  void arti_set_external_variable(float value, uint8_t variable, float par1 = floatNull, float par2 = floatNull, float par3 = floatNull);
+  uint8_t arti_external_state(uint8_t external); //external representing the state an external reads or changes, noExternal if it only depends on its parameters
+  uint8_t arti_external_frame(uint8_t external); //frameIndependent, frameInput or frameDependent, see skipFrame
+  void arti_external_store_call(uint8_t variable, uint8_t function, float par1, float par2, float par3, float index1, float index2); //variable[index1, index2] = function(par1, par2, par3), see R_CallExtStore
+  bool loop(); 
+  #if ARTI_PLATFORM != ARTI_ARDUINO
+    void transpileLoop(); //writes the loop of a transpiled program, see transpile
+  #endif
+  
+  //expression is an array of the grammar (G_Sequence)
+  uint8_t parse(JsonVariant parseTree, const char * node_name, char operatorx, uint16_t expression, uint8_t depth = 0) 
+  {
+    if (depth > 50) 
+    {
+      ERROR_ARTI("Error: Parse recursion level too deep at %s (%u)\n", parseTree.as<std::string>().c_str(), depth);
+      errorOccurred = true;
+    }
+    if (errorOccurred) return ResultFail;
+
+    //FIRST set: fails without trying if the current token cannot start the expression
+    if (!grammar->canStart(expression, lexer->current_token()->kind))
+      return ResultFail;
+
+    uint8_t result = ResultContinue;
+
+    uint8_t resultChild = ResultContinue;
+
+    GrammarElement *sequence = &grammar->elements[expression];
+    if (sequence->type == G_Sequence) //should always be the case
+    {
+      for (uint16_t expressionElement = sequence->index; expressionElement < sequence->index + sequence->length; expressionElement++) //e.g. ["PROGRAM","ID","block"]
+      {
+        //one token lookahead: an alternative which cannot start with the current token is not tried
+        if (operatorx == '|' && !grammar->canStart(expressionElement, lexer->current_token()->kind))
+          continue;
+
+        const char * nextNode_name = node_name; //e.g. "program": 
+        uint16_t nextExpression = expressionElement; // e.g. block
+        JsonVariant nextParseTree = parseTree;
+
+        uint16_t node = grammar->elements[expressionElement].type == G_Node?grammar->elements[expressionElement].index:noElement;
+
+        if (node != noElement) //is expressionElement a Node e.g. "block" : ["LCURL",{"*": ["statement"]},"RCURL"]
+        {
+          nextNode_name = grammar->nodes[node].name; //e.g. block
+          nextExpression = grammar->nodes[node].element; // e.g. ["LCURL",{"*": ["statement"]},"RCURL"]
+
+          // DEBUG_ARTI("%s %s %u\n", spaces+50-depth, nextNode_name, depth); //, parseTree.as<std::string>().c_str()
+
+          if (parseTree.is<JsonArray>()) 
+          {
+            parseTree[parseTree.size()][nextNode_name]["connect"] = "array";
+            nextParseTree = parseTree[parseTree.size()-1]; //nextparsetree is last element in the array (which is always an object)
+          }
+          else //no list, create object
+          { 
+            if (parseTree[node_name].isNull()) //no object yet
+              parseTree[node_name]["connect"] = "object"; //make the connection, new object item
+
+            nextParseTree = parseTree[node_name];
+          }
+        }
+
+        uint16_t token = lexer->token; //backtrack to here if an alternative fails
+
+        if (grammar->elements[nextExpression].type == G_Object) // e.g. {"?":["LPAREN","formals*","RPAREN"]}
+        {
+          char objectOperator = grammar->elements[nextExpression].operatorx;
+          uint16_t objectElement = grammar->elements[nextExpression].index;
+
+          if (objectOperator == '*' || objectOperator == '+') 
+          {
+            nextParseTree[nextNode_name]["*"][0] = "multiple"; // * is another object in the list of objects
+            nextParseTree = nextParseTree[nextNode_name]["*"];
+          }
+
+          //and: see 'is array'
+          if (objectOperator == '|') 
+          {
+            resultChild = parse(nextParseTree, nextNode_name, objectOperator, objectElement, depth + 1);
+            if (resultChild != ResultFail) resultChild = ResultContinue;
+          }
+          else 
+          {
+            uint8_t resultChild2 = ResultContinue;
+            uint8_t counter = 0;
+            while (resultChild2 == ResultContinue) 
+            {
+              resultChild2 = parse(nextParseTree, nextNode_name, objectOperator, objectElement, depth + 1); //no assign to result as optional
+
+              if (objectOperator == '?') { //zero or one iteration, also continue if parse not continue
+                resultChild2 = ResultContinue;
+                break; 
+              }
+              else if (objectOperator == '+') { //one or more iterations, stop if first parse not continue
+                if (counter == 0) {
+                  if (resultChild2 != ResultContinue)
+                    break;
+                } 
+                else 
+                {
+                  if (resultChild2 != ResultContinue) 
+                  {
+                    resultChild2 = ResultContinue;  //always continue
+                    break;
+                  }
+                }
+              }
+              else if (objectOperator == '*') //zero or more iterations, stop if parse not continue
+              {
+                if (resultChild2 != ResultContinue) 
+                {
+                  resultChild2 = ResultContinue;  //always continue
+                  break;
+                }
+              }
+              counter++;
+            } //while
+            resultChild = resultChild2;
+          } //not or
+        }
+        else if (grammar->elements[nextExpression].type == G_Sequence) // e.g. ["LPAREN", "expr*", "RPAREN"]
+        {
+          resultChild = parse(nextParseTree, nextNode_name, '&', nextExpression, depth + 1); // every array element starts with '&' (operatorx is for result of all elements of array)
+        }
+        else if (grammar->elements[nextExpression].type == G_Token) // token e.g. "ID"
+        {
+          uint8_t token_kind = grammar->elements[nextExpression].index;
+          if (lexer->current_token()->kind == token_kind) 
+          {
+            DEBUG_ARTI("%s %s %.*s", spaces+50-depth, grammar->tokenNames[token_kind], lexer->current_token()->length, lexer->text + lexer->current_token()->pos);
+
+            //only add 'semantic tokens'
+            if (grammar->tokenSemantic[token_kind])
+            {
+              if (nextParseTree.is<JsonArray>()) 
+                nextParseTree.as<JsonArray>()[nextParseTree.size()][grammar->tokenNames[token_kind]] = lexer->value(); //add in last element of array
+              else
+                nextParseTree[nextNode_name][grammar->tokenNames[token_kind]] = lexer->value();
+            }
+
+            lexer->eat(token_kind);
+
+            DEBUG_ARTI(" -> [%s %.*s] %d\n", lexer->current_token()->kind != endKind?grammar->tokenNames[lexer->current_token()->kind]:"", lexer->current_token()->length, lexer->text + lexer->current_token()->pos, depth);
+
+            resultChild = ResultContinue;
+          }
+          else //deadend
+            resultChild = ResultFail;
+        } // if token
+
+        if (node != noElement) //if node
+        {
+          if (nextParseTree.containsKey("connect"))
+            nextParseTree.remove("connect"); //remove connector
+          // for values which are not parsed deeper. e.g. : {"formal": {"ID": "z"}}
+          for (JsonPair parseTreePair : nextParseTree.as<JsonObject>()) 
+          {
+            JsonVariant value = parseTreePair.value();
+            if (value.containsKey("connect"))
+              value.remove("connect"); //remove connector
+          }
+
+          if (resultChild == ResultFail) { //remove result of parse
+            nextParseTree.remove(nextNode_name); //remove the failed stuff
+
+            // DEBUG_ARTI("%s fail %s\n", spaces+50-depth, nextNode_name);
+          }
+          else //success
+          {
+            DEBUG_ARTI("%s found %s\n", spaces+50-depth, nextNode_name);//, nextParseTree.as<std::string>().c_str());
+            //parseTree optimization moved to optimize function
+
+            // if (nextParseTree.is<JsonObject>())
+            // {
+
+            //   // optimize(nextParseTree, depth);
+
+            //   JsonObject innerObject = nextParseTree[nextNode_name].as<JsonObject>();
+
+            //   JsonObject::iterator begin = innerObject.begin();
+            //   if (fnextParseTree.size() == 1 && nextParseTree[nextNode_name].size() == 1 && lexer->definitionJson.containsKey(nextNode_name) && lexer->definitionJson.containsKey(nextNode_name) && lexer->definitionJson.containsKey(begin->key()))
+            //   {
+            //     // JsonObject nextParseTreeObject = nextParseTree.as<JsonObject>();
+
+            //     DEBUG_ARTI("%s found %s:%s\n", spaces+50-depth, node_name, parseTree.as<std::string>().c_str());
+            //     DEBUG_ARTI("%s found replace %s by %s %s\n", spaces+50-depth, nextNode_name, begin->key().c_str(), nextParseTree.as<std::string>().c_str());
+            //     DEBUG_ARTI("%s expression %s\n", spaces+50-depth, expression.as<std::string>().c_str());
+            //     DEBUG_ARTI("%s found %s\n", spaces+50-depth, nextParseTree[nextNode_name].as<std::string>().c_str());
+
+            //     nextParseTree.remove(nextNode_name);
+            //     // char temp[charLength];
+            //     // strcpy(temp, nextNode_name);
+            //     // strcat(temp, "-");
+            //     // strcat(temp, begin->key().c_str());
+            //     nextParseTree[begin->key()] = begin->value();
+
+            //     DEBUG_ARTI("%s found %s:%s\n", spaces+50-depth, node_name, parseTree.as<std::string>().c_str());
+            //   }
+            // }
+            // else
+            //   DEBUG_ARTI("%s no jsonobject??? %s\n", spaces+50-depth, parseTree.as<std::string>().c_str());
+
+          }
+        } // if node
+
+        //determine result of expressionElement
+        if (operatorx == '|') {
+          if (resultChild == ResultFail) {//if fail, go back and try another
+            // result = ResultContinue;
+            lexer->token = token;
+          }
+          else
+            result = ResultStop;  //Stop or continue is enough for an or
+        }
+        else {
+          if (resultChild != ResultContinue) //for and, ?, + and *; each result should continue
+            result = ResultFail;
+        } 
+
+        if (result != ResultContinue) //if no reason to continue then stop
+          break;
+
+      } //for expressionElement
+
+      if (operatorx == '|') 
+      {
+        if (result != ResultStop) //still looking but nothing to look for
+          result = ResultFail;
+      }
+    }
+    else { //should never happen
+      ERROR_ARTI("%s Programming error: no array %s %c\n", spaces+50-depth, stringOrEmpty(node_name), operatorx);
+    }
+
+    return result;
+
+  } //parse
+
+  bool analyze(JsonVariant parseTree, const char * treeElement = nullptr, ScopedSymbolTable* current_scope = nullptr, uint8_t depth = 0) 
+  {
+    // ANDBG_ARTI("%s Depth %u %s\n", spaces+50-depth, depth, parseTree.as<std::string>().c_str());
+    if (depth > 24) //otherwise stack canary errors on Arduino (value determined after testing, should be revisited)
+    {
+      ERROR_ARTI("Error: Analyze recursion level too deep at %s (%u)\n", parseTree.as<std::string>().c_str(), depth);
+      errorOccurred = true;
+    }
+    if (errorOccurred) return false;
+
+    if (parseTree.is<JsonObject>()) 
+    {
+      for (JsonPair parseTreePair : parseTree.as<JsonObject>()) 
+      {
+        const char * key = parseTreePair.key().c_str();
+        JsonVariant value = parseTreePair.value();
+        if (treeElement == nullptr || strcmp(treeElement, key) == 0 ) //in case there are more elements in the object and you want to analyze only one
+        {
+          bool visitedAlready = false;
+
+          if (strcmp(key, "*") == 0 ) // multiple
+          {
+          }
+          else if (strcmp(key, "token") == 0) // do nothing with added tokens
+            visitedAlready = true;
+          else if (this->definitionJson["TOKENS"].containsKey(key)) // if token
+          {
+           const char * valueStr = value;
+
+            if (strcmp(key, "INTEGER_CONST") == 0)
+              parseTree["token"] = F_integerConstant;
+            else if (strcmp(key, "REAL_CONST") == 0)
+              parseTree["token"] = F_realConstant;
+            else if (strcmp(valueStr, "+") == 0)
+              parseTree["token"] = F_plus;
+            else if (strcmp(valueStr, "-") == 0)
+              parseTree["token"] = F_minus;
+            else if (strcmp(valueStr, "*") == 0)
+              parseTree["token"] = F_multiplication;
+            else if (strcmp(valueStr, "/") == 0)
+              parseTree["token"] = F_division;
+            else if (strcmp(valueStr, "%") == 0)
+              parseTree["token"] = F_modulo;
+            else if (strcmp(valueStr, "<<") == 0)
+              parseTree["token"] = F_bitShiftLeft;
+            else if (strcmp(valueStr, ">>") == 0)
+              parseTree["token"] = F_bitShiftRight;
+            else if (strcmp(valueStr, "==") == 0)
+              parseTree["token"] = F_equal;
+            else if (strcmp(valueStr, "!=") == 0)
+              parseTree["token"] = F_notEqual;
+            else if (strcmp(valueStr, ">") == 0)
+              parseTree["token"] = F_greaterThen;
+            else if (strcmp(valueStr, ">=") == 0)
+              parseTree["token"] = F_greaterThenOrEqual;
+            else if (strcmp(valueStr, "<") == 0)
+              parseTree["token"] = F_lessThen;
+            else if (strcmp(valueStr, "<=") == 0)
+              parseTree["token"] = F_lessThenOrEqual;
+            else if (strcmp(valueStr, "&&") == 0)
+              parseTree["token"] = F_and;
+            else if (strcmp(valueStr, "||") == 0)
+              parseTree["token"] = F_or;
+            else
+              ERROR_ARTI("%s Programming error: token not defined as operator %s %s (%u)\n", spaces+50-depth, key, value.as<std::string>().c_str(), depth);
+
+            visitedAlready = true;
+          }
+          else //if key is node_name
+          {
+            uint8_t node = stringToNode(key);
+
+            switch (node) 
+            {
+              case F_Program: 
+              {
+                const char * program_name = value["ID"];
+                global_scope = new ScopedSymbolTable(program_name, 1, nullptr); //current_scope
+
+                ANDBG_ARTI("%s Program %s %u %u\n", spaces+50-depth, global_scope->scope_name, global_scope->scope_level, global_scope->symbolsIndex); 
+
+                if (value["ID"].isNull()) {
+                  ERROR_ARTI("program name null\n");
+                  errorOccurred = true;
+                }
+                if (value["block"].isNull()) {
+                  ERROR_ARTI("%s Program %s: no block in parseTree\n", spaces+50-depth, program_name); 
+                  errorOccurred = true;
+                }
+                else {
+                  analyze(value["block"], nullptr, global_scope, depth + 1);
+                }
+
+                #ifdef ARTI_DEBUG
+                  for (uint8_t i=0; i<global_scope->symbolsIndex; i++) {
+                    Symbol* symbol = global_scope->symbols[i];
+                    ANDBG_ARTI("%s %u %s %s.%s of %u (%u)\n", spaces+50-depth, i, nodeToString(symbol->symbol_type), global_scope->scope_name, symbol->name, symbol->type, symbol->scope_level); 
+                  }
+                #endif
+
+                visitedAlready = true;
+                break;
+              }
+              case F_Function: 
+              {
+                //find the function name (so we must know this is a function...)
+                const char * function_name = value["ID"];
+                Symbol* function_symbol = new Symbol(node, function_name);
+                current_scope->insert(function_symbol);
+
+                ANDBG_ARTI("%s Function %s.%s\n", spaces+50-depth, current_scope->scope_name, function_name);
+                ScopedSymbolTable* function_scope = new ScopedSymbolTable(function_name, current_scope->scope_level + 1, current_scope);
+                if (current_scope->child_scopesIndex < nrOfChildScope)
+                  current_scope->child_scopes[current_scope->child_scopesIndex++] = function_scope;
+                else
+                  ERROR_ARTI("ScopedSymbolTable %s childs full (%d)", current_scope->scope_name, nrOfChildScope);
+                function_symbol->function_scope = function_scope;
+
+                if (value.containsKey("formals"))
+                  analyze(value["formals"], nullptr, function_scope, depth + 1);
+
+                function_scope->nrOfFormals = function_scope->symbolsIndex;
+
+                if (value["block"].isNull())
+                  ERROR_ARTI("%s Function %s: no block in parseTree\n", spaces+50-depth, function_name); 
+                else
+                  analyze(value["block"], nullptr, function_scope, depth + 1);
+
+                #ifdef ARTI_DEBUG
+                  for (uint8_t i=0; i<function_scope->symbolsIndex; i++) {
+                    Symbol* symbol = function_scope->symbols[i];
+                    ANDBG_ARTI("%s %u %s %s.%s of %u (%u)\n", spaces+50-depth, i, nodeToString(symbol->symbol_type), function_scope->scope_name, symbol->name, symbol->type, symbol->scope_level); 
+                  }
+                #endif
+
+                visitedAlready = true;
+                break;
+              }
+              case F_VarDef:
+              case F_Formal:
+              case F_Assign:
+              case F_VarRef: 
+              {
+                JsonObject variable_value;
+                if (node == F_Assign) 
+                  variable_value = value["varref"];
+                else
+                  variable_value = value;
+
+                const char * variable_name;
+                variable_name = variable_value["ID"];
+
+                if (variable_value.containsKey("indices"))
+                  analyze(variable_value, "indices", current_scope, depth + 1);
+
+                //check if external variable
+                bool externalFound = false;
+                uint8_t index = 0;
+                for (JsonPair externalsPair: definitionJson["EXTERNALS"].as<JsonObject>()) {
+                  if (strcmp(variable_name, externalsPair.key().c_str()) == 0) {
+                      variable_value["external"] = index; //add external index to parseTree
+                    ANDBG_ARTI("%s Ext Variable found %s (%u) %s\n", spaces+50-depth, variable_name, depth, key);
+                    externalFound = true;
+                  }
+                  index++;
+                }
+
+                if (!externalFound) 
+                {
+                  Symbol* var_symbol = current_scope->lookup(variable_name); //lookup here and parent scopes
+                  if (node == F_VarRef) 
+                  {
+                    if (var_symbol == nullptr) 
+                      WARNING_ARTI("%s VarRef %s ID not found in scope of %s\n", spaces+50-depth, variable_name, current_scope->scope_name); 
+                      //only warning: value 0 in interpreter (div 0 is captured)
+                    else 
+                      ANDBG_ARTI("%s VarRef found %s.%s (%u)\n", spaces+50-depth, var_symbol->scope->scope_name, variable_name, depth);
+                  }
+                  else //assign and var/formal
+                  {
+                    //if variable not already defined, then add
+                    if (node != F_Assign || var_symbol == nullptr) //only assign needs to check if not exists
+                    {
+                      char param_type[charLength]; 
+                      if (variable_value.containsKey("type")) 
+                        serializeJson(variable_value["type"], param_type); //current_scope.lookup(param.type_node.value); //need string, lookup also used to find types...
+                      else
+                        strcpy(param_type, "notype");
+
+                      var_symbol = new Symbol(node, variable_name, 9); // no type support yet
+                      if (node == F_Assign)
+                        global_scope->insert(var_symbol); // assigned variables are global scope
+                      else
+                        current_scope->insert(var_symbol);
+
+                      ANDBG_ARTI("%s %s %s.%s of %s\n", spaces+50-depth, key, var_symbol->scope->scope_name, variable_name, param_type);
+                    }
+                    else if (node != F_Assign && var_symbol != nullptr)
+                      ERROR_ARTI("%s %s Duplicate ID %s.%s\n", spaces+50-depth, key, var_symbol->scope->scope_name, variable_name); 
+
+                  }
+
+                  if (var_symbol != nullptr)
+                  {
+                    variable_value["level"] = var_symbol->scope_level;
+                    variable_value["index"] = var_symbol->scope_index;;
+                  }
+                }
+
+                if (node == F_Assign) 
+                {
+                  ANDBG_ARTI("%s %s %s = (%u)\n", spaces+50-depth, key, variable_name, depth);
+
+                  if (value.containsKey("assignoperator")) 
+                  {
+                    JsonObject asop = value["assignoperator"];
+                    JsonObject::iterator asopBegin = asop.begin();
+                    ANDBG_ARTI("%s %s\n", spaces+50-depth, asopBegin->value().as<std::string>().c_str());
+                    if (strcmp(asopBegin->value(), "+=") == 0) 
+                      value["assignoperator"] = F_plus;
+                    else if (strcmp(asopBegin->value(), "-=") == 0) 
+                      value["assignoperator"] = F_minus;
+                    else if (strcmp(asopBegin->value(), "*=") == 0) 
+                      value["assignoperator"] = F_multiplication;
+                    else if (strcmp(asopBegin->value(), "/=") == 0) 
+                      value["assignoperator"] = F_division;
+                    else if (strcmp(asopBegin->value(), "++") == 0) 
+                      value["assignoperator"] = F_plusplus;
+                    else if (strcmp(asopBegin->value(), "--") == 0) 
+                      value["assignoperator"] = F_minmin;
+                  }
+
+                  if (value.containsKey("expr")) 
+                    analyze(value, "expr", current_scope, depth + 1);
+                  else if (value["assignoperator"].as<uint8_t>() != F_plusplus && value["assignoperator"].as<uint8_t>() != F_minmin)
+                  {
+                    ERROR_ARTI("%s %s %s: Assign without expression\n", spaces+50-depth, key, variable_name); 
+                    errorOccurred = true;
+                  }
+                }
+
+                visitedAlready = true;
+                break;
+              }
+              case F_Call: 
+              {
+                const char * function_name = value["ID"];
+
+                //check if external function
+                bool externalFound = false;
+                uint8_t index = 0;
+                for (JsonPair externalsPair: definitionJson["EXTERNALS"].as<JsonObject>()) 
+                {
+                  if (strcmp(function_name, externalsPair.key().c_str()) == 0) 
+                  {
+                    ANDBG_ARTI("%s Ext Function found %s (%u)\n", spaces+50-depth, function_name, depth);
+                    value["external"] = index; //add external index to parseTree 
+                    externalFound = true;
+                  }
+                  index++;
+                }
+
+                if (!externalFound) 
+                {
+                  Symbol* function_symbol = current_scope->lookup(function_name); //lookup here and parent scopes
+                  if (function_symbol == nullptr) 
+                    ERROR_ARTI("%s Function %s not found in scope of %s\n", spaces+50-depth, function_name, current_scope->scope_name); 
+                } //external functions
+
+                if (value.containsKey("actuals"))
+                  analyze(value["actuals"], nullptr, current_scope, depth + 1);
+
+                visitedAlready = true;
+                break;
+              } // case
+              default: //visitedalready false => recursive call
+                break;
+            } //switch
+          } // is node_name
+
+          if (!visitedAlready && value.size() > 0) // if size == 0 then injected key/value like operator
+            analyze(value, nullptr, current_scope, depth + 1);
+
+        } // key values
+      } ///for elements in object
+    }
+    else if (parseTree.is<JsonArray>()) 
+    {
+      for (JsonVariant newParseTree: parseTree.as<JsonArray>()) 
+        analyze(newParseTree, nullptr, current_scope, depth + 1);
+    }
+    else //not array
+    {
+      // string element = parseTree;
+      //for some weird reason this causes a crash on esp32
+      // ERROR_ARTI("%s Error: parseTree should be array or object %s (%u)\n", spaces+50-depth, parseTree.as<std::string>().c_str(), depth);
+    }
+
+    return !errorOccurred;
+  } //analyze
+
+  //https://dev.to/lefebvre/compilers-106---optimizer--ig8
+  bool optimize(JsonVariant parseTree, uint8_t depth = 0) 
+  {
+    // DEBUG_ARTI("%s optimize %s (%u)\n", spaces+50-depth, parseTree.as<std::string>().c_str(), depth);
+
+    if (parseTree.is<JsonObject>()) 
+    {
+      //make the parsetree as small as possible to let the interpreter run as fast as possible:
+
+      for (JsonPair parseTreePair : parseTree.as<JsonObject>()) 
+      {
+        const char * key = parseTreePair.key().c_str();
+        JsonVariant value = parseTreePair.value();
+
+        bool visitedAlready = false;
+
+        // object:
+        // if key is node and value is object then optimize object after that if object empty then remove key
+        // else key is !ID and value is string then remove key
+        // else key is * and value is array then optimize array after that if array empty then remove key *
+
+        // array
+        // if element is multiple then remove
+
+        if (strcmp(key, "*") == 0 ) // multiple
+        {
+          optimize(value, depth + 1);
+
+          if (value.size() == 0) 
+          {
+            parseTree.remove(key);
+            // DEBUG_ARTI("%s optimize: remove empty %s %s (%u)\n", spaces+50-depth, key, value.as<std::string>().c_str(), depth);
+          }
+
+          visitedAlready = true;
+        }
+        else if (this->definitionJson["TOKENS"].containsKey(key)) // if key is token (moved to parse)
+        {
+          visitedAlready = true;
+        }
+        else if (value.is<JsonObject>()) //if key is node_name
+        {
+          optimize(value, depth + 1);
+
+          if (value.size() == 0) 
+          {
+            // DEBUG_ARTI("%s optimize: remove key %s with empty object (%u)\n", spaces+50-depth, key, depth);
+            parseTree.remove(key);
+          }
+          else if (value.size() == 1) //try to shrink, moved to below
+          {
+            //- check if a node is not used in analyzer / interpreter and has only one element: go to the parent and replace itself with its child (shrink)
+
+            // DEBUG_ARTI("%s node try to shrink %s : %s (%u)\n", spaces+50-depth, key, value.as<std::string>().c_str(), value.size());
+
+            JsonObject::iterator objectIterator = value.as<JsonObject>().begin();
+
+            if (definitionJson.containsKey(objectIterator->key().c_str()))  // if value key is a node
+            {
+              // if (objectIterator->value().is<JsonObject>() && objectIterator->value().size() == 1) //
+              // {
+              //   // JsonObject::iterator objectIterator2 = objectIterator->value().as<JsonObject>().begin();
+
+              //   // if (objectIterator2->value().is<JsonObject>() ) //&& objectIterator.size() == 1
+              //   {
+              //     DEBUG_ARTI("%s node to shrink %s : %s from %s\n", spaces+50-depth, key, value.as<std::string>().c_str(), parseTree.as<std::string>().c_str());
+              //     DEBUG_ARTI("%s node to shrink %s : %s\n", spaces+50-depth, objectIterator->key().c_str(), objectIterator->value().as<std::string>().c_str());
+              //     // DEBUG_ARTI("%s node to shrink %s : %s\n", spaces+50-depth, objectIterator2->key().c_str(), objectIterator2->value().as<std::string>().c_str());
+              //     DEBUG_ARTI("%s node to shrink replace %s\n", spaces+50-depth, parseTree[key].as<std::string>().c_str());
+              //     DEBUG_ARTI("%s node to shrink      by %s\n", spaces+50-depth, objectIterator->value().as<std::string>().c_str());
+              //     // parseTree[key][objectIterator->key().c_str()] = objectIterator2->value();
+              //     parseTree[key] = objectIterator->value();
+              //   }
+              //   // else
+              //   // {
+              //   //   DEBUG_ARTI("%s node to shrink2 %s : %s\n", spaces+50-depth, objectIterator2->key().c_str(), objectIterator2->value().as<std::string>().c_str());
+              //   // }
+              // }
+              // else
+              //   DEBUG_ARTI("%s value should be an object %s in %s : %s from %s\n", spaces+50-depth, objectIterator->key().c_str(), key, objectIterator->value().as<std::string>().c_str(), value.as<std::string>().c_str());
+              if (stringToNode(objectIterator->key().c_str()) == F_NoNode) // if key not a node
+              // if (objectIterator->value().size() == 1)
+              {
+                DEBUG_ARTI("%s node to shrink %s in %s : %s from %s\n", spaces+50-depth, objectIterator->key().c_str(), key, value.as<std::string>().c_str(), parseTree.as<std::string>().c_str());
+                // DEBUG_ARTI("%s node to shrink %s in %s = %s from %s\n", spaces+50-depth, objectIterator->key().c_str(), key, objectIterator->value().as<std::string>().c_str(), parseTree[key].as<std::string>().c_str());
+                 parseTree[key] = objectIterator->value();
+
+                // parseTree[key]["old"] = objectIterator->key();
+
+                // parseTreePair.key() = objectIterator->key();
+                // parseTreePair._key = objectIterator->key();
+                // parseTree[objectIterator->key()] = objectIterator->value();
+                // parseTree.remove(key);
+                // parseTree[key][objectIterator2->key().c_str()] = objectIterator2->value();
+              }
+            }
+          } //shrink
+
+          visitedAlready = true;
+        }
+        else
+          ERROR_ARTI("%s Programming Error: key no node and no token %s %s (%u)\n", spaces+50-depth, key, value.as<std::string>().c_str(), depth);
+
+        if (!visitedAlready && value.size() > 0) // if size == 0 then injected key/value like operator
+          optimize(value, depth + 1);
+
+      } ///for elements in object
+
+      //shrink
+      for (JsonPair parseTreePair : parseTree.as<JsonObject>()) 
+      {
+        const char * key = parseTreePair.key().c_str();
+        JsonVariant value = parseTreePair.value();
+
+        if (false && value.is<JsonObject>() && parseTree.size() == 1 && value.size() == 1 && definitionJson.containsKey(key)) //if key is node_name
+        {
+          JsonObject::iterator objectIterator = value.as<JsonObject>().begin();
+
+          // DEBUG_ARTI("%s try replace %s by %s %s\n", spaces+50-depth, key, objectIterator->key().c_str(), parseTree.as<std::string>().c_str());
+
+          if (strcmp(objectIterator->key().c_str(), "ID") != 0) //&& definitionJson.containsKey(objectIterator->key())???
+          {
+            // DEBUG_ARTI("%s found %s:%s\n", spaces+50-depth, node_name, parseTree.as<std::string>().c_str());
+            // DEBUG_ARTI("%s found replace %s by %s %s\n", spaces+50-depth, key, objectIterator->key().c_str(), parseTree.as<std::string>().c_str());
+            // DEBUG_ARTI("%s found %s\n", spaces+50-depth, value.as<std::string>().c_str());
+
+            // DEBUG_ARTI("%s found %s\n", spaces+50-depth, parseTree.as<std::string>().c_str());
+            DEBUG_ARTI("%s replace %s by %s %s\n", spaces+50-depth, key, objectIterator->key().c_str(), parseTree.as<std::string>().c_str());
+
+            parseTree.remove(key);
+            // parseTree[key] = value;
+            parseTree[objectIterator->key()] = objectIterator->value();
+
+            // DEBUG_ARTI("%s found %s:%s\n", spaces+50-depth, node_name, parseTree.as<std::string>().c_str());
+
+          }
+          // else
+          // {
+          //   DEBUG_ARTI("%s not shrinkable %s %s\n", spaces+50-depth, key, value.as<std::string>().c_str());
+          //   if (depth > 12) {
+          //   // parseTree.remove(key);
+          //       char temp[charLength];
+          //       strcpy(temp, key);
+          //       strcat(temp, "-");
+          //       // strcat(temp, objectIterator->key().c_str());
+          //   // parseTree[temp] = value;
+          //   }
+          // }
+
+          if (false && definitionJson.containsKey(objectIterator->key().c_str()))  // if value key is a node
+          {
+            if (stringToNode(objectIterator->key().c_str()) == F_NoNode) // if key not a node
+            // if (objectIterator->value().size() == 1)
+            {
+              DEBUG_ARTI("%s node to shrink %s in %s : %s from %s\n", spaces+50-depth, objectIterator->key().c_str(), key, value.as<std::string>().c_str(), parseTree.as<std::string>().c_str());
+              // DEBUG_ARTI("%s node to shrink %s in %s = %s from %s\n", spaces+50-depth, objectIterator->key().c_str(), key, objectIterator->value().as<std::string>().c_str(), parseTree[key].as<std::string>().c_str());
+                parseTree[key] = objectIterator->value();
+
+              // parseTree[key]["old"] = objectIterator->key();
+
+              // parseTreePair.key() = objectIterator->key();
+              // parseTreePair._key = objectIterator->key();
+              // parseTree[objectIterator->key()] = objectIterator->value();
+              // parseTree.remove(key);
+              // parseTree[key][objectIterator2->key().c_str()] = objectIterator2->value();
+            }
+          }
+        } //value is jsonObject
+
+      } // for
+    }
+    else if (parseTree.is<JsonArray>())
+    {
+      JsonArray parseTreeArray = parseTree.as<JsonArray>();
+      
+      uint8_t arrayIndex = 0;
+      for (JsonArray::iterator it = parseTreeArray.begin(); it != parseTreeArray.end(); ++it) 
+      {
+        JsonVariant element = *it;
+
+        if (element == "multiple") 
+        {
+          // DEBUG_ARTI("%s optimize: remove array element 'multiple' of array (%u)\n", spaces+50-depth, arrayIndex);
+          parseTreeArray.remove(it);
+        }
+        else if (it->size() == 0) //remove {} elements (added by * arrays, don't know where added)
+        {
+          // DEBUG_ARTI("%s optimize: remove array element {} of %s array (%u)\n", spaces+50-depth, element.as<std::string>().c_str(), arrayIndex);
+          parseTreeArray.remove(it);
+        }
+        else 
+          optimize(*it, depth + 1);
+
+        arrayIndex++;
+      }
+    }
+    else //not array
+    {
+      // string element = parseTree;
+      //for some weird reason this causes a crash on esp32
+      ERROR_ARTI("%s Error: parseTree should be array or object %s (%u)\n", spaces+50-depth, parseTree.as<std::string>().c_str(), depth);
+    }
+
+    // DEBUG_ARTI("%s optimized %s (%u)\n", spaces+50-depth, parseTree.as<std::string>().c_str(), depth);
+
+    return !errorOccurred;
+  } //optimize
+
+  // bool visit_ID(JsonVariant parseTree, const char * treeElement = nullptr, ScopedSymbolTable* current_scope = nullptr, uint8_t depth = 0) 
+
+  //adds a node as last child of astParent
+  uint16_t addNode(uint8_t kind)
+  {
+    uint16_t node = syntaxTree->add(kind);
+    if (node == noNode) return noNode;
+
+    if (astLast != noNode)
+      syntaxTree->nodes[astLast].next = node;
+    else if (astParent != noNode)
+      syntaxTree->nodes[astParent].child = node;
+    astLast = node;
+    return node;
+  }
+
+  //the nodes of parseTree[treeElement] become the children of a new list node of astParent
+  uint16_t buildList(JsonVariant parseTree, const char * treeElement, ScopedSymbolTable* current_scope, uint8_t depth)
+  {
+    uint16_t list = addNode(F_List);
+    if (list == noNode) return noNode;
+
+    uint16_t parent = astParent;
+    astParent = list;
+    astLast = noNode;
+    if (!parseTree.isNull()) //e.g. call without actuals: empty list
+      buildSyntaxTree(parseTree, treeElement, current_scope, depth);
+    astParent = parent;
+    astLast = list;
+    return list;
+  }
+
+  //builds the lists of node: subsequent buildList calls add children to node
+  uint16_t openNode(uint16_t node)
+  {
+    uint16_t parent = astParent;
+    astParent = node;
+    astLast = noNode;
+    return parent;
+  }
+
+  void closeNode(uint16_t parent, uint16_t node)
+  {
+    astParent = parent;
+    astLast = node;
+  }
+
+  //reorders the children of an expr or term (operands and operators as parsed, left to right) in postfix order, e.g. a * - b + c becomes a b unary- * c +
+  //operands are (-)* value, unary minus gets index 1 and binary operators index 2, so no engine needs to find out what an operator does at run time
+  //the right operand of && and || becomes the child of the operator (short-circuit): a && b becomes a &&(b)
+  bool buildPostfix(uint16_t node)
+  {
+    //the children are relinked in place: no limit on the number of values and operators
+    uint16_t first = noNode; //postfix list
+    uint16_t last = noNode;
+    uint16_t unary = noNode; //minuses in front of the next value, linked by next: the last one first
+    uint16_t binary = noNode; //operator waiting for its right operand
+    bool afterValue = false;
+
+    uint16_t next;
+    for (uint16_t child = syntaxTree->nodes[node].child; child != noNode; child = next)
+    {
+      Node *n = &syntaxTree->nodes[child];
+      next = n->next;
+      if (n->kind == F_Operator)
+      {
+        if (afterValue) //binary
+        {
+          n->index = 2;
+          binary = child;
+        }
+        else if (n->token == F_minus)
+        {
+          n->index = 1;
+          n->next = unary;
+          unary = child;
+        }
+        else
+        {
+          ERROR_ARTI("Error: %s not supported as unary operator\n", tokenToString(n->token));
+          errorOccurred = true;
+          return false;
+        }
+        afterValue = false;
+      }
+      else
+      {
+        //the operand: the value followed by its minuses, innermost first
+        n->next = unary;
+        unary = noNode;
+
+        if (binary != noNode && (syntaxTree->nodes[binary].token == F_and || syntaxTree->nodes[binary].token == F_or))
+          syntaxTree->nodes[binary].child = child;
+        else
+        {
+          if (last == noNode)
+            first = child;
+          else
+            syntaxTree->nodes[last].next = child;
+          for (last = child; syntaxTree->nodes[last].next != noNode; last = syntaxTree->nodes[last].next)
+            ;
+        }
+        if (binary != noNode)
+        {
+          syntaxTree->nodes[binary].next = noNode;
+          if (last == noNode)
+            first = binary;
+          else
+            syntaxTree->nodes[last].next = binary;
+          last = binary;
+        }
+        binary = noNode;
+        afterValue = true;
+      }
+    }
+
+    if (binary != noNode || unary != noNode)
+    {
+      ERROR_ARTI("Error: %s ends with an operator\n", nodeToString(syntaxTree->nodes[node].kind));
+      errorOccurred = true;
+      return false;
+    }
+
+    syntaxTree->nodes[node].child = first;
+
+    return true;
+  }
+
+  //converts the analyzed parseTree into the nodes of syntaxTree, so interpret, compile and buildClosures do not need the parseTree
+  bool buildSyntaxTree(JsonVariant parseTree, const char * treeElement = nullptr, ScopedSymbolTable* current_scope = nullptr, uint8_t depth = 0)
+  {
+    if (depth >= 50)
+    {
+      ERROR_ARTI("Error: Syntax tree recursion level too deep at %s (%u)\n", parseTree.as<std::string>().c_str(), depth);
+      errorOccurred = true;
+    }
+    if (errorOccurred) return false;
+
+    if (parseTree.is<JsonObject>())
+    {
+      for (JsonPair parseTreePair : parseTree.as<JsonObject>())
+      {
+        const char * key = parseTreePair.key().c_str();
+        JsonVariant value = parseTreePair.value();
+        if (treeElement == nullptr || strcmp(treeElement, key) == 0)
+        {
+          bool visitedAlready = false;
+
+          if (strcmp(key, "*") == 0)
+          {
+            // do the recursive call below
+          }
+          else if (strcmp(key, "token") == 0 || strcmp(key, "variable") == 0) //variable decls done in analyze (see pas)
+            visitedAlready = true;
+          else if (parseTree.containsKey("token") && !value.is<JsonObject>()) //key is token, e.g. not the factor of {"MINUS": "-", "factor": {...}, "token": 3}
+          {
+            switch (parseTree["token"].as<uint8_t>())
+            {
+              case F_integerConstant:
+              case F_realConstant:
+              {
+                uint16_t node = addNode(F_Constant);
+                if (node != noNode)
+                  syntaxTree->nodes[node].value = atof(value.as<const char *>());
+                break;
+              }
+              default:
+              {
+                uint16_t node = addNode(F_Operator);
+                if (node != noNode)
+                  syntaxTree->nodes[node].token = parseTree["token"].as<uint8_t>();
+              }
+            }
+            visitedAlready = true;
+          }
+          else //if key is node_name
+          {
+            uint8_t nodeKind = stringToNode(key);
+
+            switch (nodeKind)
+            {
+              case F_Program:
+              {
+                uint16_t node = addNode(F_Program);
+                if (node == noNode) return false;
+                uint16_t parent = openNode(node);
+                buildList(value["block"], nullptr, global_scope, depth + 1);
+                closeNode(parent, node);
+
+                visitedAlready = true;
+                break;
+              }
+              case F_Function:
+              {
+                const char * function_name = value["ID"];
+                Symbol* function_symbol = current_scope->lookup(function_name);
+                if (function_symbol != nullptr)
+                {
+                  uint16_t node = addNode(F_Function);
+                  if (node == noNode) return false;
+                  syntaxTree->nodes[node].symbol = function_symbol;
+                  uint16_t parent = openNode(node);
+                  function_symbol->block_node = buildList(value["block"], nullptr, function_symbol->function_scope, depth + 1);
+                  closeNode(parent, node);
+                }
+                else
+                  ERROR_ARTI("%s Function %s: not found\n", spaces+50-depth, function_name);
+
+                visitedAlready = true;
+                break;
+              }
+              case F_Call:
+              {
+                const char * function_name = value["ID"];
+                Symbol* function_symbol = nullptr;
+
+                if (!value.containsKey("external"))
+                {
+                  function_symbol = current_scope->lookup(function_name);
+                  if (function_symbol == nullptr) //calling undefined function: pre-defined functions e.g. print
+                  {
+                    WARNING_ARTI("%s %s not found %s\n", spaces+50-depth, key, function_name);
+                    visitedAlready = true;
+                    break;
+                  }
+                }
+
+                uint16_t node = addNode(F_Call);
+                if (node == noNode) return false;
+                if (function_symbol != nullptr)
+                  syntaxTree->nodes[node].symbol = function_symbol;
+                else
+                  syntaxTree->nodes[node].external = value["external"].as<uint8_t>();
+                uint16_t parent = openNode(node);
+                buildList(value["actuals"], nullptr, current_scope, depth + 1);
+                closeNode(parent, node);
+
+                visitedAlready = true;
+                break;
+              }
+              case F_VarRef:
+              case F_Assign:
+              {
+                JsonObject variable_value;
+                if (nodeKind == F_Assign)
+                  variable_value = value["varref"];
+                else
+                  variable_value = value;
+
+                uint16_t node = addNode(nodeKind);
+                if (node == noNode) return false;
+                Node *n = &syntaxTree->nodes[node];
+                n->level = variable_value["level"].as<uint8_t>();
+                n->index = variable_value["index"].as<uint8_t>();
+                if (variable_value.containsKey("external")) //added by Analyze
+                  n->external = variable_value["external"].as<uint8_t>();
+                if (nodeKind == F_Assign && value.containsKey("assignoperator"))
+                  n->token = value["assignoperator"].as<uint8_t>();
+
+                uint16_t parent = openNode(node);
+                buildList(variable_value, "indices", current_scope, depth + 1);
+                if (nodeKind == F_Assign)
+                  buildList(value, "expr", current_scope, depth + 1);
+                closeNode(parent, node);
+
+                visitedAlready = true;
+                break;
+              }
+              case F_Expr:
+              case F_Term:
+              {
+                uint16_t node = addNode(nodeKind);
+                if (node == noNode) return false;
+                uint16_t parent = openNode(node);
+                buildSyntaxTree(value, nullptr, current_scope, depth + 1); //values and operators are the children
+                closeNode(parent, node);
+                if (!buildPostfix(node)) return false;
+
+                visitedAlready = true;
+                break;
+              }
+              case F_For:
+              {
+                uint16_t node = addNode(F_For);
+                if (node == noNode) return false;
+                uint16_t parent = openNode(node);
+                buildList(value, "assign", current_scope, depth + 1);
+                buildList(value, "expr", current_scope, depth + 1);
+                buildList(value["block"], nullptr, current_scope, depth + 1);
+                buildList(value["increment"], nullptr, current_scope, depth + 1);
+                closeNode(parent, node);
+
+                visitedAlready = true;
+                break;
+              }
+              case F_If:
+              {
+                uint16_t node = addNode(F_If);
+                if (node == noNode) return false;
+                uint16_t parent = openNode(node);
+                buildList(value, "expr", current_scope, depth + 1);
+                buildList(value, "block", current_scope, depth + 1);
+                buildList(value, "elseBlock", current_scope, depth + 1);
+                closeNode(parent, node);
+
+                visitedAlready = true;
+                break;
+              }
+              case F_Cex:
+              {
+                uint16_t node = addNode(F_Cex);
+                if (node == noNode) return false;
+                uint16_t parent = openNode(node);
+                buildList(value, "expr", current_scope, depth + 1);
+                buildList(value, "trueExpr", current_scope, depth + 1);
+                buildList(value, "falseExpr", current_scope, depth + 1);
+                closeNode(parent, node);
+
+                visitedAlready = true;
+                break;
+              }
+              default:  //visitedalready false => recursive call
+                break;
+            }
+          } // is key is node_name
+
+          if (!visitedAlready && value.size() > 0) // if size == 0 then injected key/value like operator
+            buildSyntaxTree(value, nullptr, current_scope, depth + 1);
+        } // if treeelement
+      } // for (JsonPair)
+    }
+    else if (parseTree.is<JsonArray>())
+    {
+      for (JsonVariant newParseTree: parseTree.as<JsonArray>())
+        buildSyntaxTree(newParseTree, nullptr, current_scope, depth + 1);
+    }
+    else { //not array
+      ERROR_ARTI("%s Error: parseTree should be array or object %s (%u)\n", spaces+50-depth, parseTree.as<std::string>().c_str(), depth);
+    }
+
+    return !errorOccurred;
+  } //buildSyntaxTree
+
+  //true if the value of node is the same in all calls of hoistFunction during a frame: it does not use its formals or the variables it assigns, only external functions and variables which only depend on their parameters (see arti_external_state)
+  bool invariant(uint16_t node)
+  {
+    Node *n = &syntaxTree->nodes[node];
+    switch (n->kind)
+    {
+      case F_Constant:
+        return true;
+      case F_VarRef:
+        if (n->external != noExternal)
+          return arti_external_state(n->external) == noExternal && invariantList(n->child);
+        if (n->level == 0 || n->level > hoistFunction->scope_level) //0: not found, read from the record of the function (see activationRecord)
+          return false;
+        for (uint8_t i=0; i<hoistWrittenLength; i++)
+          if (hoistWritten[i] == ((n->level << 8) | n->index))
+            return false;
+        return invariantList(n->child);
+      case F_Call:
+        return n->external != noExternal && arti_external_state(n->external) == noExternal && invariantList(n->child);
+      case F_Expr:
+      case F_Term:
+      case F_Cex:
+      case F_List:
+      case F_Operator: //&& and ||: the right operand
+        return invariantList(n->child);
+      default:
+        return false;
+    }
+  }
+
+  bool invariantList(uint16_t first)
+  {
+    for (uint16_t node = first; node != noNode; node = syntaxTree->nodes[node].next)
+      if (!invariant(node))
+        return false;
+    return true;
+  }
+
+  //replaces the values start..end (siblings, prev before start or noNode if start is the first child of parent) by a new variable assigned in hoistInvariants, false if no variables left
+  bool hoistRange(uint16_t parent, uint16_t prev, uint16_t start, uint16_t end)
+  {
+    //the activation record of the program has nrOfVariables
+    if (global_scope->symbolsIndex + (hoistInvariants == nullptr?2:1) > nrOfVariables || global_scope->child_scopesIndex >= nrOfChildScope)
+      return false;
+
+    if (hoistInvariants == nullptr)
+    {
+      char name[charLength];
+      snprintf(name, sizeof(name), "%sInvariants", hoistFunction->name);
+      hoistInvariants = new Symbol(F_Function, name);
+      global_scope->insert(hoistInvariants);
+      hoistInvariants->function_scope = new ScopedSymbolTable(name, global_scope->scope_level + 1, global_scope);
+      global_scope->child_scopes[global_scope->child_scopesIndex++] = hoistInvariants->function_scope;
+
+      //after the function in the block of the program
+      uint16_t function = syntaxTree->add(F_Function);
+      uint16_t block = syntaxTree->add(F_List);
+      if (block == noNode) return false;
+      for (uint16_t node = 0; node < syntaxTree->nodesIndex; node++)
+        if (syntaxTree->nodes[node].kind == F_Function && syntaxTree->nodes[node].symbol == hoistFunction)
+        {
+          syntaxTree->nodes[function].next = syntaxTree->nodes[node].next;
+          syntaxTree->nodes[node].next = function;
+        }
+      syntaxTree->nodes[function].symbol = hoistInvariants;
+      syntaxTree->nodes[function].child = block;
+      hoistInvariants->block_node = block;
+    }
+
+    char name[charLength];
+    snprintf(name, sizeof(name), "invariant%u", hoistCount++);
+    Symbol* variable = new Symbol(F_Assign, name, 9);
+    global_scope->insert(variable); // assigned variables are global scope
+
+    uint16_t varRef = syntaxTree->add(F_VarRef);
+    uint16_t varRefIndices = syntaxTree->add(F_List);
+    uint16_t assign = syntaxTree->add(F_Assign);
+    uint16_t assignIndices = syntaxTree->add(F_List);
+    uint16_t assignExpr = syntaxTree->add(F_List);
+    uint16_t expr = syntaxTree->add(F_Expr);
+    if (expr == noNode) return false;
+
+    Node *nodes = syntaxTree->nodes;
+    nodes[varRef].level = nodes[assign].level = variable->scope_level;
+    nodes[varRef].index = nodes[assign].index = variable->scope_index;
+    nodes[varRef].child = varRefIndices;
+    nodes[assign].child = assignIndices;
+    nodes[assignIndices].next = assignExpr;
+    nodes[assignExpr].child = expr;
+
+    //the values move to the expression of the assignment
+    nodes[varRef].next = nodes[end].next;
+    nodes[end].next = noNode;
+    nodes[expr].child = start;
+    if (prev == noNode)
+      nodes[parent].child = varRef;
+    else
+      nodes[prev].next = varRef;
+
+    if (hoistLast == noNode)
+      nodes[hoistInvariants->block_node].child = assign;
+    else
+      nodes[hoistLast].next = assign;
+    hoistLast = assign;
+
+    return true;
+  }
+
+  //constant or variable (also in parentheses): nothing gained by hoisting it
+  bool trivial(uint16_t node)
+  {
+    Node *n = &syntaxTree->nodes[node];
+    if (n->kind == F_Expr || n->kind == F_Term)
+      return n->child != noNode && syntaxTree->nodes[n->child].next == noNode && trivial(n->child);
+    return n->kind == F_Constant || (n->kind == F_VarRef && n->external == noExternal && (n->child == noNode || syntaxTree->nodes[n->child].child == noNode));
+  }
+
+  struct HoistValue {
+    uint16_t prev; //node before start, noNode if start is the first child
+    uint16_t start;
+    uint16_t end;
+    bool invariant;
+    bool trivial;
+  };
+
+  //the values of expr or term in postfix order: the largest invariant values are hoisted, others are searched for invariant values
+  void hoistPostfix(uint16_t node)
+  {
+    HoistValue values[arrayLength];
+    uint8_t valuesLength = 0;
+
+    uint16_t prev = noNode;
+    for (uint16_t child = syntaxTree->nodes[node].child; child != noNode; child = syntaxTree->nodes[child].next)
+    {
+      Node *n = &syntaxTree->nodes[child];
+      if (n->kind == F_Operator && n->index == 1 && valuesLength >= 1) //unary minus
+        values[valuesLength - 1].end = child;
+      else if (n->kind == F_Operator && valuesLength >= 2)
+      {
+        HoistValue *left = &values[valuesLength - 2];
+        HoistValue *right = &values[valuesLength - 1];
+
+        //&& and ||: the right operand is the child of the operator
+        uint16_t operand = n->child;
+        bool operandInvariant = operand == noNode || invariantList(operand);
+        if (!operandInvariant)
+          hoistList(operand);
+
+        if (left->invariant && right->invariant && operandInvariant)
+          left->trivial = false;
+        else
+        {
+          if (operand != noNode && operandInvariant && !(syntaxTree->nodes[operand].next == noNode && trivial(operand)))
+          {
+            uint16_t last = operand;
+            while (syntaxTree->nodes[last].next != noNode)
+              last = syntaxTree->nodes[last].next;
+            hoistRange(child, noNode, operand, last);
+          }
+          if (right->invariant && !right->trivial)
+            hoistRange(node, right->prev, right->start, right->end);
+          if (left->invariant && !left->trivial && hoistRange(node, left->prev, left->start, left->end))
+            left->start = left->prev == noNode?syntaxTree->nodes[node].child:syntaxTree->nodes[left->prev].next;
+          left->invariant = false;
+        }
+        left->end = child;
+        valuesLength--;
+      }
+      else if (n->kind != F_Operator && valuesLength < arrayLength)
+      {
+        HoistValue *value = &values[valuesLength++];
+        value->prev = prev;
+        value->start = value->end = child;
+        value->invariant = invariant(child);
+        value->trivial = trivial(child);
+        if (!value->invariant)
+          hoistNode(child);
+      }
+      prev = child;
+    }
+
+    if (valuesLength == 1 && values[0].invariant && !values[0].trivial)
+      hoistRange(node, values[0].prev, values[0].start, values[0].end);
+  }
+
+  void hoistNode(uint16_t node)
+  {
+    uint8_t kind = syntaxTree->nodes[node].kind;
+    if (kind == F_Expr || kind == F_Term)
+      hoistPostfix(node);
+    else if (kind != F_Function)
+      hoistList(syntaxTree->nodes[node].child);
+  }
+
+  void hoistList(uint16_t first)
+  {
+    for (uint16_t node = first; node != noNode; node = syntaxTree->nodes[node].next)
+      hoistNode(node);
+  }
+
+  //adds the variables assigned below node to hoistWritten, false if a function is called (it might assign variables) or too many variables
+  bool hoistAssigned(uint16_t node)
+  {
+    Node *n = &syntaxTree->nodes[node];
+    if (n->kind == F_Call && n->external == noExternal)
+      return false;
+    if (n->kind == F_Assign && n->external == noExternal)
+    {
+      if (hoistWrittenLength >= arrayLength)
+        return false;
+      hoistWritten[hoistWrittenLength++] = (n->level << 8) | n->index;
+    }
+    for (uint16_t child = n->child; child != noNode; child = syntaxTree->nodes[child].next)
+      if (!hoistAssigned(child))
+        return false;
+    return true;
+  }
+
+  //a function called for each led (renderLed): its invariant subexpressions are assigned to variables in a new function (renderLedInvariants), which the loop runs once per frame before the calls (see arti_wled.h)
+  //not if the function calls functions or is called by the program
+  bool hoist(const char *function_name)
+  {
+    hoistFunction = global_scope->lookup(function_name, true);
+    hoistInvariants = nullptr;
+    hoistLast = noNode;
+    hoistWrittenLength = 0;
+    hoistCount = 0;
+    if (hoistFunction == nullptr || hoistFunction->symbol_type != F_Function || hoistFunction->block_node == noNode)
+      return true;
+
+    char name[charLength];
+    snprintf(name, sizeof(name), "%sInvariants", function_name);
+    if (global_scope->lookup(name, true) != nullptr)
+      return true;
+
+    for (uint16_t node = 0; node < syntaxTree->nodesIndex; node++)
+    {
+      Node *n = &syntaxTree->nodes[node];
+      if (n->kind == F_Call && n->external == noExternal && n->symbol == hoistFunction)
+        return true;
+    }
+
+    if (!hoistAssigned(hoistFunction->block_node))
+      return true;
+
+    hoistList(syntaxTree->nodes[hoistFunction->block_node].child);
+
+    if (hoistCount > 0)
+      MEMORY_ARTI("hoist %u invariants of %s %u ✓\n", hoistCount, function_name, syntaxTree->nodesIndex);
+
+    return !errorOccurred;
+  } //hoist
+
+  #if ARTI_THREADS
+
+  //variables of the program record assigned below node (bit per index)
+  uint32_t parallelAssignments(uint16_t node)
+  {
+    Node *n = &syntaxTree->nodes[node];
+    uint32_t result = (n->kind == F_Assign && n->external == noExternal && n->level == global_scope->scope_level)?(uint32_t)1 << n->index:0;
+    for (uint16_t child = n->child; child != noNode; child = syntaxTree->nodes[child].next)
+      result |= parallelAssignments(child);
+    return result;
+  }
+
+  //index number i of an external variable is formal i of parallelFunction (also in parentheses)
+  bool parallelFormal(uint16_t node, uint8_t i)
+  {
+    Node *n = &syntaxTree->nodes[node];
+    if ((n->kind == F_Expr || n->kind == F_Term) && n->child != noNode && syntaxTree->nodes[n->child].next == noNode)
+      return parallelFormal(n->child, i);
+    ScopedSymbolTable *function_scope = parallelFunction->function_scope;
+    return n->kind == F_VarRef && n->external == noExternal && n->level == function_scope->scope_level && i < function_scope->nrOfFormals && n->index == function_scope->symbols[i]->scope_index && (n->child == noNode || syntaxTree->nodes[n->child].child == noNode);
+  }
+
+  //returns the variables of the program record (bits) written for sure after node, written: the ones written before it
+  //sets parallelNotSupported if a call of parallelFunction can depend on another call
+  uint32_t parallelWalk(uint16_t node, uint32_t written)
+  {
+    if (node == noNode || parallelNotSupported != nullptr)
+      return written;
+
+    Node *n = &syntaxTree->nodes[node];
+    switch (n->kind)
+    {
+      case F_VarRef:
+        if (n->external != noExternal)
+        {
+          if (arti_external_state(n->external) != noExternal)
+            parallelNotSupported = "external state read";
+        }
+        else if (n->level == global_scope->scope_level && (parallelAssigned & ((uint32_t)1 << n->index)) && !(written & ((uint32_t)1 << n->index)))
+          parallelNotSupported = "variable read before written"; //value of the previous call
+        return parallelWalkList(n->child, written);
+      case F_Assign:
+      {
+        uint16_t indices = syntaxTree->child(node, 0);
+        written = parallelWalkList(syntaxTree->child(node, 1), written); //the value first
+        written = parallelWalk(indices, written);
+
+        ScopedSymbolTable *function_scope = parallelFunction->function_scope;
+        if (n->external != noExternal)
+        {
+          //each call sets its own element, e.g. leds[x] = ...
+          uint8_t count = 0;
+          bool formals = true;
+          for (uint16_t index = syntaxTree->nodes[indices].child; index != noNode; index = syntaxTree->nodes[index].next)
+            formals = formals && parallelFormal(index, count++);
+          if (n->token != F_NoToken || count == 0 || !formals)
+            parallelNotSupported = "external variable set without the formals as indices";
+          else if (parallelIndices == 0 || count < parallelIndices)
+            parallelIndices = count;
+        }
+        else if (n->level == function_scope->scope_level)
+        {
+          for (uint8_t i=0; i<function_scope->nrOfFormals; i++)
+            if (n->index == function_scope->symbols[i]->scope_index)
+              parallelNotSupported = "formal assigned";
+        }
+        else if (n->level == global_scope->scope_level)
+        {
+          if (n->token != F_NoToken && !(written & ((uint32_t)1 << n->index))) //e.g. h += 1
+            parallelNotSupported = "variable read before written";
+          written |= (uint32_t)1 << n->index;
+        }
+        return written;
+      }
+      case F_Call:
+        if (n->external == noExternal)
+          parallelNotSupported = "function called"; //it might assign variables
+        else if (arti_external_state(n->external) != noExternal)
+          parallelNotSupported = "external state used";
+        return parallelWalkList(n->child, written);
+      case F_Operator: //&& and ||: the right operand is not always evaluated
+        parallelWalkList(n->child, written);
+        return written;
+      case F_If:
+      case F_Cex:
+      {
+        written = parallelWalk(syntaxTree->child(node, 0), written);
+        uint32_t first = parallelWalk(syntaxTree->child(node, 1), written);
+        uint32_t second = parallelWalk(syntaxTree->child(node, 2), written);
+        return first & second;
+      }
+      case F_For:
+      {
+        written = parallelWalk(syntaxTree->child(node, 0), written);
+        written = parallelWalk(syntaxTree->child(node, 1), written);
+        uint32_t block = parallelWalk(syntaxTree->child(node, 2), written);
+        parallelWalk(syntaxTree->child(node, 3), block);
+        return written; //the block might not run
+      }
+      case F_Function:
+        return written;
+      default:
+        return parallelWalkList(n->child, written);
+    }
+  }
+
+  uint32_t parallelWalkList(uint16_t first, uint32_t written)
+  {
+    for (uint16_t node = first; node != noNode; node = syntaxTree->nodes[node].next)
+      written = parallelWalk(node, written);
+    return written;
+  }
+
+  //the calls of a function (renderLed) can run in parallel (see runParallel) if they do not depend on each other:
+  //variables of the program it assigns are written before read and in each call, no functions called and external states only set as elements indexed by its formals
+  void checkParallel(const char *function_name)
+  {
+    parallelFunction = global_scope->lookup(function_name, true);
+    parallelIndices = 0;
+    parallelNotSupported = nullptr;
+    if (parallelFunction == nullptr || parallelFunction->symbol_type != F_Function || parallelFunction->block_node == noNode)
+    {
+      parallelFunction = nullptr;
+      return;
+    }
+
+    if (parallelFunction->scope_level != global_scope->scope_level)
+      parallelNotSupported = "not a function of the program"; //variables of the enclosing functions are not checked
+    parallelAssigned = parallelAssignments(parallelFunction->block_node);
+    uint32_t written = parallelWalk(parallelFunction->block_node, 0);
+    if (parallelNotSupported == nullptr && (parallelAssigned & ~written) != 0)
+      parallelNotSupported = "variable not always written";
+
+    if (parallelNotSupported != nullptr)
+    {
+      DEBUG_ARTI("parallel %s not supported: %s\n", function_name, parallelNotSupported);
+      parallelFunction = nullptr;
+    }
+    else
+      MEMORY_ARTI("parallel %s ✓\n", function_name);
+  }
+
+  #endif
+
+  //floats of the records of the deepest calls in the nodes first.. (siblings) and their children
+  uint16_t arenaCalls(uint16_t first, uint8_t depth)
+  {
+    uint16_t result = 0;
+    for (uint16_t node = first; node != noNode && !arenaRecursive; node = syntaxTree->nodes[node].next)
+    {
+      Node *n = &syntaxTree->nodes[node];
+      uint16_t length;
+      if (n->kind == F_Function) //counted where it is called
+        continue;
+      else if (n->kind == F_Call && n->external == noExternal && n->symbol != nullptr && n->symbol->function_scope != nullptr)
+      {
+        //the record of a call is allocated before its actuals are evaluated (see interpret and closureCall)
+        length = n->symbol->function_scope->recordSize() + arenaCalls(n->child, depth);
+        uint16_t called = arenaFunction(n->symbol, depth);
+        if (called > length)
+          length = called;
+      }
+      else
+        length = arenaCalls(n->child, depth);
+      if (length > result)
+        result = length;
+    }
+    return result;
+  }
+
+  //floats of the records of a call of the function and the deepest calls in it, sets arenaRecursive if it calls itself
+  uint16_t arenaFunction(Symbol *function_symbol, uint8_t depth)
+  {
+    for (uint8_t i=0; i<depth; i++)
+      if (arenaVisiting[i] == function_symbol)
+        arenaRecursive = true;
+    if (arenaRecursive || depth >= nrOfRecords)
+    {
+      arenaRecursive = true;
+      return 0;
+    }
+
+    arenaVisiting[depth] = function_symbol;
+    uint16_t result = function_symbol->function_scope->recordSize();
+    if (function_symbol->block_node != noNode)
+      result += arenaCalls(syntaxTree->nodes[function_symbol->block_node].child, depth + 1);
+    return result;
+  }
+
+  //arenaLength: the program record and the deepest calls of the program or of a function of the program called from outside (e.g. renderLed by arti_wled.h)
+  //recursive functions: nrOfRecords of the largest record
+  void sizeArena()
+  {
+    arenaRecursive = false;
+    uint16_t calls = arenaCalls(syntaxTree->child(0), 0);
+    for (uint8_t i=0; i<global_scope->symbolsIndex; i++)
+    {
+      Symbol *symbol = global_scope->symbols[i];
+      if (symbol->symbol_type == F_Function && symbol->function_scope != nullptr)
+      {
+        uint16_t length = arenaFunction(symbol, 0);
+        if (length > calls)
+          calls = length;
+      }
+    }
+
+    if (arenaRecursive)
+      arenaLength = nrOfRecords * global_scope->maxRecordSize();
+    else
+      arenaLength = global_scope->recordSize() + calls;
+    MEMORY_ARTI("arena %u variables%s ✓\n", arenaLength, arenaRecursive?" (recursive)":"");
+  }
+
+  //the uniform of an external variable, nrOfUniforms if not frame constant
+  uint8_t uniformIndex(uint8_t external)
+  {
+    for (uint8_t i=0; i<uniformsLength; i++)
+      if (uniformExternals[i] == external)
+        return i;
+    return nrOfUniforms;
+  }
+
+  //reads the frame constant externals once, so the engines read them as variables: before the program runs and at the start of each frame (see loop)
+  void snapshotUniforms()
+  {
+    for (uint8_t i=0; i<uniformsLength; i++)
+      uniforms[i] = arti_get_external_variable(uniformExternals[i]);
+  }
+
+  //uniforms read by the nodes first.. (siblings) and their children, sets frameNotSkippable if they read or call frameDependent externals
+  void frameWalk(uint16_t first)
+  {
+    for (uint16_t node = first; node != noNode && frameNotSkippable == nullptr; node = syntaxTree->nodes[node].next)
+    {
+      Node *n = &syntaxTree->nodes[node];
+      if (n->kind == F_VarRef && n->external != noExternal)
+      {
+        uint8_t uniform = uniformIndex(n->external);
+        if (uniform < nrOfUniforms && (n->child == noNode || syntaxTree->nodes[n->child].child == noNode)) //no indices
+          uniformsRead |= (uint32_t)1 << uniform;
+        else if (arti_external_frame(n->external) != frameIndependent) //only results of calls are compared
+          frameNotSkippable = "external variable read";
+      }
+      else if (n->kind == F_Call && n->external != noExternal && arti_external_frame(n->external) == frameDependent)
+        frameNotSkippable = "external changing each frame called";
+      frameWalk(n->child);
+    }
+  }
+
+  //frames can be skipped if the program only depends on its record and the externals it reads (assigned external variables are only set), see skipFrame
+  void checkFrameSkipping()
+  {
+    frameNotSkippable = nullptr;
+    uniformsRead = 0;
+    frameInputsValid = false;
+    frameWalk(syntaxTree->child(0));
+    if (frameNotSkippable != nullptr)
+      DEBUG_ARTI("frame skipping not supported: %s\n", frameNotSkippable);
+    else
+      MEMORY_ARTI("frame skipping ✓\n");
+  }
+
+  //true if the frame is the same as the previous frame: the program record at the start, the uniforms read and the results of the frameInput externals read are the same
+  //the leds keep what the previous frame set. If not the same, the inputs of this frame are recorded (see frameInputRead) until frameDone
+  bool skipFrame()
+  {
+    if (!frameSkipping || frameNotSkippable != nullptr || callStack == nullptr || callStack->recordsCounter == 0)
+      return false;
+
+    float *program = callStack->records[0]->floatMembers;
+    uint16_t size = callStack->records[0]->size;
+    if (previousRecord == nullptr)
+    {
+      previousRecord = (float *)malloc(size * sizeof(float));
+      if (previousRecord == nullptr)
+      {
+        frameNotSkippable = "no memory";
+        return false;
+      }
+    }
+
+    if (frameInputsRecording) //the previous frame did not finish
+    {
+      frameInputsRecording = false;
+      frameInputsValid = false;
+    }
+
+    bool same = frameInputsValid && memcmp(program, previousRecord, size * sizeof(float)) == 0;
+    for (uint8_t i=0; same && i<uniformsLength; i++)
+      if ((uniformsRead & ((uint32_t)1 << i)) && uniforms[i] != previousUniforms[i])
+        same = false;
+    for (uint8_t i=0; same && i<frameInputsLength; i++)
+      if (arti_external_function(frameInputs[i].external, frameInputs[i].par1, frameInputs[i].par2, frameInputs[i].par3) != frameInputs[i].result)
+        same = false;
+    if (same)
+      return true;
+
+    memcpy(previousRecord, program, size * sizeof(float));
+    memcpy(previousUniforms, uniforms, sizeof(float) * uniformsLength);
+    frameInputsLength = 0;
+    frameInputsOverflow = false;
+    frameInputsRecording = true;
+    return false;
+  }
+
+  //called by arti_external_function of the definition for each external called
+  void frameInputRead(uint8_t external, float par1, float par2, float par3, float result)
+  {
+    if (!frameInputsRecording || arti_external_frame(external) != frameInput)
+      return;
+    if (frameInputsLength < nrOfFrameInputs)
+    {
+      FrameInput *input = &frameInputs[frameInputsLength++];
+      input->external = external;
+      input->par1 = par1;
+      input->par2 = par2;
+      input->par3 = par3;
+      input->result = result;
+    }
+    else
+      frameInputsOverflow = true;
+  }
+
+  //end of a frame started by skipFrame: the next frame can be compared with it if it ran completely
+  void frameDone(bool result)
+  {
+    if (!frameInputsRecording)
+      return;
+    frameInputsRecording = false;
+    frameInputsValid = result && !errorOccurred && !frameInputsOverflow;
+  }
+
+  //interprets a node of the syntaxTree, a list node interprets its children
+  bool interpret(uint16_t node, uint8_t depth = 0)
+  {
+    if (depth >= 50)
+    {
+      ERROR_ARTI("Error: Interpret recursion level too deep at node %u (%u)\n", node, depth);
+      errorOccurred = true;
+    }
+    if (errorOccurred || node == noNode) return !errorOccurred;
+
+    Node *n = &syntaxTree->nodes[node];
+
+    switch (n->kind)
+    {
+      case F_List:
+      {
+        for (uint16_t child = n->child; child != noNode; child = syntaxTree->nodes[child].next)
+          interpret(child, depth + 1);
+        break;
+      }
+      case F_Constant:
+        valueStack->push(n->value); //push value
+        RUNLOG_ARTI("%s constant %f (Push %u)\n", spaces+50-depth, n->value, valueStack->stack_index);
+        break;
+      case F_Operator: //postfix: the operands are on the valueStack
+      {
+        if (n->index == 1) //unary minus
+        {
+          float value = valueStack->popFloat();
+          valueStack->push(-value);
+          RUNLOG_ARTI("%s unary - %f (push %u)\n", spaces+50-depth, value, valueStack->stack_index);
+          break;
+        }
+
+        if (n->child != noNode) //&& and ||: the right operand is only interpreted if it determines the result
+        {
+          float left = valueStack->popFloat();
+          float evaluation = n->token == F_or;
+          if (n->token == F_and?left != 0:left == 0)
+          {
+            for (uint16_t child = n->child; child != noNode; child = syntaxTree->nodes[child].next)
+              interpret(child, depth + 1);
+            evaluation = valueStack->popFloat() != 0;
+          }
+          else
+            RUNLOG_ARTI("%s %f %s skipped\n", spaces+50-depth, left, tokenToString(n->token));
+
+          RUNLOG_ARTI("%s %f %s = %f (push %u)\n", spaces+50-depth, left, tokenToString(n->token), evaluation, valueStack->stack_index + 1);
+
+          valueStack->push(evaluation);
+          break;
+        }
+
+        uint8_t operatorx = n->token;
+        float right = valueStack->popFloat();
+        float left = valueStack->popFloat();
+        float evaluation = 0;
+
+        switch (operatorx) {
+          case F_plus:
+            evaluation = left + right;
+            break;
+          case F_minus:
+            evaluation = left - right;
+            break;
+          case F_multiplication:
+            evaluation = left * right;
+            break;
+          case F_division: {
+            if (right == 0)
+            {
+              right = 1;
+              ERROR_ARTI("%s division by 0 not possible, divisor ignored for %f\n", spaces+50-depth, left);
+            }
+            evaluation = left / right;
+            break;
+          }
+          case F_modulo: {
+            if (right == 0) {
+              evaluation = left;
+              ERROR_ARTI("%s mod 0 not possible, mod ignored %f\n", spaces+50-depth, left);
+            }
+            else
+              evaluation = fmod(left, right);
+            break;
+          }
+          case F_bitShiftLeft:
+            evaluation = (int)left << (int)right; //only works on integers
+            break;
+          case F_bitShiftRight:
+            evaluation = (int)left >> (int)right; //only works on integers
+            break;
+          case F_equal:
+            evaluation = left == right;
+            break;
+          case F_notEqual:
+            evaluation = left != right;
+            break;
+          case F_lessThen:
+            evaluation = left < right;
+            break;
+          case F_lessThenOrEqual:
+            evaluation = left <= right;
+            break;
+          case F_greaterThen:
+            evaluation = left > right;
+            break;
+          case F_greaterThenOrEqual:
+            evaluation = left >= right;
+            break;
+          default:
+            ERROR_ARTI("%s Programming error: unknown operator %u\n", spaces+50-depth, operatorx);
+        }
+
+
+        RUNLOG_ARTI("%s %f %s %f = %f (push %u)\n", spaces+50-depth, left, tokenToString(operatorx), right, evaluation, valueStack->stack_index + 1);
+
+        valueStack->push(evaluation);
+        break;
+      }
+      case F_Program:
+      {
+        RUNLOG_ARTI("%s program %s\n", spaces+50-depth, global_scope->scope_name);
+
+        ActivationRecord* ar = this->callStack->allocate(global_scope->scope_name, 1, global_scope->recordSize());
+        if (ar == nullptr)
+          break;
+
+        this->callStack->push(ar);
+
+        interpretStatements(n->child, depth + 1);
+
+        // do not release main stack and program ar as used in subsequent calls
+        break;
+      }
+      case F_Function: //block saved in block_node by buildSyntaxTree
+        break;
+      case F_Call:
+      {
+        //check if external function
+        if (n->external != noExternal) {
+          uint8_t external = n->external;
+          uint8_t oldIndex = valueStack->stack_index;
+
+          interpret(n->child, depth + 1);
+
+          float returnValue = floatNull;
+
+          returnValue = arti_external_function(external, valueStack->floatStack[oldIndex]
+                                                      , (valueStack->stack_index - oldIndex>1)?valueStack->floatStack[oldIndex+1]:floatNull
+                                                      , (valueStack->stack_index - oldIndex>2)?valueStack->floatStack[oldIndex+2]:floatNull
+                                                      , (valueStack->stack_index - oldIndex>3)?valueStack->floatStack[oldIndex+3]:floatNull
+                                                      , (valueStack->stack_index - oldIndex>4)?valueStack->floatStack[oldIndex+4]:floatNull);
+
+          #if ARTI_PLATFORM != ARTI_ARDUINO // because arduino runs the code instead of showing the code
+            RUNLOG_ARTI("%s Call e%u(", spaces+50-depth, external);
+            char sep[3] = "";
+            for (int i = oldIndex; i< valueStack->stack_index; i++) {
+              RUNLOG_ARTI("%s%f", sep, valueStack->floatStack[i]);
+              strcpy(sep, ", ");
+            }
+            if ( returnValue != floatNull)
+              RUNLOG_ARTI(") = %f (Pop %u, Push %u)\n", returnValue, oldIndex, oldIndex + 1);
+            else
+              RUNLOG_ARTI(") (Pop %u)\n", oldIndex);
+
+          #endif
+
+          valueStack->stack_index = oldIndex;
+
+          if (returnValue != floatNull)
+            valueStack->push(returnValue);
+
+        }
+        else { //not an external function
+          Symbol* function_symbol = n->symbol;
+
+          ActivationRecord* ar = this->callStack->allocate(function_symbol->name, function_symbol->scope_level + 1, function_symbol->function_scope->recordSize());
+          if (ar == nullptr)
+            break;
+
+          RUNLOG_ARTI("%s call %s\n", spaces+50-depth, function_symbol->name);
+
+          uint8_t oldIndex = valueStack->stack_index;
+          uint8_t lastIndex = valueStack->stack_index;
+
+          interpret(n->child, depth + 1);
+
+          for (uint8_t i=0; i<function_symbol->function_scope->nrOfFormals; i++)
+          {
+            //determine type, for now assume float
+            float result = valueStack->floatStack[lastIndex++];
+            ar->set(function_symbol->function_scope->symbols[i]->scope_index, result);
+            RUNLOG_ARTI("%s Actual %s.%s = %f (pop %u)\n", spaces+50-depth, function_symbol->name, function_symbol->function_scope->symbols[i]->name, result, valueStack->stack_index);
+          }
+
+          valueStack->stack_index = oldIndex;
+
+          this->callStack->push(ar);
+
+          interpretStatements(function_symbol->block_node, depth + 1);
+
+          this->callStack->pop();
+
+          this->callStack->release(ar);
+
+          //tbd if syntax supports returnvalue
+        } //external functions
+        break;
+      }
+      case F_VarRef:
+      case F_Assign: //get or set a variable
+      {
+        uint8_t nodeKind = n->kind;
+        uint8_t variable_level = n->level;
+        uint8_t variable_index = n->index;
+        uint8_t variable_external = n->external;
+        uint8_t assignOperator = n->token;
+        uint16_t indicesList = syntaxTree->child(node, 0);
+
+        float resultValue = floatNull;
+
+        if (nodeKind == F_Assign)
+        {
+          uint16_t exprList = syntaxTree->child(node, 1);
+          if (syntaxTree->nodes[exprList].child != noNode) //value assignment
+          {
+            interpret(exprList, depth + 1); //value pushed
+
+            resultValue = valueStack->popFloat(); //result of interpret expr (but not for -- and ++ !!!!)
+          }
+        }
+
+        uint8_t oldIndex = valueStack->stack_index;
+
+        //array indices
+        interpret(indicesList, depth + 1); //values of indices pushed
+
+        //check if external variable
+        if (variable_external != noExternal)
+        {
+          if (nodeKind == F_VarRef) { //get the value
+
+            uint8_t uniform = valueStack->stack_index == oldIndex?uniformIndex(variable_external):nrOfUniforms;
+            if (uniform < nrOfUniforms)
+              resultValue = uniforms[uniform];
+            else
+              resultValue = arti_get_external_variable(variable_external, (valueStack->stack_index - oldIndex>0)?valueStack->floatStack[oldIndex]:floatNull, (valueStack->stack_index - oldIndex>1)?valueStack->floatStack[oldIndex+1]:floatNull);
+            valueStack->stack_index = oldIndex;
+
+            if (resultValue != floatNull)
+            {
+              valueStack->push(resultValue);
+              RUNLOG_ARTI("%s varref ext.%u = %f (push %u)\n", spaces+50-depth, variable_external, resultValue, valueStack->stack_index);
+            }
+            else
+              ERROR_ARTI("%s Error: varref ext.%u no value\n", spaces+50-depth, variable_external);
+          }
+          else //assign: set the external value...
+          {
+            arti_set_external_variable(resultValue, variable_external, (valueStack->stack_index - oldIndex>0)?valueStack->floatStack[oldIndex]:floatNull, (valueStack->stack_index - oldIndex>1)?valueStack->floatStack[oldIndex+1]:floatNull);
+            valueStack->stack_index = oldIndex;
+
+            RUNLOG_ARTI("%s assign set ext.%u = %f (Pop %u)\n", spaces+50-depth, variable_external, resultValue, oldIndex);
+          }
+        }
+        else //not external, get er set the variable
+        {
+          ActivationRecord* ar;
+
+          if (variable_level != 0) { //var already exist
+            ar = this->callStack->find(variable_level);
+          }
+          else //var created here
+            ar = this->callStack->peek();
+
+          if (ar != nullptr) // variable found
+          {
+            if (nodeKind == F_VarRef) //get the value
+            {
+              //determine type, for now assume float
+              float varValue = ar->getFloat(variable_index);
+
+              valueStack->push(varValue);
+              RUNLOG_ARTI("%s varref %s.%u-%u = %f (push %u)\n", spaces+50-depth, ar->name, variable_level, variable_index, varValue, valueStack->stack_index);
+            }
+            else { //assign: set the value
+
+              if (assignOperator != F_NoToken)
+              {
+                switch (assignOperator)
+                {
+                  case F_plus:
+                    ar->set(variable_index, ar->getFloat(variable_index) + resultValue);
+                    break;
+                  case F_minus:
+                    ar->set(variable_index, ar->getFloat(variable_index) - resultValue);
+                    break;
+                  case F_multiplication:
+                    ar->set(variable_index, ar->getFloat(variable_index) * resultValue);
+                    break;
+                  case F_division:
+                  {
+                    if (resultValue == 0) // divisor
+                    {
+                      resultValue = 1;
+                      ERROR_ARTI("%s /= division by 0 not possible, divisor ignored for %f\n", spaces+50-depth, ar->getFloat(variable_index));
+                    }
+                    ar->set(variable_index, ar->getFloat(variable_index) / resultValue);
+                    break;
+                  }
+                  case F_plusplus:
+                    ar->set(variable_index, ar->getFloat(variable_index) + 1);
+                    break;
+                  case F_minmin:
+                    ar->set(variable_index, ar->getFloat(variable_index) - 1);
+                    break;
+                }
+
+                RUNLOG_ARTI("%s %s.%u-%u %s= %f (pop %u)\n", spaces+50-depth, ar->name, variable_level, variable_index, tokenToString(assignOperator), ar->getFloat(variable_index), valueStack->stack_index);
+              }
+              else
+              {
+                ar->set(variable_index, resultValue);
+                RUNLOG_ARTI("%s %s.%u-%u := %f (pop %u)\n", spaces+50-depth, ar->name, variable_level, variable_index, ar->getFloat(variable_index), valueStack->stack_index);
+              }
+              valueStack->stack_index = oldIndex;
+            }
+          } //ar != nullptr
+          else { //unknown variable
+            ERROR_ARTI("%s variable %u-%u unknown\n", spaces+50-depth, variable_level, variable_index);
+            valueStack->push(floatNull);
+          }
+        } // ! founnd
+        break;
+      }
+      case F_Expr:
+      case F_Term: //values and operators in postfix order, see buildPostfix
+      {
+        for (uint16_t child = n->child; child != noNode; child = syntaxTree->nodes[child].next)
+          interpret(child, depth + 1); //values are pushed, operators replace their operands by the result
+        break;
+      }
+      case F_For:
+      {
+        RUNLOG_ARTI("%s For (%u)\n", spaces+50-depth, valueStack->stack_index);
+
+        uint16_t assignList = syntaxTree->child(node, 0);
+        uint16_t exprList = syntaxTree->child(node, 1);
+        uint16_t blockList = syntaxTree->child(node, 2);
+        uint16_t incrementList = syntaxTree->child(node, 3);
+
+        interpretStatements(assignList, depth + 1); //creates the assignment
+        ActivationRecord* ar = this->callStack->peek();
+
+        bool continuex = true;
+        uint16_t counter = 0;
+        while (continuex && counter < maxForIterations) //to avoid endless loops
+        {
+          RUNLOG_ARTI("%s iteration\n", spaces+50-depth);
+
+          RUNLOG_ARTI("%s check to condition\n", spaces+50-depth);
+          interpret(exprList, depth + 1); //pushes result of to
+
+          float conditionResult = valueStack->popFloat();
+
+          RUNLOG_ARTI("%s conditionResult (pop %u)\n", spaces+50-depth, valueStack->stack_index);
+
+          if (conditionResult == 1) { //conditionResult is true
+            RUNLOG_ARTI("%s 1 => run block\n", spaces+50-depth);
+            interpretStatements(blockList, depth + 1);
+
+            RUNLOG_ARTI("%s assign next value\n", spaces+50-depth);
+            interpretStatements(incrementList, depth + 1);
+          }
+          else
+          {
+            if (conditionResult == 0) { //conditionResult is false
+              RUNLOG_ARTI("%s 0 => end of For\n", spaces+50-depth);
+              continuex = false;
+            }
+            else // conditionResult is a value (e.g. in pascal)
+            {
+              //get the variable from assignment
+              float varValue = ar->getFloat(ar->lastSetIndex);
+
+              float evaluation = varValue <= conditionResult;
+              RUNLOG_ARTI("%s %s.(%u) %f <= %f = %f\n", spaces+50-depth, ar->name, ar->lastSetIndex, varValue, conditionResult, evaluation);
+
+              if (evaluation == 1)
+              {
+                RUNLOG_ARTI("%s 1 => run block\n", spaces+50-depth);
+                interpretStatements(blockList, depth + 1);
+
+                //increment
+                ar->set(ar->lastSetIndex, varValue + 1);
+              }
+              else
+              {
+                RUNLOG_ARTI("%s 0 => end of For\n", spaces+50-depth);
+                continuex = false;
+              }
+            }
+          }
+          counter++;
+        };
+
+        if (continuex)
+          ERROR_ARTI("%s too many iterations in for loop %u\n", spaces+50-depth, counter);
+        break;
+      }  // case
+      case F_If:
+      {
+        RUNLOG_ARTI("%s If (stack %u)\n", spaces+50-depth, valueStack->stack_index);
+
+        RUNLOG_ARTI("%s condition\n", spaces+50-depth);
+        interpret(syntaxTree->child(node, 0), depth + 1);
+
+        float conditionResult = valueStack->popFloat();
+
+        RUNLOG_ARTI("%s (pop %u)\n", spaces+50-depth, valueStack->stack_index);
+
+        if (conditionResult == 1) //conditionResult is true
+          interpretStatements(syntaxTree->child(node, 1), depth + 1);
+        else
+          interpretStatements(syntaxTree->child(node, 2), depth + 1);
+        break;
+      }  // case
+      case F_Cex:
+      {
+        RUNLOG_ARTI("%s Cex (stack %u)\n", spaces+50-depth, valueStack->stack_index);
+
+        RUNLOG_ARTI("%s condition\n", spaces+50-depth);
+        interpret(syntaxTree->child(node, 0), depth + 1);
+
+        float conditionResult = valueStack->popFloat();
+
+        RUNLOG_ARTI("%s (pop %u)\n", spaces+50-depth, valueStack->stack_index);
+
+        if (conditionResult == 1) //conditionResult is true
+          interpret(syntaxTree->child(node, 1), depth + 1);
+        else
+          interpret(syntaxTree->child(node, 2), depth + 1);
+        break;
+      }  // case
+      default:
+        ERROR_ARTI("%s Programming error: node %s not interpreted\n", spaces+50-depth, nodeToString(n->kind));
+    }
+
+    return !errorOccurred;
+  } //interpret
+
+  //interprets a statement or a list of statements, values a statement leaves on the valueStack (e.g. the result of an external call like fadeToBlackBy) are removed
+  bool interpretStatements(uint16_t node, uint8_t depth)
+  {
+    if (errorOccurred || node == noNode) return !errorOccurred;
+
+    uint8_t oldIndex = valueStack->stack_index;
+
+    if (syntaxTree->nodes[node].kind != F_List)
+      interpret(node, depth);
+    else
+    {
+      for (uint16_t child = syntaxTree->nodes[node].child; child != noNode; child = syntaxTree->nodes[child].next)
+      {
+        interpret(child, depth + 1);
+        valueStack->stack_index = oldIndex;
+      }
+    }
+
+    valueStack->stack_index = oldIndex;
+    return !errorOccurred;
+  }
+
+  void openContext(uint8_t kind)
+  {
+    if (contextsIndex < nrOfContexts)
+    {
+      contexts[contextsIndex].kind = kind;
+      contexts[contextsIndex].values = 0;
+      contextsIndex++;
+    }
+    else
+    {
+      ERROR_ARTI("Compile: contexts full (%d)\n", nrOfContexts);
+      errorOccurred = true;
+    }
+  }
+
+  //returns the number of values compiled in the context
+  uint8_t closeContext()
+  {
+    CompileContext *context = &contexts[--contextsIndex];
+    if (context->kind == C_Expression)
+      return 1;
+    return context->values;
+  }
+
+  void compileNotSupported(const char * construct, uint8_t par1 = 0, uint8_t par2 = 0)
+  {
+    (void)construct; (void)par1; (void)par2; //only used by WARNING_ARTI
+    if (!compileError)
+      WARNING_ARTI("Compile: %s not supported (%u %u)\n", construct, par1, par2);
+    compileError = true;
+  }
+
+  //a value has been pushed
+  void compiledValue()
+  {
+    if (contextsIndex > 0)
+      contexts[contextsIndex-1].values++;
+  }
+
+  void compileConstant(float value)
+  {
+    byteCode->emit(O_Const);
+    byteCode->emitFloat(value);
+    byteCode->stack(1);
+  }
+
+  //the value on top of the stack becomes 1 if not 0, else 0
+  void compileBool()
+  {
+    compileConstant(0);
+    byteCode->emit(O_Ne);
+    byteCode->stack(-1);
+  }
+
+  //compiles exactly one value of list
+  void compileValue(uint16_t list, const char * construct, uint8_t depth)
+  {
+    openContext(C_Values);
+    compile(list, depth);
+    uint8_t values = closeContext();
+    if (values != 1)
+      compileNotSupported(construct, values);
+  }
+
+  void compileStatements(uint16_t list, uint8_t depth)
+  {
+    openContext(C_Statements);
+    compile(list, depth);
+    closeContext();
+  }
+
+  //lowers a node of the syntaxTree into byteCode, same traversal as interpret but executed once
+  bool compile(uint16_t node, uint8_t depth = 0)
+  {
+    if (depth >= 50)
+    {
+      ERROR_ARTI("Error: Compile recursion level too deep at node %u (%u)\n", node, depth);
+      errorOccurred = true;
+    }
+    if (errorOccurred || compileError) return false;
+    if (node == noNode) return true;
+
+    Node *n = &syntaxTree->nodes[node];
+
+    switch (n->kind)
+    {
+      case F_List:
+      {
+        for (uint16_t child = n->child; child != noNode; child = syntaxTree->nodes[child].next)
+          compile(child, depth + 1);
+        break;
+      }
+      case F_Constant:
+        byteCode->emit(O_Const);
+        byteCode->emitFloat(n->value);
+        byteCode->stack(1);
+        compiledValue();
+        break;
+      case F_Operator: //postfix: the operands are on the stack (see buildPostfix)
+        if (n->index == 1)
+          byteCode->emit(O_Neg);
+        else if (n->child != noNode) //&& and ||: compiled like a cex, a && b as a != 0 ? b != 0 : 0, a || b as a != 0 ? 1 : b != 0
+        {
+          compileBool();
+          byteCode->emit(O_JumpIfNot);
+          uint16_t falsePos = byteCode->length;
+          byteCode->emitUint16(0);
+          byteCode->stack(-1);
+
+          if (n->token == F_and)
+          {
+            for (uint16_t child = n->child; child != noNode; child = syntaxTree->nodes[child].next)
+              compile(child, depth + 1);
+            compileBool();
+          }
+          else
+            compileConstant(1);
+
+          byteCode->emit(O_Jump);
+          uint16_t endPos = byteCode->length;
+          byteCode->emitUint16(0);
+          byteCode->stack(-1);
+          byteCode->patchUint16(falsePos, byteCode->length);
+
+          if (n->token == F_and)
+            compileConstant(0);
+          else
+          {
+            for (uint16_t child = n->child; child != noNode; child = syntaxTree->nodes[child].next)
+              compile(child, depth + 1);
+            compileBool();
+          }
+
+          byteCode->patchUint16(endPos, byteCode->length);
+        }
+        else
+        {
+          uint8_t opCode = tokenToOpCode(n->token);
+          if (opCode == O_NoOpCode)
+            compileNotSupported("operator", n->token);
+          byteCode->emit(opCode);
+          byteCode->stack(-1);
+        }
+        break;
+      case F_Program:
+      {
+        compileStatements(n->child, depth + 1);
+        byteCode->emit(O_Halt);
+        break;
+      }
+      case F_Function:
+      {
+        Symbol* function_symbol = n->symbol;
+
+        //function body is placed inline, jump over it
+        byteCode->emit(O_Jump);
+        uint16_t jumpPos = byteCode->length;
+        byteCode->emitUint16(0);
+
+        function_symbol->code_entry = byteCode->length;
+        byteCode->functionIndex(function_symbol); //all functions, see RegisterCode::translate
+        uint8_t stackDepth = byteCode->stackDepth;
+        byteCode->stackDepth = 0;
+        compileStatements(n->child, depth + 1);
+        byteCode->emit(O_Return);
+        byteCode->stackDepth = stackDepth;
+
+        byteCode->patchUint16(jumpPos, byteCode->length);
+        break;
+      }
+      case F_Call:
+      {
+        bool inExpression = contextsIndex > 0 && contexts[contextsIndex-1].kind != C_Statements;
+
+        if (n->external != noExternal)
+        {
+          uint8_t external = n->external;
+          openContext(C_Values);
+          compile(n->child, depth + 1);
+          uint8_t nrOfActuals = closeContext();
+          if (nrOfActuals > 5)
+            compileNotSupported("number of actuals", nrOfActuals);
+
+          byteCode->emit(O_CallExt);
+          byteCode->emit(external);
+          byteCode->emit(nrOfActuals);
+          byteCode->emit(inExpression);
+          byteCode->stack(-nrOfActuals);
+          if (inExpression)
+          {
+            byteCode->stack(1);
+            compiledValue();
+          }
+        }
+        else
+        {
+          Symbol* function_symbol = n->symbol;
+
+          if (inExpression)
+            compileNotSupported("function call in expression");
+          else
+          {
+            openContext(C_Values);
+            compile(n->child, depth + 1);
+            uint8_t nrOfActuals = closeContext();
+            uint8_t nrOfFormals = function_symbol->function_scope->nrOfFormals;
+
+            for (; nrOfActuals < nrOfFormals; nrOfActuals++) //missing actuals are 0
+            {
+              byteCode->emit(O_Const);
+              byteCode->emitFloat(0);
+              byteCode->stack(1);
+            }
+            if (nrOfActuals > nrOfFormals)
+            {
+              byteCode->emit(O_Pop);
+              byteCode->emit(nrOfActuals - nrOfFormals);
+            }
+
+            byteCode->emit(O_Call);
+            byteCode->emit(byteCode->functionIndex(function_symbol));
+            byteCode->stack(-nrOfActuals);
+          }
+        }
+        break;
+      }
+      case F_VarRef:
+      case F_Assign:
+      {
+        uint8_t nodeKind = n->kind;
+        uint8_t level = n->level;
+        uint8_t index = n->index;
+        uint8_t external = n->external;
+        uint8_t assignOperator = n->token;
+        uint16_t indicesList = syntaxTree->child(node, 0);
+        bool hasExpr = false;
+
+        if (nodeKind == F_Assign)
+        {
+          uint16_t exprList = syntaxTree->child(node, 1);
+          hasExpr = syntaxTree->nodes[exprList].child != noNode;
+
+          if (hasExpr)
+            compileValue(exprList, "expr", depth + 1);
+        }
+
+        if (nodeKind == F_Assign && external != noExternal && !hasExpr) //e.g. ++ on external: set to no value like interpret
+        {
+          byteCode->emit(O_Const);
+          byteCode->emitFloat(floatNull);
+          byteCode->stack(1);
+        }
+
+        openContext(C_Values);
+        compile(indicesList, depth + 1);
+        uint8_t nrOfIndices = closeContext();
+
+        if (external != noExternal)
+        {
+          if (nrOfIndices > 2)
+            compileNotSupported("number of indices", nrOfIndices);
+
+          if (nodeKind == F_VarRef && nrOfIndices == 0 && uniformIndex(external) < nrOfUniforms)
+          {
+            byteCode->emit(O_LoadUniform);
+            byteCode->emit(uniformIndex(external));
+            byteCode->stack(1);
+            compiledValue();
+          }
+          else if (nodeKind == F_VarRef)
+          {
+            byteCode->emit(O_LoadExt);
+            byteCode->emit(external);
+            byteCode->emit(nrOfIndices);
+            byteCode->stack(1 - nrOfIndices);
+            compiledValue();
+          }
+          else
+          {
+            byteCode->emit(O_StoreExt);
+            byteCode->emit(external);
+            byteCode->emit(nrOfIndices);
+            byteCode->stack(-nrOfIndices - 1);
+          }
+        }
+        else
+        {
+          if (nrOfIndices > 0) //indices of internal variables not supported yet, only evaluated (like interpret)
+          {
+            byteCode->emit(O_Pop);
+            byteCode->emit(nrOfIndices);
+            byteCode->stack(-nrOfIndices);
+          }
+
+          if (nodeKind == F_VarRef)
+          {
+            byteCode->emit(O_Load);
+            byteCode->emit(level);
+            byteCode->emit(index);
+            byteCode->stack(1);
+            compiledValue();
+          }
+          else
+          {
+            if (hasExpr && (assignOperator == F_plusplus || assignOperator == F_minmin))
+            {
+              byteCode->emit(O_Pop);
+              byteCode->emit(1);
+              byteCode->stack(-1);
+              hasExpr = false;
+            }
+            else if (!hasExpr && assignOperator != F_plusplus && assignOperator != F_minmin)
+              compileNotSupported("assign without expression");
+
+            byteCode->emit(O_Store);
+            byteCode->emit(level);
+            byteCode->emit(index);
+            byteCode->emit(assignOperator);
+            if (hasExpr)
+              byteCode->stack(-1);
+          }
+        }
+        break;
+      }
+      case F_Expr:
+      case F_Term:
+      {
+        openContext(C_Expression);
+        for (uint16_t child = n->child; child != noNode; child = syntaxTree->nodes[child].next)
+          compile(child, depth + 1);
+        closeContext();
+        compiledValue();
+        break;
+      }
+      case F_For:
+      {
+        compileStatements(syntaxTree->child(node, 0), depth + 1);
+
+        //iteration counter, loop mode and pascal loop value
+        for (uint8_t i=0; i<3; i++)
+        {
+          byteCode->emit(O_Const);
+          byteCode->emitFloat(0);
+        }
+        byteCode->stack(3);
+
+        uint16_t loopPos = byteCode->length;
+        byteCode->emit(O_ForLoop);
+        uint16_t endPos1 = byteCode->length;
+        byteCode->emitUint16(0);
+
+        compileValue(syntaxTree->child(node, 1), "expr", depth + 1);
+        byteCode->emit(O_ForCond);
+        uint16_t endPos2 = byteCode->length;
+        byteCode->emitUint16(0);
+        byteCode->stack(-1);
+
+        compileStatements(syntaxTree->child(node, 2), depth + 1);
+
+        byteCode->emit(O_ForNext);
+        byteCode->emitUint16(loopPos);
+
+        compileStatements(syntaxTree->child(node, 3), depth + 1);
+
+        byteCode->emit(O_Jump);
+        byteCode->emitUint16(loopPos);
+
+        byteCode->patchUint16(endPos1, byteCode->length);
+        byteCode->patchUint16(endPos2, byteCode->length);
+        byteCode->emit(O_Pop);
+        byteCode->emit(3);
+        byteCode->stack(-3);
+        break;
+      }
+      case F_If:
+      {
+        uint16_t exprList = syntaxTree->child(node, 0);
+        uint16_t elseList = syntaxTree->child(node, 2);
+
+        if (syntaxTree->nodes[exprList].child != noNode)
+          compileValue(exprList, "expr", depth + 1);
+        else
+          compileNotSupported("if without expression");
+
+        byteCode->emit(O_JumpIfNot);
+        uint16_t elsePos = byteCode->length;
+        byteCode->emitUint16(0);
+        byteCode->stack(-1);
+
+        compileStatements(syntaxTree->child(node, 1), depth + 1);
+
+        if (syntaxTree->nodes[elseList].child != noNode)
+        {
+          byteCode->emit(O_Jump);
+          uint16_t endPos = byteCode->length;
+          byteCode->emitUint16(0);
+          byteCode->patchUint16(elsePos, byteCode->length);
+
+          compileStatements(elseList, depth + 1);
+
+          byteCode->patchUint16(endPos, byteCode->length);
+        }
+        else
+          byteCode->patchUint16(elsePos, byteCode->length);
+        break;
+      }
+      case F_Cex:
+      {
+        compileValue(syntaxTree->child(node, 0), "expr", depth + 1);
+
+        byteCode->emit(O_JumpIfNot);
+        uint16_t falsePos = byteCode->length;
+        byteCode->emitUint16(0);
+        byteCode->stack(-1);
+
+        compileValue(syntaxTree->child(node, 1), "trueExpr", depth + 1);
+
+        byteCode->emit(O_Jump);
+        uint16_t endPos = byteCode->length;
+        byteCode->emitUint16(0);
+        byteCode->stack(-1);
+        byteCode->patchUint16(falsePos, byteCode->length);
+
+        compileValue(syntaxTree->child(node, 2), "falseExpr", depth + 1);
+
+        byteCode->patchUint16(endPos, byteCode->length);
+        compiledValue();
+        break;
+      }
+      default:
+        ERROR_ARTI("%s Programming error: node %s not compiled\n", spaces+50-depth, nodeToString(n->kind));
+    }
+
+    return !errorOccurred && !compileError;
+  } //compile
+
+  //the activation record of the variable's level, level 0: variable created in current scope
+  ActivationRecord* activationRecord(uint8_t level)
+  {
+    if (level == 0)
+      return this->callStack->peek();
+    return this->callStack->find(level);
+  }
+
+  //runs byteCode from pc until return or halt, the activation record must be pushed already
+  bool execute(uint16_t pc)
+  {
+    const uint8_t *code = byteCode->code;
+    float *stack = valueStack->floatStack;
+    uint8_t sp = valueStack->stack_index;
+    ActivationRecord* ar = this->callStack->peek();
+
+    while (true)
+    {
+      switch (code[pc])
+      {
+        case O_Halt:
+        case O_Return:
+          valueStack->stack_index = sp;
+          return !errorOccurred;
+        case O_Const:
+          memcpy(&stack[sp++], code + pc + 1, sizeof(float));
+          pc += 1 + sizeof(float);
+          break;
+        case O_Load:
+          stack[sp++] = activationRecord(code[pc+1])->floatMembers[code[pc+2]];
+          pc += 3;
+          break;
+        case O_Store:
+        {
+          ActivationRecord* varAr = activationRecord(code[pc+1]);
+          uint8_t index = code[pc+2];
+          switch (code[pc+3])
+          {
+            case F_plus:
+              varAr->set(index, varAr->getFloat(index) + stack[--sp]);
+              break;
+            case F_minus:
+              varAr->set(index, varAr->getFloat(index) - stack[--sp]);
+              break;
+            case F_multiplication:
+              varAr->set(index, varAr->getFloat(index) * stack[--sp]);
+              break;
+            case F_division:
+            {
+              float divisor = stack[--sp];
+              if (divisor == 0)
+              {
+                divisor = 1;
+                ERROR_ARTI("/= division by 0 not possible, divisor ignored for %f\n", varAr->getFloat(index));
+              }
+              varAr->set(index, varAr->getFloat(index) / divisor);
+              break;
+            }
+            case F_plusplus:
+              varAr->set(index, varAr->getFloat(index) + 1);
+              break;
+            case F_minmin:
+              varAr->set(index, varAr->getFloat(index) - 1);
+              break;
+            default:
+              varAr->set(index, stack[--sp]);
+          }
+          pc += 4;
+          break;
+        }
+        case O_LoadExt:
+        {
+          uint8_t nrOfIndices = code[pc+2];
+          sp -= nrOfIndices;
+          float result = arti_get_external_variable(code[pc+1], nrOfIndices>0?stack[sp]:floatNull, nrOfIndices>1?stack[sp+1]:floatNull);
+          if (result == floatNull)
+            ERROR_ARTI("Error: ext %u no value\n", code[pc+1]);
+          stack[sp++] = result;
+          if (errorOccurred) return false;
+          pc += 3;
+          break;
+        }
+        case O_LoadUniform:
+          stack[sp++] = uniforms[code[pc+1]];
+          pc += 2;
+          break;
+        case O_StoreExt:
+        {
+          uint8_t nrOfIndices = code[pc+2];
+          sp -= nrOfIndices + 1;
+          arti_set_external_variable(stack[sp], code[pc+1], nrOfIndices>0?stack[sp+1]:floatNull, nrOfIndices>1?stack[sp+2]:floatNull);
+          if (errorOccurred) return false;
+          pc += 3;
+          break;
+        }
+        case O_CallExt:
+        {
+          uint8_t nrOfActuals = code[pc+2];
+          sp -= nrOfActuals;
+          float result = arti_external_function(code[pc+1], nrOfActuals>0?stack[sp]:floatNull
+                                                          , nrOfActuals>1?stack[sp+1]:floatNull
+                                                          , nrOfActuals>2?stack[sp+2]:floatNull
+                                                          , nrOfActuals>3?stack[sp+3]:floatNull
+                                                          , nrOfActuals>4?stack[sp+4]:floatNull);
+          if (code[pc+3]) //keep result
+            stack[sp++] = result;
+          if (errorOccurred) return false;
+          pc += 4;
+          break;
+        }
+        case O_Call:
+        {
+          Symbol* function_symbol = byteCode->functions[code[pc+1]];
+          ScopedSymbolTable* function_scope = function_symbol->function_scope;
+
+          ActivationRecord* functionAr = this->callStack->allocate(function_symbol->name, function_symbol->scope_level + 1, function_scope->recordSize());
+          if (functionAr == nullptr)
+            return false;
+
+          sp -= function_scope->nrOfFormals;
+          for (uint8_t i=0; i<function_scope->nrOfFormals; i++)
+            functionAr->set(function_scope->symbols[i]->scope_index, stack[sp+i]);
+
+          if (sp + byteCode->maxStackDepth > arrayLength)
+          {
+            ERROR_ARTI("Call %s: no space left on stack (%u)\n", function_symbol->name, sp);
+            errorOccurred = true;
+          }
+          else
+            this->callStack->push(functionAr);
+
+          bool result = !errorOccurred;
+          if (result)
+          {
+            valueStack->stack_index = sp;
+            result = execute(function_symbol->code_entry);
+            this->callStack->pop();
+          }
+
+          this->callStack->release(functionAr);
+
+          if (!result) return false;
+          pc += 2;
+          break;
+        }
+        case O_Pop:
+          sp -= code[pc+1];
+          pc += 2;
+          break;
+        case O_Jump:
+          pc = code[pc+1] | (code[pc+2] << 8);
+          break;
+        case O_JumpIfNot:
+          if (stack[--sp] == 1)
+            pc += 3;
+          else
+            pc = code[pc+1] | (code[pc+2] << 8);
+          break;
+        case O_ForLoop: //stack: counter, mode, value
+          if (stack[sp-3] >= maxForIterations)
+          {
+            ERROR_ARTI("too many iterations in for loop %u\n", maxForIterations);
+            pc = code[pc+1] | (code[pc+2] << 8);
+          }
+          else
+          {
+            stack[sp-3]++;
+            pc += 3;
+          }
+          break;
+        case O_ForCond:
+        {
+          float conditionResult = stack[--sp];
+          if (conditionResult == 1)
+          {
+            stack[sp-2] = 1; //C mode: run block and increment
+            pc += 3;
+          }
+          else if (conditionResult == 0)
+            pc = code[pc+1] | (code[pc+2] << 8);
+          else // conditionResult is a value (e.g. in pascal)
+          {
+            float varValue = ar->getFloat(ar->lastSetIndex);
+            if (varValue <= conditionResult)
+            {
+              stack[sp-2] = 0; //pascal mode: run block and increment last set variable
+              stack[sp-1] = varValue;
+              pc += 3;
+            }
+            else
+              pc = code[pc+1] | (code[pc+2] << 8);
+          }
+          break;
+        }
+        case O_ForNext:
+          if (stack[sp-2] == 0)
+          {
+            ar->set(ar->lastSetIndex, stack[sp-1] + 1);
+            pc = code[pc+1] | (code[pc+2] << 8);
+          }
+          else
+            pc += 3;
+          break;
+        case O_Neg:
+          stack[sp-1] = -stack[sp-1];
+          pc++;
+          break;
+        default: //binary operators
         {
-          bool visitedAlready = false;
+          float right = stack[--sp];
+          float left = stack[sp-1];
+          float evaluation = 0;
+          switch (code[pc])
+          {
+            case O_Add: 
+              evaluation = left + right;
+              break;
+            case O_Sub: 
+              evaluation = left - right;
+              break;
+            case O_Mul: 
+              evaluation = left * right;
+              break;
+            case O_Div:
+              if (right == 0)
+              {
+                right = 1;
+                ERROR_ARTI("division by 0 not possible, divisor ignored for %f\n", left);
+              }
+              evaluation = left / right;
+              break;
+            case O_Mod:
+              if (right == 0) {
+                evaluation = left;
+                ERROR_ARTI("mod 0 not possible, mod ignored %f\n", left);
+              }
+              else 
+                evaluation = fmod(left, right);
+              break;
+            case O_Shl: 
+              evaluation = (int)left << (int)right;
+              break;
+            case O_Shr: 
+              evaluation = (int)left >> (int)right;
+              break;
+            case O_Eq: 
+              evaluation = left == right;
+              break;
+            case O_Ne: 
+              evaluation = left != right;
+              break;
+            case O_Lt: 
+              evaluation = left < right;
+              break;
+            case O_Le: 
+              evaluation = left <= right;
+              break;
+            case O_Gt: 
+              evaluation = left > right;
+              break;
+            case O_Ge: 
+              evaluation = left >= right;
+              break;
+            case O_And: 
+              evaluation = left && right;
+              break;
+            case O_Or: 
+              evaluation = left || right;
+              break;
+            default:
+              ERROR_ARTI("Programming error: unknown opcode %u at %u\n", code[pc], pc);
+              errorOccurred = true;
+              return false;
+          }
+          stack[sp-1] = evaluation;
+          pc++;
+        }
+      }
+    }
+  } //execute
 
-          if (strcmp(key, "*") == 0 ) // multiple
+  //operands are resolved as bases[base][index], see slot
+  void registerBases(float **bases)
+  {
+    ActivationRecord* ar = this->callStack->peek();
+
+    bases[S_Constants] = registerCode->constants;
+    bases[S_Temps] = valueStack->floatStack + valueStack->stack_index;
+    for (uint8_t level=0; level <= registerCode->maxLevel; level++)
+      bases[S_Level0 + level] = (level <= ar->nesting_level)?activationRecord(level)->floatMembers:nullptr;
+    bases[S_Uniforms] = uniforms;
+  }
+
+  #define operand(i) bases[instruction->operands[i].base][instruction->operands[i].index]
+
+  //R_Call: new activation record with the arguments, the temps of the function are placed after the temps of the caller
+  bool registerCall(Instruction *instruction, float **bases)
+  {
+    Symbol* function_symbol = registerCode->functions[instruction->index];
+    ScopedSymbolTable* function_scope = function_symbol->function_scope;
+
+    ActivationRecord* functionAr = this->callStack->allocate(function_symbol->name, function_symbol->scope_level + 1, function_scope->recordSize());
+    if (functionAr == nullptr)
+      return false;
+
+    for (uint8_t i=0; i<instruction->nrOfArgs; i++)
+      functionAr->set(function_scope->symbols[i]->scope_index, operand(i));
+
+    uint8_t stack_index = valueStack->stack_index;
+    if (stack_index + 2 * registerCode->maxStackDepth > arrayLength)
+    {
+      ERROR_ARTI("Call %s: no space left on stack (%u)\n", function_symbol->name, stack_index);
+      errorOccurred = true;
+    }
+    else
+      this->callStack->push(functionAr);
+
+    bool result = !errorOccurred;
+    if (result)
+    {
+      valueStack->stack_index = stack_index + registerCode->maxStackDepth;
+      result = runRegisters(function_symbol->code_entry);
+      valueStack->stack_index = stack_index;
+      this->callStack->pop();
+    }
+
+    this->callStack->release(functionAr);
+
+    return result;
+  }
+
+  //runs registerCode from instruction index with its machine code if jitted, else with executeRegisters
+  bool runRegisters(uint16_t index)
+  {
+    #if ARTI_JIT
+      if (jitCode != nullptr && jitCode->entries[index] != 0)
+      {
+        float *bases[nrOfBases];
+        registerBases(bases);
+        return jitCode->function(index)(bases, this);
+      }
+    #endif
+    return executeRegisters(index);
+  }
+
+  //runs registerCode from instruction index until return or halt, the activation record must be pushed already
+  bool executeRegisters(uint16_t index)
+  {
+    Instruction *instructions = registerCode->instructions;
+    Instruction *instruction = instructions + index;
+
+    float *bases[nrOfBases];
+    registerBases(bases);
+
+    #if ARTI_COUNT
+      #define COUNT_INSTRUCTION registerCode->executedInstructions++;
+    #else
+      #define COUNT_INSTRUCTION
+    #endif
+
+    #if ARTI_DISPATCH == ARTI_THREADED
+      //same order as RegisterOpCodes
+      static const void *handlers[] = {&&L_R_Halt, &&L_R_Return, &&L_R_Move, &&L_R_LoadExt, &&L_R_StoreExt, &&L_R_CallExt, &&L_R_Call
+                                     , &&L_R_Jump, &&L_R_JumpIfNot, &&L_R_ForLoop, &&L_R_ForCond, &&L_R_ForNext, &&L_R_Neg
+                                     , &&L_R_Add, &&L_R_Sub, &&L_R_Mul, &&L_R_Div, &&L_R_Mod, &&L_R_Shl, &&L_R_Shr
+                                     , &&L_R_Eq, &&L_R_Ne, &&L_R_Lt, &&L_R_Le, &&L_R_Gt, &&L_R_Ge, &&L_R_And, &&L_R_Or
+                                     , &&L_R_MulAdd, &&L_R_MulSub, &&L_R_MulMul, &&L_R_DivMul, &&L_R_AddMul, &&L_R_CallExtStore};
+
+      if (!registerCode->handlersSet)
+      {
+        for (uint16_t i=0; i<registerCode->instructionsLength; i++)
+          instructions[i].handler = instructions[i].opCode <= R_CallExtStore?handlers[instructions[i].opCode]:&&L_R_NoOpCode;
+        registerCode->handlersSet = true;
+      }
+
+      #define INSTRUCTION(opCode) L_##opCode:
+      #define DISPATCH COUNT_INSTRUCTION goto *instruction->handler
+
+      DISPATCH;
+    #else
+      #define INSTRUCTION(opCode) case opCode:
+      #define DISPATCH continue
+
+      while (true)
+      {
+      COUNT_INSTRUCTION
+      switch (instruction->opCode)
+      {
+    #endif
+
+        INSTRUCTION(R_Halt)
+        INSTRUCTION(R_Return)
+          return !errorOccurred;
+        INSTRUCTION(R_Move)
+          operand(0) = operand(1);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_LoadExt)
+        {
+          float result = arti_get_external_variable(instruction->index, operand(1), operand(2));
+          if (result == floatNull)
+            ERROR_ARTI("Error: ext %u no value\n", instruction->index);
+          operand(0) = result;
+          if (errorOccurred) return false;
+          instruction++;
+          DISPATCH;
+        }
+        INSTRUCTION(R_StoreExt)
+          arti_set_external_variable(operand(0), instruction->index, operand(1), operand(2));
+          if (errorOccurred) return false;
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_CallExt)
+          operand(0) = arti_external_function(instruction->index, operand(1), operand(2), operand(3), operand(4), operand(5));
+          if (errorOccurred) return false;
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_Call)
+          if (!registerCall(instruction, bases)) return false;
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_Jump)
+          instruction = instructions + instruction->address;
+          DISPATCH;
+        INSTRUCTION(R_JumpIfNot)
+          if (operand(0) == 1)
+            instruction++;
+          else
+            instruction = instructions + instruction->address;
+          DISPATCH;
+        INSTRUCTION(R_ForLoop) //temps: counter, mode, value
+        {
+          float *loop = bases[S_Temps] + instruction->index;
+          if (loop[0] >= maxForIterations)
           {
+            ERROR_ARTI("too many iterations in for loop %u\n", maxForIterations);
+            instruction = instructions + instruction->address;
           }
-          else if (strcmp(key, "token") == 0) // do nothing with added tokens
-            visitedAlready = true;
-          else if (this->definitionJson["TOKENS"].containsKey(key)) // if token
+          else
           {
-           const char * valueStr = value;
+            loop[0]++;
+            instruction++;
+          }
+          DISPATCH;
+        }
+        INSTRUCTION(R_ForCond)
+        {
+          float conditionResult = operand(0);
+          float *loop = bases[S_Temps] + instruction->index;
+          if (conditionResult == 1)
+          {
+            loop[1] = 1; //C mode: run block and increment
+            instruction++;
+          }
+          else if (conditionResult == 0)
+            instruction = instructions + instruction->address;
+          else // conditionResult is a value (e.g. in pascal)
+          {
+            float varValue = operand(1);
+            if (varValue <= conditionResult)
+            {
+              loop[1] = 0; //pascal mode: run block and increment loop variable
+              loop[2] = varValue;
+              instruction++;
+            }
+            else
+              instruction = instructions + instruction->address;
+          }
+          DISPATCH;
+        }
+        INSTRUCTION(R_ForNext)
+        {
+          float *loop = bases[S_Temps] + instruction->index;
+          if (loop[1] == 0)
+          {
+            operand(0) = loop[2] + 1;
+            instruction = instructions + instruction->address;
+          }
+          else
+            instruction++;
+          DISPATCH;
+        }
+        INSTRUCTION(R_Neg)
+          operand(0) = -operand(1);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_Add)
+          operand(0) = operand(1) + operand(2);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_Sub)
+          operand(0) = operand(1) - operand(2);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_Mul)
+          operand(0) = operand(1) * operand(2);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_Div)
+        {
+          float right = operand(2);
+          if (right == 0)
+          {
+            right = 1;
+            ERROR_ARTI("division by 0 not possible, divisor ignored for %f\n", operand(1));
+          }
+          operand(0) = operand(1) / right;
+          instruction++;
+          DISPATCH;
+        }
+        INSTRUCTION(R_Mod)
+          if (operand(2) == 0) {
+            operand(0) = operand(1);
+            ERROR_ARTI("mod 0 not possible, mod ignored %f\n", operand(1));
+          }
+          else 
+            operand(0) = fmod(operand(1), operand(2));
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_Shl)
+          operand(0) = (int)operand(1) << (int)operand(2);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_Shr)
+          operand(0) = (int)operand(1) >> (int)operand(2);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_Eq)
+          operand(0) = operand(1) == operand(2);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_Ne)
+          operand(0) = operand(1) != operand(2);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_Lt)
+          operand(0) = operand(1) < operand(2);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_Le)
+          operand(0) = operand(1) <= operand(2);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_Gt)
+          operand(0) = operand(1) > operand(2);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_Ge)
+          operand(0) = operand(1) >= operand(2);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_And)
+          operand(0) = operand(1) && operand(2);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_Or)
+          operand(0) = operand(1) || operand(2);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_MulAdd)
+          operand(0) = operand(1) * operand(2) + operand(3);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_MulSub)
+          operand(0) = operand(1) * operand(2) - operand(3);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_MulMul)
+          operand(0) = operand(1) * operand(2) * operand(3);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_DivMul)
+        {
+          float right = operand(2);
+          if (right == 0)
+          {
+            right = 1;
+            ERROR_ARTI("division by 0 not possible, divisor ignored for %f\n", operand(1));
+          }
+          operand(0) = operand(1) / right * operand(3);
+          instruction++;
+          DISPATCH;
+        }
+        INSTRUCTION(R_AddMul)
+          operand(0) = (operand(1) + operand(2)) * operand(3);
+          instruction++;
+          DISPATCH;
+        INSTRUCTION(R_CallExtStore)
+        {
+          arti_external_store_call(instruction->external, instruction->index, operand(1), operand(2), operand(3), operand(4), operand(5));
+          if (errorOccurred) return false;
+          instruction++;
+          DISPATCH;
+        }
 
-            if (strcmp(key, "INTEGER_CONST") == 0)
-              parseTree["token"] = F_integerConstant;
-            else if (strcmp(key, "REAL_CONST") == 0)
-              parseTree["token"] = F_realConstant;
-            else if (strcmp(valueStr, "+") == 0)
-              parseTree["token"] = F_plus;
-            else if (strcmp(valueStr, "-") == 0)
-              parseTree["token"] = F_minus;
-            else if (strcmp(valueStr, "*") == 0)
-              parseTree["token"] = F_multiplication;
-            else if (strcmp(valueStr, "/") == 0)
-              parseTree["token"] = F_division;
-            else if (strcmp(valueStr, "%") == 0)
-              parseTree["token"] = F_modulo;
-            else if (strcmp(valueStr, "<<") == 0)
-              parseTree["token"] = F_bitShiftLeft;
-            else if (strcmp(valueStr, ">>") == 0)
-              parseTree["token"] = F_bitShiftRight;
-            else if (strcmp(valueStr, "==") == 0)
-              parseTree["token"] = F_equal;
-            else if (strcmp(valueStr, "!=") == 0)
-              parseTree["token"] = F_notEqual;
-            else if (strcmp(valueStr, ">") == 0)
-              parseTree["token"] = F_greaterThen;
-            else if (strcmp(valueStr, ">=") == 0)
-              parseTree["token"] = F_greaterThenOrEqual;
-            else if (strcmp(valueStr, "<") == 0)
-              parseTree["token"] = F_lessThen;
-            else if (strcmp(valueStr, "<=") == 0)
-              parseTree["token"] = F_lessThenOrEqual;
-            else if (strcmp(valueStr, "&&") == 0)
-              parseTree["token"] = F_and;
-            else if (strcmp(valueStr, "||") == 0)
-              parseTree["token"] = F_or;
+    #if ARTI_DISPATCH == ARTI_THREADED
+      L_R_NoOpCode:
+    #else
+        default:
+          break;
+      } //switch
+      } //while
+    #endif
+
+    ERROR_ARTI("Programming error: unknown register opcode %u at %u\n", instruction->opCode, (unsigned int)(instruction - instructions));
+    errorOccurred = true;
+    return false;
+
+    #undef INSTRUCTION
+    #undef DISPATCH
+    #undef COUNT_INSTRUCTION
+  } //executeRegisters
+
+  #undef operand
+
+  //external states read (write false) or changed by an instruction, see arti_external_state
+  uint8_t instructionStates(Instruction *instruction, uint8_t *states, bool *write)
+  {
+    uint8_t length = 0;
+    if (instruction->opCode == R_LoadExt || instruction->opCode == R_StoreExt || instruction->opCode == R_CallExt || instruction->opCode == R_CallExtStore)
+    {
+      states[length] = arti_external_state(instruction->index);
+      *write = instruction->opCode != R_LoadExt; //an external function may change its state
+      if (states[length] != noExternal)
+        length++;
+    }
+    if (instruction->opCode == R_CallExtStore)
+    {
+      states[length] = arti_external_state(instruction->external);
+      if (states[length] != noExternal)
+        length++;
+    }
+    return length;
+  }
+
+  //lanes run the calls of a function in the order of the instructions instead of call after call, so the function must not depend on the order:
+  //no calls or loops, variables written before read (no values carried from call to call) and an external state changed by only one instruction (e.g. leds[i] = ...)
+  bool buildLanes(Symbol* function_symbol, uint8_t nrOfFormals)
+  {
+    const char *notSupported = nullptr;
+    Instruction *instructions = registerCode->instructions;
+
+    uint16_t end = function_symbol->code_entry;
+    while (notSupported == nullptr && instructions[end].opCode != R_Return)
+    {
+      if (LaneCode::readOperands(instructions[end].opCode) == noTarget)
+        notSupported = registerOpCodeToString(instructions[end].opCode);
+      else if ((instructions[end].opCode == R_Jump || instructions[end].opCode == R_JumpIfNot) && instructions[end].address <= end)
+        notSupported = "jump back";
+      end++;
+    }
+
+    if (notSupported == nullptr)
+      laneCode = new LaneCode(function_symbol, function_symbol->code_entry, end);
+    if (errorOccurred)
+      return false;
+
+    //formals are the first lane slots
+    Operand formal;
+    formal.base = S_Level0 + function_symbol->scope_level + 1;
+    for (uint8_t i=0; notSupported == nullptr && i<nrOfFormals; i++)
+    {
+      formal.index = function_symbol->function_scope->symbols[i]->scope_index;
+      laneCode->laneSlot(formal, L_Input);
+    }
+
+    uint16_t length = end - function_symbol->code_entry + 1;
+    for (uint16_t i=0; notSupported == nullptr && i<length; i++)
+    {
+      Instruction *instruction = &instructions[laneCode->entry + i];
+      uint16_t reads = LaneCode::readOperands(instruction->opCode);
+      bool writes = LaneCode::writesOperand(instruction->opCode);
+
+      if ((instruction->opCode == R_Jump || instruction->opCode == R_JumpIfNot) && instruction->address > end)
+        notSupported = "jump out of the function";
+
+      for (uint8_t j=0; notSupported == nullptr && j<nrOfOperands; j++)
+      {
+        if (!(reads & (1 << j)) && !(j == 0 && writes))
+          continue;
+
+        Operand operand = instruction->operands[j];
+        if (operand.base == S_Level0)
+          operand.base = formal.base; //level 0 is the record of the function, see activationRecord
+        uint8_t slot = laneCode->laneSlot(operand, operand.base == S_Constants?L_Constant:operand.base == S_Temps?L_Temp:L_Uniform);
+        if (slot == laneSlotsLength)
+          notSupported = "too many operands";
+        else
+        {
+          laneCode->slots[i][j] = slot;
+          if (j == 0 && writes && operand.base >= S_Level0)
+          {
+            laneCode->written |= (uint64_t)1 << slot;
+            if (laneCode->kinds[slot] == L_Uniform)
+              laneCode->kinds[slot] = L_Varying;
+          }
+        }
+      }
+    }
+
+    //variables written for sure before each instruction: intersection of the paths to it (jumps are forward)
+    uint64_t *writtenAt = (notSupported == nullptr)?(uint64_t *)malloc(length * sizeof(uint64_t)):nullptr;
+    if (notSupported == nullptr && writtenAt == nullptr)
+      notSupported = "no memory";
+    for (uint16_t i=0; writtenAt != nullptr && i<length; i++)
+      writtenAt[i] = ~(uint64_t)0;
+
+    uint64_t current = ((uint64_t)1 << nrOfFormals) - 1;
+    for (uint16_t i=0; notSupported == nullptr && i<length; i++)
+    {
+      Instruction *instruction = &instructions[laneCode->entry + i];
+      uint16_t reads = LaneCode::readOperands(instruction->opCode);
+      current &= writtenAt[i];
+
+      for (uint8_t j=0; j<nrOfOperands; j++)
+      {
+        uint64_t bit = (uint64_t)1 << laneCode->slots[i][j];
+        if ((reads & (1 << j)) && (laneCode->written & bit) && !(current & bit))
+          notSupported = "variable read before written";
+      }
+      if (LaneCode::writesOperand(instruction->opCode) && instruction->operands[0].base >= S_Level0)
+        current |= (uint64_t)1 << laneCode->slots[i][0];
+
+      if (instruction->opCode == R_Jump || instruction->opCode == R_JumpIfNot)
+        writtenAt[instruction->address - laneCode->entry] &= current;
+      if (instruction->opCode == R_Jump)
+        current = ~(uint64_t)0; //only reached by jumps
+    }
+    if (notSupported == nullptr && (laneCode->written & ~current) != 0)
+      notSupported = "variable not always written";
+    free(writtenAt);
+
+    //an external state changed by an instruction must not be used by another one
+    for (uint16_t i=0; notSupported == nullptr && i<length; i++)
+    {
+      uint8_t states[2];
+      bool write;
+      uint8_t statesLength = instructionStates(&instructions[laneCode->entry + i], states, &write);
+      for (uint16_t j=0; notSupported == nullptr && j<length; j++)
+      {
+        uint8_t otherStates[2];
+        bool otherWrite;
+        uint8_t otherLength = (i != j)?instructionStates(&instructions[laneCode->entry + j], otherStates, &otherWrite):0;
+        for (uint8_t k=0; k<statesLength; k++)
+          for (uint8_t l=0; l<otherLength; l++)
+            if (states[k] == otherStates[l] && (write || otherWrite))
+              notSupported = "external changed and used by more instructions";
+      }
+    }
+
+    if (notSupported != nullptr)
+    {
+      DEBUG_ARTI("lanes %s not supported: %s\n", function_symbol->name, notSupported);
+      delete laneCode; laneCode = nullptr;
+      return false;
+    }
+
+    for (uint8_t slot=0; slot<laneCode->slotsLength; slot++)
+      if (laneCode->kinds[slot] == L_Constant)
+        for (uint8_t lane=0; lane<ARTI_LANES; lane++)
+          laneCode->values[slot][lane] = registerCode->constants[laneCode->operands[slot].index];
+
+    MEMORY_ARTI("lanes %s: %u instructions, %u slots, %u lanes ✓\n", function_symbol->name, length, laneCode->slotsLength, ARTI_LANES);
+    return true;
+  } //buildLanes
+
+  //true if runLanes can run the function, nrOfFormals: the formals set by the caller
+  bool lanesSupported(Symbol* function_symbol, uint8_t nrOfFormals)
+  {
+    if (!lanesBuilt && lanes && ARTI_LANES > 1 && engine == E_RegisterVM)
+      buildLanes(function_symbol, nrOfFormals);
+    lanesBuilt = true;
+    return laneCode != nullptr && laneCode->function_symbol == function_symbol;
+  }
+
+  #define LANES(statement) for (uint8_t lane=0; lane<ARTI_LANES; lane++) {statement;}
+  #define ACTIVE_LANES(statement) LANES(if (active[lane]) {statement;})
+  //computed for all lanes (vectorized by the compiler), stored in the active lanes
+  #define LANE_OPERATION(expression) \
+  { \
+    float result[ARTI_LANES]; \
+    LANES(result[lane] = (expression)) \
+    if (allActive) \
+      memcpy(d, result, sizeof(result)); \
+    else \
+      ACTIVE_LANES(d[lane] = result[lane]) \
+  }
+
+  //runs the function of laneCode for count calls, formals[i][lane]: value of formal i in each call, the activation record must be pushed already
+  //if and cex are masks: lanes not taking a jump wait until the instructions reach its target
+  bool runLanes(float formals[][ARTI_LANES], uint8_t count)
+  {
+    Instruction *instructions = registerCode->instructions;
+    float (*values)[ARTI_LANES] = laneCode->values;
+
+    float *bases[nrOfBases];
+    registerBases(bases);
+
+    for (uint8_t slot=0; slot<laneCode->slotsLength; slot++)
+    {
+      if (laneCode->kinds[slot] == L_Input)
+        memcpy(values[slot], formals[slot], sizeof(values[slot]));
+      else if (laneCode->kinds[slot] == L_Uniform)
+      {
+        float value = bases[laneCode->operands[slot].base][laneCode->operands[slot].index];
+        LANES(values[slot][lane] = value)
+      }
+    }
+
+    bool active[ARTI_LANES];
+    uint16_t waiting[ARTI_LANES]; //jump target of an inactive lane
+    LANES(active[lane] = lane < count; waiting[lane] = noTarget)
+    bool allActive = count == ARTI_LANES;
+    uint16_t nextTarget = noTarget; //first target waited for
+
+    uint16_t index = laneCode->entry;
+    while (true)
+    {
+      if (index == nextTarget)
+      {
+        uint8_t activeLanes = 0;
+        nextTarget = noTarget;
+        LANES(
+          if (waiting[lane] == index)
+          {
+            active[lane] = true;
+            waiting[lane] = noTarget;
+          }
+          else if (waiting[lane] < nextTarget)
+            nextTarget = waiting[lane];
+          activeLanes += active[lane]
+        )
+        allActive = activeLanes == ARTI_LANES;
+      }
+
+      Instruction *instruction = instructions + index;
+      uint8_t *slots = laneCode->slots[index - laneCode->entry];
+      float *d = values[slots[0]], *a = values[slots[1]], *b = values[slots[2]], *c = values[slots[3]];
+
+      switch (instruction->opCode)
+      {
+        case R_Return:
+          for (uint8_t slot=0; slot<laneCode->slotsLength; slot++)
+            if (laneCode->written & ((uint64_t)1 << slot))
+              bases[laneCode->operands[slot].base][laneCode->operands[slot].index] = values[slot][count - 1];
+          return !errorOccurred;
+        case R_Move:
+          LANE_OPERATION(a[lane])
+          break;
+        case R_LoadExt:
+          ACTIVE_LANES(
+            float result = arti_get_external_variable(instruction->index, a[lane], b[lane]);
+            if (result == floatNull)
+              ERROR_ARTI("Error: ext %u no value\n", instruction->index);
+            d[lane] = result;
+            if (errorOccurred) return false
+          )
+          break;
+        case R_StoreExt:
+          ACTIVE_LANES(
+            arti_set_external_variable(d[lane], instruction->index, a[lane], b[lane]);
+            if (errorOccurred) return false
+          )
+          break;
+        case R_CallExt:
+        {
+          float *e = values[slots[4]], *f = values[slots[5]];
+          ACTIVE_LANES(
+            d[lane] = arti_external_function(instruction->index, a[lane], b[lane], c[lane], e[lane], f[lane]);
+            if (errorOccurred) return false
+          )
+          break;
+        }
+        case R_CallExtStore:
+        {
+          float *e = values[slots[4]], *f = values[slots[5]];
+          ACTIVE_LANES(
+            arti_external_store_call(instruction->external, instruction->index, a[lane], b[lane], c[lane], e[lane], f[lane]);
+            if (errorOccurred) return false
+          )
+          break;
+        }
+        case R_Jump:
+        case R_JumpIfNot:
+        {
+          uint8_t activeLanes = 0;
+          bool jumped = false;
+          ACTIVE_LANES(
+            if (instruction->opCode == R_Jump || d[lane] != 1)
+            {
+              active[lane] = false;
+              waiting[lane] = instruction->address;
+              jumped = true;
+            }
             else
-              ERROR_ARTI("%s Programming error: token not defined as operator %s %s (%u)\n", spaces+50-depth, key, value.as<std::string>().c_str(), depth);
+              activeLanes++
+          )
+          if (jumped && instruction->address < nextTarget)
+            nextTarget = instruction->address;
+          allActive = activeLanes == ARTI_LANES;
+          index = activeLanes > 0?index + 1:nextTarget;
+          continue;
+        }
+        case R_Neg:
+          LANE_OPERATION(-a[lane])
+          break;
+        case R_Add:
+          LANE_OPERATION(a[lane] + b[lane])
+          break;
+        case R_Sub:
+          LANE_OPERATION(a[lane] - b[lane])
+          break;
+        case R_Mul:
+          LANE_OPERATION(a[lane] * b[lane])
+          break;
+        case R_Div:
+          ACTIVE_LANES(d[lane] = artiDivision(a[lane], b[lane]))
+          break;
+        case R_Mod:
+          ACTIVE_LANES(d[lane] = artiModulo(a[lane], b[lane]))
+          break;
+        case R_Shl:
+          LANE_OPERATION((int)a[lane] << (int)b[lane])
+          break;
+        case R_Shr:
+          LANE_OPERATION((int)a[lane] >> (int)b[lane])
+          break;
+        case R_Eq:
+          LANE_OPERATION(a[lane] == b[lane])
+          break;
+        case R_Ne:
+          LANE_OPERATION(a[lane] != b[lane])
+          break;
+        case R_Lt:
+          LANE_OPERATION(a[lane] < b[lane])
+          break;
+        case R_Le:
+          LANE_OPERATION(a[lane] <= b[lane])
+          break;
+        case R_Gt:
+          LANE_OPERATION(a[lane] > b[lane])
+          break;
+        case R_Ge:
+          LANE_OPERATION(a[lane] >= b[lane])
+          break;
+        case R_And:
+          LANE_OPERATION(a[lane] && b[lane])
+          break;
+        case R_Or:
+          LANE_OPERATION(a[lane] || b[lane])
+          break;
+        case R_MulAdd:
+          LANE_OPERATION(a[lane] * b[lane] + c[lane])
+          break;
+        case R_MulSub:
+          LANE_OPERATION(a[lane] * b[lane] - c[lane])
+          break;
+        case R_MulMul:
+          LANE_OPERATION(a[lane] * b[lane] * c[lane])
+          break;
+        case R_DivMul:
+          ACTIVE_LANES(d[lane] = artiDivision(a[lane], b[lane]) * c[lane])
+          break;
+        case R_AddMul:
+          LANE_OPERATION((a[lane] + b[lane]) * c[lane])
+          break;
+        default:
+          ERROR_ARTI("Programming error: register opcode %s not supported by lanes\n", registerOpCodeToString(instruction->opCode));
+          errorOccurred = true;
+          return false;
+      }
+      index++;
+    }
+  } //runLanes
 
-            visitedAlready = true;
-          }
-          else //if key is node_name
-          {
-            uint8_t node = stringToNode(key);
+  #undef LANES
+  #undef ACTIVE_LANES
+  #undef LANE_OPERATION
 
-            switch (node) 
-            {
-              case F_Program: 
-              {
-                const char * program_name = value["ID"];
-                global_scope = new ScopedSymbolTable(program_name, 1, nullptr); //current_scope
+  #if ARTI_THREADS
 
-                ANDBG_ARTI("%s Program %s %u %u\n", spaces+50-depth, global_scope->scope_name, global_scope->scope_level, global_scope->symbolsIndex); 
+  //true if runParallel can run the function (see checkParallel), indices: the number of formals used as indices of the external variables it sets (e.g. 1 for leds[x] = ...), 0 if none
+  //the caller checks that the calls set different elements
+  bool parallelSupported(Symbol* function_symbol, uint8_t *indices)
+  {
+    *indices = parallelIndices;
+    return threads > 1 && parallelFunction != nullptr && function_symbol == parallelFunction;
+  }
 
-                if (value["ID"].isNull()) {
-                  ERROR_ARTI("program name null\n");
-                  errorOccurred = true;
-                }
-                if (value["block"].isNull()) {
-                  ERROR_ARTI("%s Program %s: no block in parseTree\n", spaces+50-depth, program_name); 
-                  errorOccurred = true;
-                }
-                else {
-                  analyze(value["block"], nullptr, global_scope, depth + 1);
-                }
+  //a copy running the code of this ARTI with its own stacks and program record, see runParallel
+  ARTI *newWorker()
+  {
+    ARTI *worker = new ARTI(*this);
+    worker->parallelPool = nullptr;
+    worker->threads = 1;
+    worker->laneCode = nullptr; //its own lane values, see lanesSupported
+    worker->lanesBuilt = false;
+    worker->callStack = new CallStack(arenaLength);
+    worker->valueStack = new ValueStack();
+    worker->colors = ColorTable(); //its own colors of the frame, the owner is set by startParallel
+    worker->colors.framesStarted = true;
+    worker->colors.shared = &colors;
+    worker->callStack->push(worker->callStack->allocate(global_scope->scope_name, 1, global_scope->recordSize()));
+    return worker;
+  }
 
-                #ifdef ARTI_DEBUG
-                  for (uint8_t i=0; i<global_scope->symbolsIndex; i++) {
-                    Symbol* symbol = global_scope->symbols[i];
-                    ANDBG_ARTI("%s %u %s %s.%s of %u (%u)\n", spaces+50-depth, i, nodeToString(symbol->symbol_type), global_scope->scope_name, symbol->name, symbol->type, symbol->scope_level); 
-                  }
-                #endif
+  //only deletes what newWorker created, the code belongs to the ARTI it was copied from
+  static void deleteWorker(ARTI *worker)
+  {
+    delete worker->callStack; worker->callStack = nullptr;
+    delete worker->valueStack; worker->valueStack = nullptr;
+    worker->colors.release();
+    if (worker->laneCode != nullptr) {delete worker->laneCode; worker->laneCode = nullptr;}
+    delete worker;
+  }
 
-                visitedAlready = true;
-                break;
-              }
-              case F_Function: 
-              {
-                //find the function name (so we must know this is a function...)
-                const char * function_name = value["ID"];
-                Symbol* function_symbol = new Symbol(node, function_name);
-                current_scope->insert(function_symbol);
+  //runs the calls first..last - 1 of the function, with lanes if supported
+  bool runCalls(Symbol* function_symbol, uint8_t nrOfFormals, uint16_t first, uint16_t last, FormalsFunction setFormals)
+  {
+    ActivationRecord* ar = this->callStack->allocate(function_symbol->name, function_symbol->scope_level + 1, function_symbol->function_scope->recordSize());
+    if (ar == nullptr)
+      return false;
+    float formals[nrOfVariables];
+    bool result = true;
 
-                ANDBG_ARTI("%s Function %s.%s\n", spaces+50-depth, current_scope->scope_name, function_name);
-                ScopedSymbolTable* function_scope = new ScopedSymbolTable(function_name, current_scope->scope_level + 1, current_scope);
-                if (current_scope->child_scopesIndex < nrOfChildScope)
-                  current_scope->child_scopes[current_scope->child_scopesIndex++] = function_scope;
-                else
-                  ERROR_ARTI("ScopedSymbolTable %s childs full (%d)", current_scope->scope_name, nrOfChildScope);
-                function_symbol->function_scope = function_scope;
+    if (lanesSupported(function_symbol, nrOfFormals))
+    {
+      float laneFormals[nrOfVariables][ARTI_LANES];
+      for (uint16_t i = first; result && i < last; i += ARTI_LANES)
+      {
+        uint8_t count = (last - i < ARTI_LANES)?last - i:ARTI_LANES;
+        for (uint8_t lane = 0; lane < count; lane++)
+        {
+          setFormals(i + lane, formals);
+          for (uint8_t j=0; j<nrOfFormals; j++)
+            laneFormals[j][lane] = formals[j];
+        }
 
-                if (value.containsKey("formals"))
-                  analyze(value["formals"], nullptr, function_scope, depth + 1);
+        this->callStack->push(ar);
+        result = runLanes(laneFormals, count);
+        this->callStack->pop();
+      }
+    }
+    else
+    {
+      for (uint16_t i = first; result && i < last; i++)
+      {
+        setFormals(i, formals);
+        for (uint8_t j=0; j<nrOfFormals; j++)
+          ar->set(function_symbol->function_scope->symbols[j]->scope_index, formals[j]);
 
-                function_scope->nrOfFormals = function_scope->symbolsIndex;
+        this->callStack->push(ar);
+        result = run(function_symbol);
+        this->callStack->pop();
+      }
+    }
 
-                if (value["block"].isNull())
-                  ERROR_ARTI("%s Function %s: no block in parseTree\n", spaces+50-depth, function_name); 
-                else
-                  analyze(value["block"], nullptr, function_scope, depth + 1);
+    this->callStack->release(ar);
+    return result && !errorOccurred;
+  }
 
-                #ifdef ARTI_DEBUG
-                  for (uint8_t i=0; i<function_scope->symbolsIndex; i++) {
-                    Symbol* symbol = function_scope->symbols[i];
-                    ANDBG_ARTI("%s %u %s %s.%s of %u (%u)\n", spaces+50-depth, i, nodeToString(symbol->symbol_type), function_scope->scope_name, symbol->name, symbol->type, symbol->scope_level); 
-                  }
-                #endif
+  //worker id runs the chunks of its own range, then steals the chunks left in the ranges of the others
+  void parallelWork(ParallelPool *pool, uint8_t id)
+  {
+    ARTI *worker = pool->workers[id];
+    for (uint8_t i=0; i<pool->size; i++)
+    {
+      uint8_t range = (id + i) % pool->size;
+      uint32_t chunk;
+      while (!pool->failed && (chunk = pool->next[range]++) < pool->end[range])
+      {
+        uint16_t first = chunk * parallelChunk;
+        uint16_t last = (pool->count - first < parallelChunk)?pool->count:first + parallelChunk;
+        if (!worker->runCalls(pool->function_symbol, pool->nrOfFormals, first, last, pool->setFormals))
+          pool->failed = true;
+        if (last == pool->count)
+          pool->last = id;
+      }
+    }
+  }
 
-                visitedAlready = true;
-                break;
-              }
-              case F_VarDef:
-              case F_Formal:
-              case F_Assign:
-              case F_VarRef: 
-              {
-                JsonObject variable_value;
-                if (node == F_Assign) 
-                  variable_value = value["varref"];
-                else
-                  variable_value = value;
+  //thread of worker id: waits for a run, works on it, until the pool stops
+  static void parallelThread(ARTI *arti, ParallelPool *pool, uint8_t id)
+  {
+    uint32_t generation = 0;
+    while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(pool->mutex);
+        pool->started.wait(lock, [pool, generation] {return pool->stop || pool->generation != generation;});
+        if (pool->stop)
+          return;
+        generation = pool->generation;
+      }
 
-                const char * variable_name;
-                variable_name = variable_value["ID"];
+      arti->parallelWork(pool, id);
 
-                if (variable_value.containsKey("indices"))
-                  analyze(variable_value, "indices", current_scope, depth + 1);
+      {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->running--;
+      }
+      pool->finished.notify_one();
+    }
+  }
 
-                //check if external variable
-                bool externalFound = false;
-                uint8_t index = 0;
-                for (JsonPair externalsPair: definitionJson["EXTERNALS"].as<JsonObject>()) {
-                  if (strcmp(variable_name, externalsPair.key().c_str()) == 0) {
-                      variable_value["external"] = index; //add external index to parseTree
-                    ANDBG_ARTI("%s Ext Variable found %s (%u) %s\n", spaces+50-depth, variable_name, depth, key);
-                    externalFound = true;
-                  }
-                  index++;
-                }
+  void startParallel()
+  {
+    parallelPool = new ParallelPool();
+    parallelPool->size = threads < nrOfThreads?threads:nrOfThreads;
+    for (uint8_t i=0; i<parallelPool->size; i++)
+    {
+      parallelPool->workers[i] = newWorker();
+      parallelPool->workers[i]->colors.owner = i + 1;
+    }
+    for (uint8_t i=1; i<parallelPool->size; i++)
+      parallelPool->threads[i] = std::thread(parallelThread, this, parallelPool, i);
+    MEMORY_ARTI("parallel %u threads ✓\n", parallelPool->size);
+  }
 
-                if (!externalFound) 
-                {
-                  Symbol* var_symbol = current_scope->lookup(variable_name); //lookup here and parent scopes
-                  if (node == F_VarRef) 
-                  {
-                    if (var_symbol == nullptr) 
-                      WARNING_ARTI("%s VarRef %s ID not found in scope of %s\n", spaces+50-depth, variable_name, current_scope->scope_name); 
-                      //only warning: value 0 in interpreter (div 0 is captured)
-                    else 
-                      ANDBG_ARTI("%s VarRef found %s.%s (%u)\n", spaces+50-depth, var_symbol->scope->scope_name, variable_name, depth);
-                  }
-                  else //assign and var/formal
-                  {
-                    //if variable not already defined, then add
-                    if (node != F_Assign || var_symbol == nullptr) //only assign needs to check if not exists
-                    {
-                      char param_type[charLength]; 
-                      if (variable_value.containsKey("type")) 
-                        serializeJson(variable_value["type"], param_type); //current_scope.lookup(param.type_node.value); //need string, lookup also used to find types...
-                      else
-                        strcpy(param_type, "notype");
+  void stopParallel()
+  {
+    if (parallelPool == nullptr)
+      return;
+    {
+      std::lock_guard<std::mutex> lock(parallelPool->mutex);
+      parallelPool->stop = true;
+    }
+    parallelPool->started.notify_all();
+    for (uint8_t i=1; i<parallelPool->size; i++)
+      parallelPool->threads[i].join();
+    for (uint8_t i=0; i<parallelPool->size; i++)
+      deleteWorker(parallelPool->workers[i]);
+    delete parallelPool; parallelPool = nullptr;
+  }
 
-                      var_symbol = new Symbol(node, variable_name, 9); // no type support yet
-                      if (node == F_Assign)
-                        global_scope->insert(var_symbol); // assigned variables are global scope
-                      else
-                        current_scope->insert(var_symbol);
+  //runs count calls of the function (see parallelSupported) on the threads, setFormals(call, formals) sets the formals of a call, the program record must be the first on the callStack
+  //the workers run with a copy of the program record: the variables the function assigns are written in each call, so the copy of the worker which ran the last call is the program record afterwards
+  bool runParallel(Symbol* function_symbol, uint8_t nrOfFormals, uint16_t count, FormalsFunction setFormals)
+  {
+    if (parallelPool == nullptr)
+      startParallel();
+    ParallelPool *pool = parallelPool;
 
-                      ANDBG_ARTI("%s %s %s.%s of %s\n", spaces+50-depth, key, var_symbol->scope->scope_name, variable_name, param_type);
-                    }
-                    else if (node != F_Assign && var_symbol != nullptr)
-                      ERROR_ARTI("%s %s Duplicate ID %s.%s\n", spaces+50-depth, key, var_symbol->scope->scope_name, variable_name); 
+    float *program = this->callStack->records[0]->floatMembers;
+    uint32_t chunks = (count + parallelChunk - 1) / parallelChunk;
+    for (uint8_t i=0; i<pool->size; i++)
+    {
+      memcpy(pool->workers[i]->callStack->records[0]->floatMembers, program, sizeof(float) * this->callStack->records[0]->size);
+      memcpy(pool->workers[i]->uniforms, uniforms, sizeof(float) * uniformsLength);
+      pool->workers[i]->frameInputsRecording = frameInputsRecording;
+      pool->workers[i]->frameInputsLength = 0;
+      pool->workers[i]->frameInputsOverflow = false;
+      pool->workers[i]->colors.reclaim();
+      pool->next[i] = chunks * i / pool->size;
+      pool->end[i] = chunks * (i + 1) / pool->size;
+    }
+    pool->function_symbol = function_symbol;
+    pool->nrOfFormals = nrOfFormals;
+    pool->count = count;
+    pool->setFormals = setFormals;
+    pool->failed = false;
+    pool->last = 0;
 
-                  }
+    {
+      std::lock_guard<std::mutex> lock(pool->mutex);
+      pool->running = pool->size - 1;
+      pool->generation++;
+    }
+    pool->started.notify_all();
 
-                  if (var_symbol != nullptr)
-                  {
-                    variable_value["level"] = var_symbol->scope_level;
-                    variable_value["index"] = var_symbol->scope_index;;
-                  }
-                }
+    parallelWork(pool, 0);
 
-                if (node == F_Assign) 
-                {
-                  ANDBG_ARTI("%s %s %s = (%u)\n", spaces+50-depth, key, variable_name, depth);
+    {
+      std::unique_lock<std::mutex> lock(pool->mutex);
+      pool->finished.wait(lock, [pool] {return pool->running == 0;});
+    }
 
-                  if (value.containsKey("assignoperator")) 
-                  {
-                    JsonObject asop = value["assignoperator"];
-                    JsonObject::iterator asopBegin = asop.begin();
-                    ANDBG_ARTI("%s %s\n", spaces+50-depth, asopBegin->value().as<std::string>().c_str());
-                    if (strcmp(asopBegin->value(), "+=") == 0) 
-                      value["assignoperator"] = F_plus;
-                    else if (strcmp(asopBegin->value(), "-=") == 0) 
-                      value["assignoperator"] = F_minus;
-                    else if (strcmp(asopBegin->value(), "*=") == 0) 
-                      value["assignoperator"] = F_multiplication;
-                    else if (strcmp(asopBegin->value(), "/=") == 0) 
-                      value["assignoperator"] = F_division;
-                    else if (strcmp(asopBegin->value(), "++") == 0) 
-                      value["assignoperator"] = F_plusplus;
-                    else if (strcmp(asopBegin->value(), "--") == 0) 
-                      value["assignoperator"] = F_minmin;
-                  }
+    memcpy(program, pool->workers[pool->last]->callStack->records[0]->floatMembers, sizeof(float) * this->callStack->records[0]->size);
+    for (uint8_t i=0; i<pool->size; i++)
+      if (pool->workers[i]->frameInputsLength > 0 || pool->workers[i]->frameInputsOverflow)
+        frameInputsOverflow = true; //the inputs read on the threads are not compared
 
-                  if (value.containsKey("expr")) 
-                    analyze(value, "expr", current_scope, depth + 1);
-                  else if (value["assignoperator"].as<uint8_t>() != F_plusplus && value["assignoperator"].as<uint8_t>() != F_minmin)
-                  {
-                    ERROR_ARTI("%s %s %s: Assign without expression\n", spaces+50-depth, key, variable_name); 
-                    errorOccurred = true;
-                  }
-                }
+    return !pool->failed && !errorOccurred;
+  }
 
-                visitedAlready = true;
-                break;
-              }
-              case F_Call: 
-              {
-                const char * function_name = value["ID"];
+  #endif
 
-                //check if external function
-                bool externalFound = false;
-                uint8_t index = 0;
-                for (JsonPair externalsPair: definitionJson["EXTERNALS"].as<JsonObject>()) 
-                {
-                  if (strcmp(function_name, externalsPair.key().c_str()) == 0) 
-                  {
-                    ANDBG_ARTI("%s Ext Function found %s (%u)\n", spaces+50-depth, function_name, depth);
-                    value["external"] = index; //add external index to parseTree 
-                    externalFound = true;
-                  }
-                  index++;
-                }
+  #if ARTI_JIT
 
-                if (!externalFound) 
-                {
-                  Symbol* function_symbol = current_scope->lookup(function_name); //lookup here and parent scopes
-                  if (function_symbol != nullptr) 
-                    analyze(function_symbol->block, nullptr, current_scope, depth + 1);
-                  else 
-                    ERROR_ARTI("%s Function %s not found in scope of %s\n", spaces+50-depth, function_name, current_scope->scope_name); 
-                } //external functions
+  //helpers called by the machine code, same as the instructions in executeRegisters
+  static float jitLoadExt(void *arti, uint8_t external, float index1, float index2)
+  {
+    float result = ((ARTI *)arti)->arti_get_external_variable(external, index1, index2);
+    if (result == floatNull)
+      ERROR_ARTI("Error: ext %u no value\n", external);
+    return result;
+  }
 
-                if (value.containsKey("actuals"))
-                  analyze(value["actuals"], nullptr, current_scope, depth + 1);
+  static void jitStoreExt(void *arti, uint8_t external, float value, float index1, float index2)
+  {
+    ((ARTI *)arti)->arti_set_external_variable(value, external, index1, index2);
+  }
 
-                visitedAlready = true;
-                break;
-              } // case
-              default: //visitedalready false => recursive call
-                break;
-            } //switch
-          } // is node_name
+  static float jitCallExt(void *arti, uint8_t external, float par1, float par2, float par3, float par4, float par5)
+  {
+    return ((ARTI *)arti)->arti_external_function(external, par1, par2, par3, par4, par5);
+  }
 
-          if (!visitedAlready && value.size() > 0) // if size == 0 then injected key/value like operator
-            analyze(value, nullptr, current_scope, depth + 1);
+  static bool jitCall(void *arti, Instruction *instruction, float **bases)
+  {
+    return ((ARTI *)arti)->registerCall(instruction, bases);
+  }
 
-        } // key values
-      } ///for elements in object
+  //loop: counter, mode and value (temps of the for loop), returns false if the loop ends
+  static bool jitForLoop(float *loop)
+  {
+    if (loop[0] >= maxForIterations)
+    {
+      ERROR_ARTI("too many iterations in for loop %u\n", maxForIterations);
+      return false;
     }
-    else if (parseTree.is<JsonArray>()) 
+    loop[0]++;
+    return true;
+  }
+
+  static bool jitForCond(float *loop, float conditionResult, float *variable)
+  {
+    if (conditionResult == 1)
     {
-      for (JsonVariant newParseTree: parseTree.as<JsonArray>()) 
-        analyze(newParseTree, nullptr, current_scope, depth + 1);
+      loop[1] = 1; //C mode: run block and increment
+      return true;
     }
-    else //not array
+    else if (conditionResult == 0)
+      return false;
+    else if (*variable <= conditionResult) // conditionResult is a value (e.g. in pascal)
     {
-      // string element = parseTree;
-      //for some weird reason this causes a crash on esp32
-      // ERROR_ARTI("%s Error: parseTree should be array or object %s (%u)\n", spaces+50-depth, parseTree.as<std::string>().c_str(), depth);
+      loop[1] = 0; //pascal mode: run block and increment loop variable
+      loop[2] = *variable;
+      return true;
     }
+    return false;
+  }
 
-    return !errorOccurred;
-  } //analyze
+  //returns true if pascal mode: loop variable incremented, jump to the loop
+  static bool jitForNext(float *loop, float *variable)
+  {
+    if (loop[1] == 0)
+    {
+      *variable = loop[2] + 1;
+      return true;
+    }
+    return false;
+  }
 
-  //https://dev.to/lefebvre/compilers-106---optimizer--ig8
-  bool optimize(JsonVariant parseTree, uint8_t depth = 0) 
+  //translates the decoded registerCode to machine code, false if an instruction is not supported (run by executeRegisters then)
+  bool jit()
   {
-    // DEBUG_ARTI("%s optimize %s (%u)\n", spaces+50-depth, parseTree.as<std::string>().c_str(), depth);
+    Instruction *instructions = registerCode->instructions;
+    float *constants = registerCode->constants;
 
-    if (parseTree.is<JsonObject>()) 
+    jitCode = new JitCode(registerCode->instructionsLength);
+    jitCode->exits();
+
+    for (uint16_t i=0; !errorOccurred && i<registerCode->instructionsLength; i++)
     {
-      //make the parsetree as small as possible to let the interpreter run as fast as possible:
+      Instruction *instruction = &instructions[i];
+      Operand *operands = instruction->operands;
+      uint8_t opCode = instruction->opCode;
 
-      for (JsonPair parseTreePair : parseTree.as<JsonObject>()) 
+      jitCode->labels[i] = jitCode->length;
+
+      switch (opCode)
       {
-        const char * key = parseTreePair.key().c_str();
-        JsonVariant value = parseTreePair.value();
+        case R_Halt:
+        case R_Return:
+          jitCode->jump(jitReturn);
+          break;
+        case R_Move:
+          jitCode->loadOperand(0, operands[1], constants);
+          jitCode->storeOperand(operands[0]);
+          break;
+        case R_LoadExt:
+          jitCode->loadOperand(0, operands[1], constants);
+          jitCode->loadOperand(1, operands[2], constants);
+          jitCode->emitBytes(3, 0x4C, 0x89, 0xE7); //mov rdi, r12
+          jitCode->emit(0xBE); //mov esi, imm32
+          jitCode->emitUint32(instruction->index);
+          jitCode->call((const void *)&jitLoadExt);
+          jitCode->storeOperand(operands[0]);
+          jitCode->jumpIfError();
+          break;
+        case R_StoreExt:
+          jitCode->loadOperand(0, operands[0], constants);
+          jitCode->loadOperand(1, operands[1], constants);
+          jitCode->loadOperand(2, operands[2], constants);
+          jitCode->emitBytes(3, 0x4C, 0x89, 0xE7); //mov rdi, r12
+          jitCode->emit(0xBE); //mov esi, imm32
+          jitCode->emitUint32(instruction->index);
+          jitCode->call((const void *)&jitStoreExt);
+          jitCode->jumpIfError();
+          break;
+        case R_CallExt:
+          for (uint8_t j=1; j<nrOfOperands; j++)
+            jitCode->loadOperand(j - 1, operands[j], constants);
+          jitCode->emitBytes(3, 0x4C, 0x89, 0xE7); //mov rdi, r12
+          jitCode->emit(0xBE); //mov esi, imm32
+          jitCode->emitUint32(instruction->index);
+          jitCode->call((const void *)&jitCallExt);
+          jitCode->storeOperand(operands[0]);
+          jitCode->jumpIfError();
+          break;
+        case R_Call:
+          jitCode->emitBytes(3, 0x4C, 0x89, 0xE7); //mov rdi, r12
+          jitCode->emitBytes(2, 0x48, 0xBE); //mov rsi, imm64
+          jitCode->emitUint64((uintptr_t)instruction);
+          jitCode->emitBytes(3, 0x48, 0x89, 0xDA); //mov rdx, rbx
+          jitCode->call((const void *)&jitCall);
+          jitCode->emitBytes(2, 0x84, 0xC0); //test al, al
+          jitCode->jumpIf(0x84, jitFalse);
+          break;
+        case R_Jump:
+          jitCode->jump(instruction->address);
+          break;
+        case R_JumpIfNot:
+          jitCode->loadOperand(0, operands[0], constants);
+          jitCode->loadFloat(1, 1);
+          jitCode->emitBytes(3, 0x0F, 0x2E, 0xC1); //ucomiss xmm0, xmm1
+          jitCode->jumpIf(0x85, instruction->address); //not equal
+          jitCode->jumpIf(0x8A, instruction->address); //unordered (nan)
+          break;
+        case R_ForLoop:
+          jitCode->loadAddress(7, S_Temps, instruction->index); //rdi
+          jitCode->call((const void *)&jitForLoop);
+          jitCode->emitBytes(2, 0x84, 0xC0); //test al, al
+          jitCode->jumpIf(0x84, instruction->address);
+          break;
+        case R_ForCond:
+          jitCode->loadOperand(0, operands[0], constants);
+          jitCode->loadAddress(6, operands[1].base, operands[1].index); //rsi
+          jitCode->loadAddress(7, S_Temps, instruction->index); //rdi
+          jitCode->call((const void *)&jitForCond);
+          jitCode->emitBytes(2, 0x84, 0xC0); //test al, al
+          jitCode->jumpIf(0x84, instruction->address);
+          break;
+        case R_ForNext:
+          jitCode->loadAddress(6, operands[0].base, operands[0].index); //rsi
+          jitCode->loadAddress(7, S_Temps, instruction->index); //rdi
+          jitCode->call((const void *)&jitForNext);
+          jitCode->emitBytes(2, 0x84, 0xC0); //test al, al
+          jitCode->jumpIf(0x85, instruction->address);
+          break;
+        case R_Neg:
+          jitCode->loadOperand(0, operands[1], constants);
+          jitCode->loadBits(1, 0x80000000);
+          jitCode->emitBytes(3, 0x0F, 0x57, 0xC1); //xorps xmm0, xmm1
+          jitCode->storeOperand(operands[0]);
+          break;
+        case R_Add:
+        case R_Sub:
+        case R_Mul:
+          jitCode->loadOperand(0, operands[1], constants);
+          jitCode->loadOperand(1, operands[2], constants);
+          jitCode->emitBytes(4, 0xF3, 0x0F, opCode == R_Add?0x58:opCode == R_Sub?0x5C:0x59, 0xC1); //addss, subss, mulss xmm0, xmm1
+          jitCode->storeOperand(operands[0]);
+          break;
+        case R_Div:
+        case R_Mod:
+          jitCode->loadOperand(0, operands[1], constants);
+          jitCode->loadOperand(1, operands[2], constants);
+          jitCode->call(opCode == R_Div?(const void *)&artiDivision:(const void *)&artiModulo);
+          jitCode->storeOperand(operands[0]);
+          break;
+        case R_Shl:
+        case R_Shr:
+          jitCode->loadOperand(0, operands[1], constants);
+          jitCode->loadOperand(1, operands[2], constants);
+          jitCode->emitBytes(4, 0xF3, 0x0F, 0x2C, 0xC0); //cvttss2si eax, xmm0
+          jitCode->emitBytes(4, 0xF3, 0x0F, 0x2C, 0xC9); //cvttss2si ecx, xmm1
+          jitCode->emitBytes(2, 0xD3, opCode == R_Shl?0xE0:0xF8); //shl, sar eax, cl
+          jitCode->emitBytes(4, 0xF3, 0x0F, 0x2A, 0xC0); //cvtsi2ss xmm0, eax
+          jitCode->storeOperand(operands[0]);
+          break;
+        case R_Eq:
+        case R_Ne:
+        case R_Lt:
+        case R_Le:
+        case R_Gt:
+        case R_Ge:
+        {
+          //cmpss predicates 0 eq, 1 lt, 2 le, 4 neq (false if nan, except neq), gt and ge swap the operands
+          bool swap = opCode == R_Gt || opCode == R_Ge;
+          uint8_t predicate = opCode == R_Eq?0:opCode == R_Ne?4:(opCode == R_Lt || opCode == R_Gt)?1:2;
+          jitCode->loadOperand(swap?1:0, operands[1], constants);
+          jitCode->loadOperand(swap?0:1, operands[2], constants);
+          jitCode->emitBytes(5, 0xF3, 0x0F, 0xC2, 0xC1, predicate); //cmpss xmm0, xmm1, predicate: all bits set if true
+          jitCode->loadFloat(1, 1);
+          jitCode->emitBytes(3, 0x0F, 0x54, 0xC1); //andps xmm0, xmm1: 1 or 0
+          jitCode->storeOperand(operands[0]);
+          break;
+        }
+        case R_And:
+        case R_Or:
+          jitCode->loadOperand(0, operands[1], constants);
+          jitCode->loadOperand(1, operands[2], constants);
+          jitCode->emitBytes(3, 0x0F, 0x57, 0xD2); //xorps xmm2, xmm2
+          jitCode->emitBytes(5, 0xF3, 0x0F, 0xC2, 0xC2, 4); //cmpneqss xmm0, xmm2
+          jitCode->emitBytes(5, 0xF3, 0x0F, 0xC2, 0xCA, 4); //cmpneqss xmm1, xmm2
+          jitCode->emitBytes(3, 0x0F, opCode == R_And?0x54:0x56, 0xC1); //andps, orps xmm0, xmm1
+          jitCode->loadFloat(1, 1);
+          jitCode->emitBytes(3, 0x0F, 0x54, 0xC1); //andps xmm0, xmm1: 1 or 0
+          jitCode->storeOperand(operands[0]);
+          break;
+        default:
+          WARNING_ARTI("JIT: register opcode %s not supported\n", registerOpCodeToString(opCode));
+          return false;
+      }
+    }
 
-        bool visitedAlready = false;
+    //the program and the functions are entries
+    jitCode->entry(0);
+    for (uint8_t i=0; i<registerCode->functionsIndex; i++)
+      if (jitCode->entries[registerCode->functions[i]->code_entry] == 0)
+        jitCode->entry(registerCode->functions[i]->code_entry);
 
-        // object:
-        // if key is node and value is object then optimize object after that if object empty then remove key
-        // else key is !ID and value is string then remove key
-        // else key is * and value is array then optimize array after that if array empty then remove key *
+    return jitCode->finish();
+  } //jit
 
-        // array
-        // if element is multiple then remove
+  #endif
 
-        if (strcmp(key, "*") == 0 ) // multiple
-        {
-          optimize(value, depth + 1);
+  Closure* newClosure(ClosureFunction function)
+  {
+    if (closureChunks == nullptr || closureChunkIndex >= closuresPerChunk)
+    {
+      ClosureChunk *chunk = (ClosureChunk *)malloc(sizeof(ClosureChunk));
+      if (chunk == nullptr)
+      {
+        ERROR_ARTI("Closures: no memory for %u closures\n", closuresPerChunk);
+        errorOccurred = true;
+        return nullptr;
+      }
+      chunk->next = closureChunks;
+      closureChunks = chunk;
+      closureChunkIndex = 0;
+      closuresLength += closuresPerChunk;
+    }
 
-          if (value.size() == 0) 
-          {
-            parseTree.remove(key);
-            // DEBUG_ARTI("%s optimize: remove empty %s %s (%u)\n", spaces+50-depth, key, value.as<std::string>().c_str(), depth);
-          }
+    Closure *closure = &closureChunks->closures[closureChunkIndex++];
+    memset(closure, 0, sizeof(Closure));
+    closure->function = function;
+    return closure;
+  }
 
-          visitedAlready = true;
-        }
-        else if (this->definitionJson["TOKENS"].containsKey(key)) // if key is token (moved to parse)
-        {
-          visitedAlready = true;
-        }
-        else if (value.is<JsonObject>()) //if key is node_name
-        {
-          optimize(value, depth + 1);
+  void freeClosures()
+  {
+    while (closureChunks != nullptr)
+    {
+      ClosureChunk *chunk = closureChunks;
+      closureChunks = chunk->next;
+      free(chunk);
+    }
+    closuresLength = 0;
+  }
 
-          if (value.size() == 0) 
-          {
-            // DEBUG_ARTI("%s optimize: remove key %s with empty object (%u)\n", spaces+50-depth, key, depth);
-            parseTree.remove(key);
-          }
-          else if (value.size() == 1) //try to shrink, moved to below
-          {
-            //- check if a node is not used in analyzer / interpreter and has only one element: go to the parent and replace itself with its child (shrink)
+  void pushClosure(Closure *closure)
+  {
+    if (closureValuesIndex < arrayLength)
+      closureValues[closureValuesIndex++] = closure;
+    else
+    {
+      ERROR_ARTI("Closures: values full (%d)\n", arrayLength);
+      errorOccurred = true;
+    }
+  }
 
-            // DEBUG_ARTI("%s node try to shrink %s : %s (%u)\n", spaces+50-depth, key, value.as<std::string>().c_str(), value.size());
+  //the last count values as list (linked by next)
+  Closure* popClosures(uint8_t count)
+  {
+    if (count > closureValuesIndex)
+    {
+      ERROR_ARTI("Closures: values empty\n");
+      errorOccurred = true;
+      return nullptr;
+    }
+    closureValuesIndex -= count;
+    for (uint8_t i=0; i<count; i++)
+      closureValues[closureValuesIndex + i]->next = (i + 1 < count)?closureValues[closureValuesIndex + i + 1]:nullptr;
+    return count > 0?closureValues[closureValuesIndex]:nullptr;
+  }
 
-            JsonObject::iterator objectIterator = value.as<JsonObject>().begin();
+  void addStatement(Closure *closure)
+  {
+    if (closure == nullptr) return;
+    *statementsTail = closure;
+    statementsTail = &closure->next;
+  }
 
-            if (definitionJson.containsKey(objectIterator->key().c_str()))  // if value key is a node
-            {
-              // if (objectIterator->value().is<JsonObject>() && objectIterator->value().size() == 1) //
-              // {
-              //   // JsonObject::iterator objectIterator2 = objectIterator->value().as<JsonObject>().begin();
+  //a value has been built
+  void builtValue()
+  {
+    if (contextsIndex > 0)
+      contexts[contextsIndex-1].values++;
+  }
 
-              //   // if (objectIterator2->value().is<JsonObject>() ) //&& objectIterator.size() == 1
-              //   {
-              //     DEBUG_ARTI("%s node to shrink %s : %s from %s\n", spaces+50-depth, key, value.as<std::string>().c_str(), parseTree.as<std::string>().c_str());
-              //     DEBUG_ARTI("%s node to shrink %s : %s\n", spaces+50-depth, objectIterator->key().c_str(), objectIterator->value().as<std::string>().c_str());
-              //     // DEBUG_ARTI("%s node to shrink %s : %s\n", spaces+50-depth, objectIterator2->key().c_str(), objectIterator2->value().as<std::string>().c_str());
-              //     DEBUG_ARTI("%s node to shrink replace %s\n", spaces+50-depth, parseTree[key].as<std::string>().c_str());
-              //     DEBUG_ARTI("%s node to shrink      by %s\n", spaces+50-depth, objectIterator->value().as<std::string>().c_str());
-              //     // parseTree[key][objectIterator->key().c_str()] = objectIterator2->value();
-              //     parseTree[key] = objectIterator->value();
-              //   }
-              //   // else
-              //   // {
-              //   //   DEBUG_ARTI("%s node to shrink2 %s : %s\n", spaces+50-depth, objectIterator2->key().c_str(), objectIterator2->value().as<std::string>().c_str());
-              //   // }
-              // }
-              // else
-              //   DEBUG_ARTI("%s value should be an object %s in %s : %s from %s\n", spaces+50-depth, objectIterator->key().c_str(), key, objectIterator->value().as<std::string>().c_str(), value.as<std::string>().c_str());
-              if (stringToNode(objectIterator->key().c_str()) == F_NoNode) // if key not a node
-              // if (objectIterator->value().size() == 1)
-              {
-                DEBUG_ARTI("%s node to shrink %s in %s : %s from %s\n", spaces+50-depth, objectIterator->key().c_str(), key, value.as<std::string>().c_str(), parseTree.as<std::string>().c_str());
-                // DEBUG_ARTI("%s node to shrink %s in %s = %s from %s\n", spaces+50-depth, objectIterator->key().c_str(), key, objectIterator->value().as<std::string>().c_str(), parseTree[key].as<std::string>().c_str());
-                 parseTree[key] = objectIterator->value();
+  //builds exactly one value of list
+  Closure* buildValue(uint16_t list, const char * construct, uint8_t depth)
+  {
+    openContext(C_Values);
+    buildClosures(list, depth);
+    uint8_t values = closeContext();
+    if (values != 1)
+    {
+      compileNotSupported(construct, values);
+      popClosures(values);
+      return nullptr;
+    }
+    return popClosures(1);
+  }
 
-                // parseTree[key]["old"] = objectIterator->key();
+  //builds the values of list as list
+  Closure* buildValues(uint16_t list, uint8_t depth, uint8_t *count)
+  {
+    openContext(C_Values);
+    buildClosures(list, depth);
+    *count = closeContext();
+    return popClosures(*count);
+  }
 
-                // parseTreePair.key() = objectIterator->key();
-                // parseTreePair._key = objectIterator->key();
-                // parseTree[objectIterator->key()] = objectIterator->value();
-                // parseTree.remove(key);
-                // parseTree[key][objectIterator2->key().c_str()] = objectIterator2->value();
-              }
-            }
-          } //shrink
+  Closure* buildStatements(uint16_t list, uint8_t depth)
+  {
+    Closure *block = newClosure(closureBlock);
+    if (block == nullptr) return nullptr;
 
-          visitedAlready = true;
-        }
-        else
-          ERROR_ARTI("%s Programming Error: key no node and no token %s %s (%u)\n", spaces+50-depth, key, value.as<std::string>().c_str(), depth);
+    Closure **enclosingTail = statementsTail;
+    statementsTail = &block->children[0];
+    openContext(C_Statements);
+    buildClosures(list, depth);
+    closeContext();
+    statementsTail = enclosingTail;
 
-        if (!visitedAlready && value.size() > 0) // if size == 0 then injected key/value like operator
-          optimize(value, depth + 1);
+    return block;
+  }
 
-      } ///for elements in object
+  //builds the closures of a node of the syntaxTree, same traversal as compile
+  bool buildClosures(uint16_t node, uint8_t depth = 0)
+  {
+    if (depth >= 50)
+    {
+      ERROR_ARTI("Error: Build closures recursion level too deep at node %u (%u)\n", node, depth);
+      errorOccurred = true;
+    }
+    if (errorOccurred || compileError) return false;
+    if (node == noNode) return true;
 
-      //shrink
-      for (JsonPair parseTreePair : parseTree.as<JsonObject>()) 
+    Node *n = &syntaxTree->nodes[node];
+
+    switch (n->kind)
+    {
+      case F_List:
       {
-        const char * key = parseTreePair.key().c_str();
-        JsonVariant value = parseTreePair.value();
+        for (uint16_t child = n->child; child != noNode; child = syntaxTree->nodes[child].next)
+          buildClosures(child, depth + 1);
+        break;
+      }
+      case F_Constant:
+      {
+        Closure *closure = newClosure(closureConstant);
+        if (closure != nullptr)
+        {
+          closure->value = n->value;
+          pushClosure(closure);
+          builtValue();
+        }
+        break;
+      }
+      case F_Operator: //postfix: the operands are built already (see buildPostfix)
+      {
+        ClosureFunction function = n->index == 1?closureNeg:closureOperator(n->token);
+        if (function == nullptr)
+        {
+          compileNotSupported("operator", n->token);
+          break;
+        }
+        for (uint16_t child = n->child; child != noNode; child = syntaxTree->nodes[child].next) //right operand of && and ||
+          buildClosures(child, depth + 1);
 
-        if (false && value.is<JsonObject>() && parseTree.size() == 1 && value.size() == 1 && definitionJson.containsKey(key)) //if key is node_name
+        Closure *closure = newClosure(function);
+        if (closure != nullptr)
         {
-          JsonObject::iterator objectIterator = value.as<JsonObject>().begin();
+          if (n->index == 1)
+            closure->children[0] = popClosures(1);
+          else
+          {
+            closure->children[1] = popClosures(1);
+            closure->children[0] = popClosures(1);
+          }
+          pushClosure(closure);
+        }
+        break;
+      }
+      case F_Program:
+        closureProgram = buildStatements(n->child, depth + 1);
+        break;
+      case F_Function:
+        n->symbol->closure = buildStatements(n->child, depth + 1);
+        break;
+      case F_Call:
+      {
+        bool inExpression = contextsIndex > 0 && contexts[contextsIndex-1].kind != C_Statements;
+        Closure *closure = nullptr;
+        uint8_t nrOfActuals = 0;
 
-          // DEBUG_ARTI("%s try replace %s by %s %s\n", spaces+50-depth, key, objectIterator->key().c_str(), parseTree.as<std::string>().c_str());
+        if (n->external != noExternal)
+        {
+          closure = newClosure(closureCallExternal);
+          if (closure != nullptr)
+          {
+            closure->external = n->external;
+            closure->children[0] = buildValues(n->child, depth + 1, &nrOfActuals);
+            closure->count = nrOfActuals;
+            if (nrOfActuals > 5)
+              compileNotSupported("number of actuals", nrOfActuals);
+          }
+        }
+        else if (inExpression)
+          compileNotSupported("function call in expression");
+        else
+        {
+          closure = newClosure(closureCall);
+          if (closure != nullptr)
+          {
+            closure->symbol = n->symbol;
+            closure->children[0] = buildValues(n->child, depth + 1, &nrOfActuals);
+            closure->count = nrOfActuals;
+          }
+        }
 
-          if (strcmp(objectIterator->key().c_str(), "ID") != 0) //&& definitionJson.containsKey(objectIterator->key())???
+        if (closure != nullptr)
+        {
+          if (inExpression)
           {
-            // DEBUG_ARTI("%s found %s:%s\n", spaces+50-depth, node_name, parseTree.as<std::string>().c_str());
-            // DEBUG_ARTI("%s found replace %s by %s %s\n", spaces+50-depth, key, objectIterator->key().c_str(), parseTree.as<std::string>().c_str());
-            // DEBUG_ARTI("%s found %s\n", spaces+50-depth, value.as<std::string>().c_str());
+            pushClosure(closure);
+            builtValue();
+          }
+          else
+            addStatement(closure);
+        }
+        break;
+      }
+      case F_VarRef:
+      case F_Assign:
+      {
+        uint8_t nodeKind = n->kind;
+        uint8_t level = n->level;
+        uint8_t index = n->index;
+        uint8_t external = n->external;
+        uint8_t assignOperator = n->token;
+        uint16_t indicesList = syntaxTree->child(node, 0);
+        Closure *expression = nullptr;
+
+        if (nodeKind == F_Assign)
+        {
+          uint16_t exprList = syntaxTree->child(node, 1);
+          if (syntaxTree->nodes[exprList].child != noNode)
+            expression = buildValue(exprList, "expr", depth + 1);
+        }
 
-            // DEBUG_ARTI("%s found %s\n", spaces+50-depth, parseTree.as<std::string>().c_str());
-            DEBUG_ARTI("%s replace %s by %s %s\n", spaces+50-depth, key, objectIterator->key().c_str(), parseTree.as<std::string>().c_str());
+        uint8_t nrOfIndices = 0;
+        Closure *indices = buildValues(indicesList, depth + 1, &nrOfIndices);
 
-            parseTree.remove(key);
-            // parseTree[key] = value;
-            parseTree[objectIterator->key()] = objectIterator->value();
+        Closure *closure = nullptr;
 
-            // DEBUG_ARTI("%s found %s:%s\n", spaces+50-depth, node_name, parseTree.as<std::string>().c_str());
+        if (external != noExternal)
+        {
+          if (nrOfIndices > 2)
+            compileNotSupported("number of indices", nrOfIndices);
 
+          if (nodeKind == F_VarRef && nrOfIndices == 0 && uniformIndex(external) < nrOfUniforms)
+          {
+            closure = newClosure(closureUniform);
+            if (closure != nullptr)
+              closure->index = uniformIndex(external);
           }
-          // else
-          // {
-          //   DEBUG_ARTI("%s not shrinkable %s %s\n", spaces+50-depth, key, value.as<std::string>().c_str());
-          //   if (depth > 12) {
-          //   // parseTree.remove(key);
-          //       char temp[charLength];
-          //       strcpy(temp, key);
-          //       strcat(temp, "-");
-          //       // strcat(temp, objectIterator->key().c_str());
-          //   // parseTree[temp] = value;
-          //   }
-          // }
-
-          if (false && definitionJson.containsKey(objectIterator->key().c_str()))  // if value key is a node
+          else
           {
-            if (stringToNode(objectIterator->key().c_str()) == F_NoNode) // if key not a node
-            // if (objectIterator->value().size() == 1)
+            closure = newClosure(nodeKind == F_VarRef?closureGetExternal:closureSetExternal);
+            if (closure != nullptr)
             {
-              DEBUG_ARTI("%s node to shrink %s in %s : %s from %s\n", spaces+50-depth, objectIterator->key().c_str(), key, value.as<std::string>().c_str(), parseTree.as<std::string>().c_str());
-              // DEBUG_ARTI("%s node to shrink %s in %s = %s from %s\n", spaces+50-depth, objectIterator->key().c_str(), key, objectIterator->value().as<std::string>().c_str(), parseTree[key].as<std::string>().c_str());
-                parseTree[key] = objectIterator->value();
+              closure->external = external;
+              closure->children[0] = expression; //set: no expression is no value (floatNull) like interpret
+              closure->children[1] = indices;
+              closure->count = nrOfIndices;
+            }
+          }
+        }
+        else
+        {
+          if (nrOfIndices > 0) //indices of internal variables not supported yet
+            compileNotSupported("indices of variable", nrOfIndices);
 
-              // parseTree[key]["old"] = objectIterator->key();
+          if (level > closureMaxLevel)
+            closureMaxLevel = level;
 
-              // parseTreePair.key() = objectIterator->key();
-              // parseTreePair._key = objectIterator->key();
-              // parseTree[objectIterator->key()] = objectIterator->value();
-              // parseTree.remove(key);
-              // parseTree[key][objectIterator2->key().c_str()] = objectIterator2->value();
+          if (nodeKind == F_VarRef)
+            closure = newClosure(closureVariable);
+          else
+          {
+            ClosureFunction function = closureAssign;
+            switch (assignOperator)
+            {
+              case F_plus:
+                function = closureAssignPlus;
+                break;
+              case F_minus:
+                function = closureAssignMinus;
+                break;
+              case F_multiplication:
+                function = closureAssignMultiplication;
+                break;
+              case F_division:
+                function = closureAssignDivision;
+                break;
+              case F_plusplus:
+                function = closureIncrement;
+                break;
+              case F_minmin:
+                function = closureDecrement;
+                break;
+              default:
+                if (expression == nullptr)
+                  compileNotSupported("assign without expression");
             }
+            closure = newClosure(function);
+            if (closure != nullptr)
+              closure->children[0] = expression;
           }
-        } //value is jsonObject
 
-      } // for
-    }
-    else if (parseTree.is<JsonArray>())
-    {
-      JsonArray parseTreeArray = parseTree.as<JsonArray>();
-      
-      uint8_t arrayIndex = 0;
-      for (JsonArray::iterator it = parseTreeArray.begin(); it != parseTreeArray.end(); ++it) 
-      {
-        JsonVariant element = *it;
+          if (closure != nullptr)
+          {
+            closure->level = level;
+            closure->index = index;
+            if (nodeKind == F_Assign)
+              lastAssigned = closure;
+          }
+        }
 
-        if (element == "multiple") 
+        if (closure != nullptr)
         {
-          // DEBUG_ARTI("%s optimize: remove array element 'multiple' of array (%u)\n", spaces+50-depth, arrayIndex);
-          parseTreeArray.remove(it);
+          if (nodeKind == F_VarRef)
+          {
+            pushClosure(closure);
+            builtValue();
+          }
+          else
+            addStatement(closure);
         }
-        else if (it->size() == 0) //remove {} elements (added by * arrays, don't know where added)
+        break;
+      }
+      case F_Expr:
+      case F_Term:
+      {
+        openContext(C_Expression);
+        for (uint16_t child = n->child; child != noNode; child = syntaxTree->nodes[child].next)
+          buildClosures(child, depth + 1);
+        closeContext();
+        builtValue();
+        break;
+      }
+      case F_For:
+      {
+        //the assignments before the loop are statements of the enclosing block
+        lastAssigned = nullptr;
+        openContext(C_Statements);
+        buildClosures(syntaxTree->child(node, 0), depth + 1);
+        closeContext();
+
+        Closure *closure = newClosure(closureFor);
+        if (closure != nullptr)
         {
-          // DEBUG_ARTI("%s optimize: remove array element {} of %s array (%u)\n", spaces+50-depth, element.as<std::string>().c_str(), arrayIndex);
-          parseTreeArray.remove(it);
+          if (lastAssigned != nullptr) //pascal: the loop variable
+          {
+            closure->level = lastAssigned->level;
+            closure->index = lastAssigned->index;
+          }
+          closure->children[0] = buildValue(syntaxTree->child(node, 1), "expr", depth + 1);
+          closure->children[1] = buildStatements(syntaxTree->child(node, 2), depth + 1);
+          closure->children[2] = buildStatements(syntaxTree->child(node, 3), depth + 1);
+          addStatement(closure);
         }
-        else 
-          optimize(*it, depth + 1);
+        break;
+      }
+      case F_If:
+      {
+        Closure *closure = newClosure(closureIf);
+        if (closure != nullptr)
+        {
+          uint16_t exprList = syntaxTree->child(node, 0);
+          uint16_t elseList = syntaxTree->child(node, 2);
 
-        arrayIndex++;
+          if (syntaxTree->nodes[exprList].child != noNode)
+            closure->children[0] = buildValue(exprList, "expr", depth + 1);
+          else
+            compileNotSupported("if without expression");
+
+          closure->children[1] = buildStatements(syntaxTree->child(node, 1), depth + 1);
+          if (syntaxTree->nodes[elseList].child != noNode)
+            closure->children[2] = buildStatements(elseList, depth + 1);
+          addStatement(closure);
+        }
+        break;
       }
-    }
-    else //not array
-    {
-      // string element = parseTree;
-      //for some weird reason this causes a crash on esp32
-      ERROR_ARTI("%s Error: parseTree should be array or object %s (%u)\n", spaces+50-depth, parseTree.as<std::string>().c_str(), depth);
+      case F_Cex:
+      {
+        Closure *closure = newClosure(closureCex);
+        if (closure != nullptr)
+        {
+          closure->children[0] = buildValue(syntaxTree->child(node, 0), "expr", depth + 1);
+          closure->children[1] = buildValue(syntaxTree->child(node, 1), "trueExpr", depth + 1);
+          closure->children[2] = buildValue(syntaxTree->child(node, 2), "falseExpr", depth + 1);
+          pushClosure(closure);
+          builtValue();
+        }
+        break;
+      }
+      default:
+        ERROR_ARTI("%s Programming error: node %s not built\n", spaces+50-depth, nodeToString(n->kind));
     }
 
-    // DEBUG_ARTI("%s optimized %s (%u)\n", spaces+50-depth, parseTree.as<std::string>().c_str(), depth);
+    return !errorOccurred && !compileError;
+  } //buildClosures
 
-    return !errorOccurred;
-  } //optimize
+  static inline float evaluate(ARTI *arti, Closure *closure)
+  {
+    return closure->function(arti, closure);
+  }
 
-  // bool visit_ID(JsonVariant parseTree, const char * treeElement = nullptr, ScopedSymbolTable* current_scope = nullptr, uint8_t depth = 0) 
+  static float closureConstant(ARTI *, Closure *closure)
+  {
+    return closure->value;
+  }
 
-  bool interpret(JsonVariant parseTree, const char * treeElement = nullptr, ScopedSymbolTable* current_scope = nullptr, uint8_t depth = 0) 
+  static float closureVariable(ARTI *arti, Closure *closure)
   {
-    // RUNLOG_ARTI("%s Interpret %s %s (%u)\n", spaces+50-depth, stringOrEmpty(treeElement), parseTree.as<std::string>().c_str(), depth);
+    return arti->closureBases[closure->level][closure->index];
+  }
 
-    if (depth >= 50) 
-    {
-      ERROR_ARTI("Error: Interpret recursion level too deep at %s (%u)\n", parseTree.as<std::string>().c_str(), depth);
-      errorOccurred = true;
-    }
-    if (errorOccurred) return false;
+  static float closureUniform(ARTI *arti, Closure *closure)
+  {
+    return arti->uniforms[closure->index];
+  }
 
-    if (parseTree.is<JsonObject>()) 
-    {
-      for (JsonPair parseTreePair : parseTree.as<JsonObject>()) 
-      {
-        const char * key = parseTreePair.key().c_str();
-        JsonVariant value = parseTreePair.value();
-        if (treeElement == nullptr || strcmp(treeElement, key) == 0) 
-        {
-          // RUNLOG_ARTI("%s Interpret object element %s %s\n", spaces+50-depth, key, value.as<std::string>().c_str());
+  static float closureAssign(ARTI *arti, Closure *closure)
+  {
+    arti->closureBases[closure->level][closure->index] = evaluate(arti, closure->children[0]);
+    return 0;
+  }
 
-          bool visitedAlready = false;
+  static float closureAssignPlus(ARTI *arti, Closure *closure)
+  {
+    arti->closureBases[closure->level][closure->index] += evaluate(arti, closure->children[0]);
+    return 0;
+  }
 
-          if (strcmp(key, "*") == 0)
-          {
-            // do the recursive call below
-          }
-          else if (strcmp(key, "token") == 0 || strcmp(key, "variable") == 0) //variable decls done in analyze (see pas)
-            visitedAlready = true;
-          else if (parseTree.containsKey("token")) //key is token
-          {
-            // RUNLOG_ARTI("%s Token %s %s %s\n", spaces+50-depth, key, valueStr, parseTree.as<std::string>().c_str());
+  static float closureAssignMinus(ARTI *arti, Closure *closure)
+  {
+    arti->closureBases[closure->level][closure->index] -= evaluate(arti, closure->children[0]);
+    return 0;
+  }
 
-            const char * valueStr = value;
+  static float closureAssignMultiplication(ARTI *arti, Closure *closure)
+  {
+    arti->closureBases[closure->level][closure->index] *= evaluate(arti, closure->children[0]);
+    return 0;
+  }
 
-            switch (parseTree["token"].as<uint8_t>()) 
-            {
-              case F_integerConstant:
-              case F_realConstant:
-                valueStack->push(atof(valueStr)); //push value
-                #if ARTI_PLATFORM != ARTI_ARDUINO  //for some weird reason this causes a crash on esp32
-                  RUNLOG_ARTI("%s %s %s (Push %u)\n", spaces+50-depth, key, valueStr, valueStack->stack_index);
-                #endif
-                break;
-              default:
-                valueStack->push(parseTree["token"].as<uint8_t>()); // push Operator index
-                #if ARTI_PLATFORM != ARTI_ARDUINO  //for some weird reason this causes a crash on esp32
-                  RUNLOG_ARTI("%s %s %s (Push %u)\n", spaces+50-depth, key, valueStr, valueStack->stack_index);
-                #endif
-            }
-            visitedAlready = true;
-          }
-          else //if key is node_name
-          {
-            uint8_t node = stringToNode(key);
+  static float closureAssignDivision(ARTI *arti, Closure *closure)
+  {
+    float *variable = &arti->closureBases[closure->level][closure->index];
+    float divisor = evaluate(arti, closure->children[0]);
+    if (divisor == 0)
+    {
+      divisor = 1;
+      ERROR_ARTI("/= division by 0 not possible, divisor ignored for %f\n", *variable);
+    }
+    *variable /= divisor;
+    return 0;
+  }
 
-            // RUNLOG_ARTI("%s Node %s\n", spaces+50-depth, key);
+  static float closureIncrement(ARTI *arti, Closure *closure)
+  {
+    if (closure->children[0] != nullptr) //expression is evaluated but not used (like interpret)
+      evaluate(arti, closure->children[0]);
+    arti->closureBases[closure->level][closure->index] += 1;
+    return 0;
+  }
 
-            switch (node)
-            {
-              case F_Program: 
-              {
-                const char * program_name = value["ID"];
-                RUNLOG_ARTI("%s program %s\n", spaces+50-depth, program_name);
+  static float closureDecrement(ARTI *arti, Closure *closure)
+  {
+    if (closure->children[0] != nullptr)
+      evaluate(arti, closure->children[0]);
+    arti->closureBases[closure->level][closure->index] -= 1;
+    return 0;
+  }
 
-                ActivationRecord* ar = new ActivationRecord(program_name, "PROGRAM", 1);
+  static float closureGetExternal(ARTI *arti, Closure *closure)
+  {
+    Closure *index = closure->children[1];
+    float par1 = (index != nullptr)?evaluate(arti, index):floatNull;
+    float par2 = (index != nullptr && index->next != nullptr)?evaluate(arti, index->next):floatNull;
+    float result = arti->arti_get_external_variable(closure->external, par1, par2);
+    if (result == floatNull)
+      ERROR_ARTI("Error: ext %u no value\n", closure->external);
+    return result;
+  }
+
+  static float closureSetExternal(ARTI *arti, Closure *closure)
+  {
+    float value = (closure->children[0] != nullptr)?evaluate(arti, closure->children[0]):floatNull;
+    Closure *index = closure->children[1];
+    float par1 = (index != nullptr)?evaluate(arti, index):floatNull;
+    float par2 = (index != nullptr && index->next != nullptr)?evaluate(arti, index->next):floatNull;
+    arti->arti_set_external_variable(value, closure->external, par1, par2);
+    return 0;
+  }
 
-                this->callStack->push(ar);
+  static float closureCallExternal(ARTI *arti, Closure *closure)
+  {
+    float pars[5] = {floatNull, floatNull, floatNull, floatNull, floatNull};
+    uint8_t i = 0;
+    for (Closure *actual = closure->children[0]; actual != nullptr && i < 5; actual = actual->next)
+      pars[i++] = evaluate(arti, actual);
+    return arti->arti_external_function(closure->external, pars[0], pars[1], pars[2], pars[3], pars[4]);
+  }
 
-                interpret(value["block"], nullptr, global_scope, depth + 1);
+  static float closureCall(ARTI *arti, Closure *closure)
+  {
+    Symbol* function_symbol = closure->symbol;
+    ScopedSymbolTable* function_scope = function_symbol->function_scope;
 
-                // do not delete main stack and program ar as used in subsequent calls 
-                // this->callStack->pop();
-                // delete ar; ar = nullptr;
+    ActivationRecord* functionAr = arti->callStack->allocate(function_symbol->name, function_symbol->scope_level + 1, function_scope->recordSize());
+    if (functionAr == nullptr)
+      return 0;
 
-                visitedAlready = true;
-                break;
-              }
-              case F_Function: 
-              {
-                const char * function_name = value["ID"];
-                Symbol* function_symbol = current_scope->lookup(function_name);
-                RUNLOG_ARTI("%s Save block of %s\n", spaces+50-depth, function_name);
-                if (function_symbol != nullptr)
-                  function_symbol->block = value["block"];
-                else
-                  ERROR_ARTI("%s Function %s: not found\n", spaces+50-depth, function_name); 
+    uint8_t i = 0;
+    for (Closure *actual = closure->children[0]; actual != nullptr; actual = actual->next, i++)
+    {
+      float value = evaluate(arti, actual);
+      if (i < function_scope->nrOfFormals)
+        functionAr->set(function_scope->symbols[i]->scope_index, value);
+    }
 
-                visitedAlready = true;
-                break;
-              }
-              case F_Call: 
-              {
-                const char * function_name = value["ID"];
+    float *enclosingBases[nrOfRecords];
+    memcpy(enclosingBases, arti->closureBases, (arti->closureMaxLevel + 1) * sizeof(float *));
 
-                //check if external function
-                if (value.containsKey("external")) {
-                  uint8_t oldIndex = valueStack->stack_index;
-
-                  if (value.containsKey("actuals"))
-                    interpret(value["actuals"], nullptr, current_scope, depth + 1);
-
-                  float returnValue = floatNull;
-
-                  returnValue = arti_external_function(value["external"], valueStack->floatStack[oldIndex]
-                                                                        , (valueStack->stack_index - oldIndex>1)?valueStack->floatStack[oldIndex+1]:floatNull
-                                                                        , (valueStack->stack_index - oldIndex>2)?valueStack->floatStack[oldIndex+2]:floatNull
-                                                                        , (valueStack->stack_index - oldIndex>3)?valueStack->floatStack[oldIndex+3]:floatNull
-                                                                        , (valueStack->stack_index - oldIndex>4)?valueStack->floatStack[oldIndex+4]:floatNull);
-
-                  #if ARTI_PLATFORM != ARTI_ARDUINO // because arduino runs the code instead of showing the code
-                    uint8_t lastIndex = oldIndex;
-                    RUNLOG_ARTI("%s Call %s(", spaces+50-depth, function_name);
-                    char sep[3] = "";
-                    for (int i = oldIndex; i< valueStack->stack_index; i++) {
-                      RUNLOG_ARTI("%s%f", sep, valueStack->floatStack[i]);
-                      strcpy(sep, ", ");
-                    }
-                    if ( returnValue != floatNull)
-                      RUNLOG_ARTI(") = %f (Pop %u, Push %u)\n", returnValue, oldIndex, oldIndex + 1);
-                    else
-                      RUNLOG_ARTI(") (Pop %u)\n", oldIndex);
+    arti->callStack->push(functionAr);
+    if (!errorOccurred)
+    {
+      arti->runClosures(function_symbol->closure);
+      arti->callStack->pop();
+    }
 
-                  #endif
+    memcpy(arti->closureBases, enclosingBases, (arti->closureMaxLevel + 1) * sizeof(float *));
 
-                  valueStack->stack_index = oldIndex;
+    arti->callStack->release(functionAr);
+    return 0;
+  }
 
-                  if (returnValue != floatNull)
-                    valueStack->push(returnValue);
+  static float closureBlock(ARTI *arti, Closure *closure)
+  {
+    for (Closure *statement = closure->children[0]; statement != nullptr && !errorOccurred; statement = statement->next)
+      evaluate(arti, statement);
+    return 0;
+  }
 
-                }
-                else { //not an external function
-                  Symbol* function_symbol = current_scope->lookup(function_name);
+  static float closureFor(ARTI *arti, Closure *closure)
+  {
+    for (uint16_t counter = 0; !errorOccurred; counter++)
+    {
+      if (counter >= maxForIterations)
+      {
+        ERROR_ARTI("too many iterations in for loop %u\n", maxForIterations);
+        break;
+      }
 
-                  if (function_symbol != nullptr) //calling undefined function: pre-defined functions e.g. print
-                  {
-                    ActivationRecord* ar = new ActivationRecord(function_name, "Function", function_symbol->scope_level + 1);
+      float conditionResult = evaluate(arti, closure->children[0]);
+      if (conditionResult == 1) //C mode: run block and increment
+      {
+        evaluate(arti, closure->children[1]);
+        evaluate(arti, closure->children[2]);
+      }
+      else if (conditionResult == 0)
+        break;
+      else // conditionResult is a value (e.g. in pascal)
+      {
+        float *variable = &arti->closureBases[closure->level][closure->index];
+        float varValue = *variable;
+        if (varValue <= conditionResult) //pascal mode: run block and increment loop variable
+        {
+          evaluate(arti, closure->children[1]);
+          *variable = varValue + 1;
+        }
+        else
+          break;
+      }
+    }
+    return 0;
+  }
 
-                    RUNLOG_ARTI("%s %s %s\n", spaces+50-depth, key, function_name);
+  static float closureIf(ARTI *arti, Closure *closure)
+  {
+    if (evaluate(arti, closure->children[0]) == 1)
+      evaluate(arti, closure->children[1]);
+    else if (closure->children[2] != nullptr)
+      evaluate(arti, closure->children[2]);
+    return 0;
+  }
 
-                    uint8_t oldIndex = valueStack->stack_index;
-                    uint8_t lastIndex = valueStack->stack_index;
+  static float closureCex(ARTI *arti, Closure *closure)
+  {
+    if (evaluate(arti, closure->children[0]) == 1)
+      return evaluate(arti, closure->children[1]);
+    else
+      return evaluate(arti, closure->children[2]);
+  }
 
-                    if (value.containsKey("actuals"))
-                      interpret(value["actuals"], nullptr, current_scope, depth + 1);
+  static float closureNeg(ARTI *arti, Closure *closure)
+  {
+    return -evaluate(arti, closure->children[0]);
+  }
 
-                    for (uint8_t i=0; i<function_symbol->function_scope->nrOfFormals; i++)
-                    {
-                      //determine type, for now assume float
-                      float result = valueStack->floatStack[lastIndex++];
-                      ar->set(function_symbol->function_scope->symbols[i]->scope_index, result);
-                      RUNLOG_ARTI("%s Actual %s.%s = %f (pop %u)\n", spaces+50-depth, function_name, function_symbol->function_scope->symbols[i]->name, result, valueStack->stack_index);
-                    }
+  static float closureDivision(ARTI *arti, Closure *closure)
+  {
+    float left = evaluate(arti, closure->children[0]);
+    float right = evaluate(arti, closure->children[1]);
+    if (right == 0)
+    {
+      right = 1;
+      ERROR_ARTI("division by 0 not possible, divisor ignored for %f\n", left);
+    }
+    return left / right;
+  }
 
-                    valueStack->stack_index = oldIndex;
+  static float closureModulo(ARTI *arti, Closure *closure)
+  {
+    float left = evaluate(arti, closure->children[0]);
+    float right = evaluate(arti, closure->children[1]);
+    if (right == 0) {
+      ERROR_ARTI("mod 0 not possible, mod ignored %f\n", left);
+      return left;
+    }
+    return fmod(left, right);
+  }
 
-                    this->callStack->push(ar);
+  //binary operators: left is evaluated before right like interpret
+  #define closureBinary(name, expression) \
+  static float name(ARTI *arti, Closure *closure) \
+  { \
+    float left = evaluate(arti, closure->children[0]); \
+    float right = evaluate(arti, closure->children[1]); \
+    return expression; \
+  }
 
-                    interpret(function_symbol->block, nullptr, function_symbol->function_scope, depth + 1);
+  closureBinary(closurePlus, left + right)
+  closureBinary(closureMinus, left - right)
+  closureBinary(closureMultiplication, left * right)
+  closureBinary(closureShiftLeft, (int)left << (int)right)
+  closureBinary(closureShiftRight, (int)left >> (int)right)
+  closureBinary(closureEqual, left == right)
+  closureBinary(closureNotEqual, left != right)
+  closureBinary(closureLessThen, left < right)
+  closureBinary(closureLessThenOrEqual, left <= right)
+  closureBinary(closureGreaterThen, left > right)
+  closureBinary(closureGreaterThenOrEqual, left >= right)
+
+  #undef closureBinary
+
+  //right is only evaluated if it determines the result
+  static float closureAnd(ARTI *arti, Closure *closure)
+  {
+    return evaluate(arti, closure->children[0]) != 0 && evaluate(arti, closure->children[1]) != 0;
+  }
 
-                    this->callStack->pop();
+  static float closureOr(ARTI *arti, Closure *closure)
+  {
+    return evaluate(arti, closure->children[0]) != 0 || evaluate(arti, closure->children[1]) != 0;
+  }
 
-                    delete ar; ar =  nullptr;
+  static ClosureFunction closureOperator(uint8_t token)
+  {
+    switch (token)
+    {
+      case F_plus:
+        return closurePlus;
+      case F_minus:
+        return closureMinus;
+      case F_multiplication:
+        return closureMultiplication;
+      case F_division:
+        return closureDivision;
+      case F_modulo:
+        return closureModulo;
+      case F_bitShiftLeft:
+        return closureShiftLeft;
+      case F_bitShiftRight:
+        return closureShiftRight;
+      case F_equal:
+        return closureEqual;
+      case F_notEqual:
+        return closureNotEqual;
+      case F_lessThen:
+        return closureLessThen;
+      case F_lessThenOrEqual:
+        return closureLessThenOrEqual;
+      case F_greaterThen:
+        return closureGreaterThen;
+      case F_greaterThenOrEqual:
+        return closureGreaterThenOrEqual;
+      case F_and:
+        return closureAnd;
+      case F_or:
+        return closureOr;
+      default:
+        return nullptr;
+    }
+  }
 
-                    //tbd if syntax supports returnvalue
-                    // char callResult[charLength] = "CallResult tbd of ";
-                    // strcat(callResult, function_name);
-                    // valueStack->push(callResult);
+  //runs a block, the activation record must be pushed already
+  bool runClosures(Closure *block)
+  {
+    ActivationRecord* ar = this->callStack->peek();
+    for (uint8_t level=0; level <= closureMaxLevel; level++)
+      closureBases[level] = (level <= ar->nesting_level)?activationRecord(level)->floatMembers:nullptr;
 
-                  } //function_symbol != nullptr
-                  else
-                    RUNLOG_ARTI("%s %s not found %s\n", spaces+50-depth, key, function_name);
-                } //external functions
+    evaluate(this, block);
+    return !errorOccurred;
+  }
 
-                visitedAlready = true;
-                break;
-              }
-              case F_VarRef:
-              case F_Assign: //get or set a variable
-              {
-                const char * variable_name;
-                uint8_t variable_level;
-                uint8_t variable_index;
-                uint8_t variable_external;
-                JsonObject variable_indices;
-                JsonObject variable_value;
+  #if ARTI_PLATFORM != ARTI_ARDUINO
 
-                float resultValue = floatNull;
+  void transpileNotSupported(const char * construct, uint8_t par1 = 0)
+  {
+    (void)construct; (void)par1; //only used by WARNING_ARTI
+    if (!transpileError)
+      WARNING_ARTI("Transpile: %s not supported (%u)\n", construct, par1);
+    transpileError = true;
+  }
 
-                if (node == F_Assign) 
-                {
-                  variable_value = value["varref"];
+  //writes an indented line to transpileFile, nothing if no transpileFile
+  void transpileLine(uint8_t depth, const char * format, ...)
+  {
+    if (transpileFile == nullptr) return;
+    va_list argp;
+    va_start(argp, format);
+    fprintf(transpileFile, "%s", spaces+50-(depth>25?50:depth*2));
+    vfprintf(transpileFile, format, argp);
+    fprintf(transpileFile, "\n");
+    va_end(argp);
+  }
 
-                  if (value.containsKey("expr")) //value assignment
-                  {
-                    interpret(value, "expr", current_scope, depth + 1); //value pushed
+  //name of an external as used in the Externals enum of the definition e.g. setPixelColor for F_setPixelColor
+  const char * externalName(uint8_t external)
+  {
+    uint8_t index = 0;
+    for (JsonPair externalsPair: definitionJson["EXTERNALS"].as<JsonObject>())
+    {
+      if (index++ == external)
+        return externalsPair.key().c_str();
+    }
+    return "unknown";
+  }
 
-                    resultValue = valueStack->popFloat(); //result of interpret expr (but not for -- and ++ !!!!)
-                  }
-                }
-                else
-                  variable_value = value;
+  void transpileTemp(char *result)
+  {
+    snprintf(result, charLength, "t%u", transpileTemps++);
+  }
 
-                variable_name = variable_value["ID"];
-                variable_level = variable_value["level"];
-                variable_index = variable_value["index"];
-                variable_external = variable_value["external"];
-                variable_indices = variable_value["indices"];
+  //the record of a variable, like activationRecord: ar is the record of the function, parent the record of the program
+  void transpileVariable(uint8_t level, uint8_t index, char *result)
+  {
+    if (transpileMain && level <= 1)
+      snprintf(result, charLength, "program[%u]", index);
+    else if (!transpileMain && (level == 0 || level == 2))
+    {
+      snprintf(result, charLength, "ar[%u]", index);
+      transpileUsesAr = true;
+    }
+    else if (!transpileMain && level == 1)
+    {
+      snprintf(result, charLength, "parent[%u]", index);
+      transpileUsesParent = true;
+    }
+    else
+    {
+      transpileNotSupported("variable level", level);
+      strcpy(result, "0");
+    }
+  }
 
-                uint8_t oldIndex = valueStack->stack_index;
+  //", value1, value2 ..." for the parameters of externals
+  void transpileArguments(char *arguments, char values[][charLength], uint8_t count)
+  {
+    strcpy(arguments, "");
+    for (uint8_t i=0; i<count; i++)
+    {
+      strcat(arguments, ", ");
+      strcat(arguments, values[i]);
+    }
+  }
 
-                //array indices
-                char indices[charLength]; //used in RUNLOG_ARTI only
-                strcpy(indices, "");
-                if (!variable_indices.isNull()) 
-                {
-                  strcat(indices, "[");
-
-                  interpret(variable_value, "indices", current_scope, depth + 1); //values of indices pushed
-
-                  char sep[3] = "";
-                  for (uint8_t i = oldIndex; i< valueStack->stack_index; i++) {
-                    strcat(indices, sep);
-                    char itoaChar[charLength];
-                    // itoa(valueStack->floatStack[i], itoaChar, 10);
-                    snprintf(itoaChar, sizeof(itoaChar), "%f", valueStack->floatStack[i]);
-                    strcat(indices, itoaChar);
-                    strcpy(sep, ",");
-                  }
+  void transpileBinary(uint8_t depth, const char *result, uint8_t token, const char *left, const char *right)
+  {
+    switch (token)
+    {
+      case F_plus:
+        transpileLine(depth, "float %s = %s + %s;", result, left, right);
+        break;
+      case F_minus:
+        transpileLine(depth, "float %s = %s - %s;", result, left, right);
+        break;
+      case F_multiplication:
+        transpileLine(depth, "float %s = %s * %s;", result, left, right);
+        break;
+      case F_division:
+        transpileLine(depth, "float %s = artiDivision(%s, %s);", result, left, right);
+        break;
+      case F_modulo:
+        transpileLine(depth, "float %s = artiModulo(%s, %s);", result, left, right);
+        break;
+      case F_bitShiftLeft:
+        transpileLine(depth, "float %s = (int)%s << (int)%s;", result, left, right);
+        break;
+      case F_bitShiftRight:
+        transpileLine(depth, "float %s = (int)%s >> (int)%s;", result, left, right);
+        break;
+      case F_equal:
+        transpileLine(depth, "float %s = %s == %s;", result, left, right);
+        break;
+      case F_notEqual:
+        transpileLine(depth, "float %s = %s != %s;", result, left, right);
+        break;
+      case F_lessThen:
+        transpileLine(depth, "float %s = %s < %s;", result, left, right);
+        break;
+      case F_lessThenOrEqual:
+        transpileLine(depth, "float %s = %s <= %s;", result, left, right);
+        break;
+      case F_greaterThen:
+        transpileLine(depth, "float %s = %s > %s;", result, left, right);
+        break;
+      case F_greaterThenOrEqual:
+        transpileLine(depth, "float %s = %s >= %s;", result, left, right);
+        break;
+      default:
+        transpileNotSupported("operator", token);
+    }
+  }
 
-                  strcat(indices, "]");
-                }
+  //writes the values of list (left to right like interpret), returns the number of values
+  uint8_t transpileValues(uint16_t list, uint8_t depth, char values[][charLength], uint8_t maxValues)
+  {
+    uint8_t count = 0;
+    for (uint16_t child = syntaxTree->nodes[list].child; child != noNode; child = syntaxTree->nodes[child].next)
+    {
+      char value[charLength];
+      transpileValue(child, depth, value);
+      if (count < maxValues)
+        strcpy(values[count], value);
+      count++;
+    }
+    return count;
+  }
 
-                //check if external variable
-                if (variable_value.containsKey("external")) //added by Analyze
-                {
+  //writes exactly one value of list
+  void transpileListValue(uint16_t list, uint8_t depth, char *result)
+  {
+    char values[1][charLength];
+    if (transpileValues(list, depth, values, 1) == 1)
+      strcpy(result, values[0]);
+    else
+    {
+      transpileNotSupported("number of values");
+      strcpy(result, "0");
+    }
+  }
 
-                  if (node == F_VarRef) { //get the value
+  //writes the statements calculating the value of node, result is a constant, variable or temp
+  //values and operators in postfix order (see buildPostfix): values are pushed as C++ atoms, operators replace their operands by a temp
+  void transpilePostfix(uint16_t first, uint8_t depth, char *result)
+  {
+    char stack[arrayLength][charLength];
+    uint8_t stackLength = 0;
+    for (uint16_t child = first; child != noNode && !transpileError; child = syntaxTree->nodes[child].next)
+    {
+      Node *c = &syntaxTree->nodes[child];
+      if (c->kind != F_Operator)
+      {
+        if (stackLength >= arrayLength)
+        {
+          transpileNotSupported("expression");
+          break;
+        }
+        transpileValue(child, depth, stack[stackLength++]);
+      }
+      else if (c->index == 1 && stackLength >= 1)
+      {
+        char value[charLength];
+        strcpy(value, stack[stackLength - 1]);
+        transpileTemp(stack[stackLength - 1]);
+        transpileLine(depth, "float %s = -(%s);", stack[stackLength - 1], value);
+      }
+      else if (c->index == 2 && c->child != noNode && stackLength >= 1) //&& and ||: the right operand only if needed
+      {
+        char left[charLength];
+        char right[charLength];
+        strcpy(left, stack[stackLength - 1]);
+        transpileTemp(stack[stackLength - 1]);
+        transpileLine(depth, "float %s = %s;", stack[stackLength - 1], c->token == F_and?"0.0f":"1.0f");
+        transpileLine(depth, "if (%s %s 0.0f)", left, c->token == F_and?"!=":"==");
+        transpileLine(depth, "{");
+        transpilePostfix(c->child, depth + 1, right);
+        transpileLine(depth + 1, "%s = %s != 0.0f;", stack[stackLength - 1], right);
+        transpileLine(depth, "}");
+      }
+      else if (c->index == 2 && stackLength >= 2)
+      {
+        char left[charLength];
+        char right[charLength];
+        strcpy(right, stack[--stackLength]);
+        strcpy(left, stack[stackLength - 1]);
+        transpileTemp(stack[stackLength - 1]);
+        transpileBinary(depth, stack[stackLength - 1], c->token, left, right);
+      }
+      else
+      {
+        transpileNotSupported("expression");
+        break;
+      }
+    }
+    if (!transpileError && stackLength != 1)
+      transpileNotSupported("expression");
+    else if (!transpileError)
+      strcpy(result, stack[0]);
+  }
 
-                    resultValue = arti_get_external_variable(variable_external, (valueStack->stack_index - oldIndex>0)?valueStack->floatStack[oldIndex]:floatNull, (valueStack->stack_index - oldIndex>1)?valueStack->floatStack[oldIndex+1]:floatNull);
-                    valueStack->stack_index = oldIndex;
+  void transpileValue(uint16_t node, uint8_t depth, char *result)
+  {
+    strcpy(result, "0");
+    if (transpileError) return;
 
-                    if (resultValue != floatNull) 
-                    {
-                      valueStack->push(resultValue);
-                      RUNLOG_ARTI("%s %s ext.%s = %f (push %u)\n", spaces+50-depth, key, variable_name, resultValue, valueStack->stack_index); //key is variable_declaration name is ID
-                    }
-                    else
-                      ERROR_ARTI("%s Error: %s ext.%s no value\n", spaces+50-depth, key, variable_name);
-                  }
-                  else //assign: set the external value...
-                  {
-                    arti_set_external_variable(resultValue, variable_external, (valueStack->stack_index - oldIndex>0)?valueStack->floatStack[oldIndex]:floatNull, (valueStack->stack_index - oldIndex>1)?valueStack->floatStack[oldIndex+1]:floatNull);
-                    valueStack->stack_index = oldIndex;
+    Node *n = &syntaxTree->nodes[node];
 
-                    RUNLOG_ARTI("%s %s set ext.%s%s = %f (Pop %u)\n", spaces+50-depth, key, variable_name, indices, resultValue, oldIndex);
-                  }
-                }
-                else //not external, get er set the variable
-                {
-                  // Symbol* variable_symbol = current_scope->lookup(variable_name);
-                  ActivationRecord* ar;
+    switch (n->kind)
+    {
+      case F_Constant:
+      {
+        char number[20];
+        snprintf(number, sizeof(number), "%.9g", n->value); //9 digits: same float after reading it back
+        if (strpbrk(number, ".e") == nullptr)
+          strcat(number, ".0");
+        snprintf(result, charLength, "%sf", number);
+        break;
+      }
+      case F_VarRef:
+      {
+        char indices[2][charLength];
+        uint8_t nrOfIndices = transpileValues(syntaxTree->child(node, 0), depth, indices, 2); //indices of internal variables only evaluated, like interpret
 
-                  //check already defined in this scope
+        if (n->external != noExternal)
+        {
+          if (nrOfIndices > 2)
+            transpileNotSupported("number of indices", nrOfIndices);
 
-                  // RUNLOG_ARTI("%s levels %u-%u\n", spaces+50-depth, variable_level,  variable_index );
-                  if (variable_level != 0) { //var already exist
-                    //calculate the index in the call stack to find the right ar
-                    uint8_t index = this->callStack->recordsCounter - 1 - (this->callStack->peek()->nesting_level - variable_level);
-                    //  RUNLOG_ARTI("%s %s %s.%s = %s (push) %s %d-%d = %d (%d)\n", spaces+50-depth, key, ar->name, variable_name, varValue, variable_symbol->name, this->callStack->peek()->nesting_level,variable_symbol->scope_level, index,  this->callStack->recordsCounter); //key is variable_declaration name is ID
-                    ar = this->callStack->records[index];
-                  }
-                  else //var created here
-                    ar = this->callStack->peek();
+          char arguments[3 * charLength];
+          transpileArguments(arguments, indices, nrOfIndices>2?2:nrOfIndices);
+          transpileTemp(result);
+          transpileLine(depth, "float %s = %sarti_get_external_variable(F_%s%s);", result, transpileReceiver, externalName(n->external), arguments);
+        }
+        else
+          transpileVariable(n->level, n->index, result);
+        break;
+      }
+      case F_Call:
+      {
+        if (n->external == noExternal)
+        {
+          transpileNotSupported("function call in expression");
+          break;
+        }
 
-                  if (ar != nullptr) // variable found
-                  {
-                    if (node == F_VarRef) //get the value
-                    {
-                      //determine type, for now assume float
-                      float varValue = ar->getFloat(variable_index);
+        char actuals[5][charLength];
+        uint8_t nrOfActuals = transpileValues(n->child, depth, actuals, 5);
+        if (nrOfActuals > 5)
+          transpileNotSupported("number of actuals", nrOfActuals);
 
-                      valueStack->push(varValue);
-                      #if ARTI_PLATFORM != ARTI_ARDUINO  //for some weird reason this causes a crash on esp32
-                        RUNLOG_ARTI("%s %s %s.%s = %f (push %u) %u-%u\n", spaces+50-depth, key, ar->name, variable_name, varValue, valueStack->stack_index, variable_level, variable_index); //key is variable_declaration name is ID
-                      #endif
-                    }
-                    else { //assign: set the value 
-
-                      if (value.containsKey("assignoperator")) 
-                      {
-                        switch (value["assignoperator"].as<uint8_t>()) 
-                        {
-                          case F_plus:
-                            ar->set(variable_index, ar->getFloat(variable_index) + resultValue);
-                            break;
-                          case F_minus:
-                            ar->set(variable_index, ar->getFloat(variable_index) - resultValue);
-                            break;
-                          case F_multiplication:
-                            ar->set(variable_index, ar->getFloat(variable_index) * resultValue);
-                            break;
-                          case F_division: 
-                          {
-                            if (resultValue == 0) // divisor
-                            {
-                              resultValue = 1;
-                              ERROR_ARTI("%s /= division by 0 not possible, divisor ignored for %f\n", spaces+50-depth, ar->getFloat(variable_index));
-                            }
-                            ar->set(variable_index, ar->getFloat(variable_index) / resultValue);
-                            break;
-                          }
-                          case F_plusplus:
-                            ar->set(variable_index, ar->getFloat(variable_index) + 1);
-                            break;
-                          case F_minmin:
-                            ar->set(variable_index, ar->getFloat(variable_index) - 1);
-                            break;
-                        }
-
-                        RUNLOG_ARTI("%s %s.%s%s %s= %f (pop %u) %u-%u\n", spaces+50-depth, ar->name, variable_name, indices, tokenToString(value["assignoperator"]), ar->getFloat(variable_index), valueStack->stack_index, variable_level, variable_index);
-                      }
-                      else 
-                      {
-                        ar->set(variable_index, resultValue);
-                        RUNLOG_ARTI("%s %s.%s%s := %f (pop %u) %u-%u\n", spaces+50-depth, ar->name, variable_name, indices, ar->getFloat(variable_index), valueStack->stack_index, variable_level, variable_index);
-                      }
-                      valueStack->stack_index = oldIndex;
-                    }
-                  } //ar != nullptr
-                  else { //unknown variable
-                    ERROR_ARTI("%s %s %s unknown\n", spaces+50-depth, key, variable_name);
-                    valueStack->push(floatNull);
-                  }
-                } // ! founnd
-                visitedAlready = true;
-                break;
-              }
-              case F_Expr:
-              case F_Term: 
-              {
-                uint8_t oldIndex = valueStack->stack_index;
+        char arguments[6 * charLength];
+        transpileArguments(arguments, actuals, nrOfActuals>5?5:nrOfActuals);
+        transpileTemp(result);
+        transpileLine(depth, "float %s = %sarti_external_function(F_%s%s);", result, transpileReceiver, externalName(n->external), arguments);
+        break;
+      }
+      case F_Expr:
+      case F_Term:
+        transpilePostfix(n->child, depth, result);
+        break;
+      case F_Cex:
+      {
+        char condition[charLength];
+        char value[charLength];
+        transpileListValue(syntaxTree->child(node, 0), depth, condition);
+        transpileTemp(result);
+        transpileLine(depth, "float %s;", result);
+        transpileLine(depth, "if (%s == 1)", condition);
+        transpileLine(depth, "{");
+        transpileListValue(syntaxTree->child(node, 1), depth + 1, value);
+        transpileLine(depth + 1, "%s = %s;", result, value);
+        transpileLine(depth, "}");
+        transpileLine(depth, "else");
+        transpileLine(depth, "{");
+        transpileListValue(syntaxTree->child(node, 2), depth + 1, value);
+        transpileLine(depth + 1, "%s = %s;", result, value);
+        transpileLine(depth, "}");
+        break;
+      }
+      default:
+        transpileNotSupported("value", n->kind);
+    }
+  }
 
-                // RUNLOG_ARTI("%s before expr term interpret %s %s\n", spaces+50-depth, key, value.as<std::string>().c_str());
-                interpret(value, nullptr, current_scope, depth + 1); //pushes results
+  void transpileStatements(uint16_t list, uint8_t depth)
+  {
+    for (uint16_t child = syntaxTree->nodes[list].child; child != noNode && !transpileError; child = syntaxTree->nodes[child].next)
+      transpileStatement(child, depth);
+  }
 
-                // RUNLOG_ARTI("%s %s interpret > (%u - %u = %u)\n", spaces+50-depth, key, valueStack->stack_index, oldIndex, valueStack->stack_index - oldIndex);
+  void transpileStatement(uint16_t node, uint8_t depth)
+  {
+    if (depth > 25)
+      transpileNotSupported("nesting", depth);
+    if (transpileError) return;
 
-                // always 3, 5, 7 ... values
-                if (valueStack->stack_index - oldIndex >= 3) 
-                {
-                  float left = valueStack->floatStack[oldIndex];
-                  for (int i = 3; i <= valueStack->stack_index - oldIndex; i += 2)
-                  {
-                    uint8_t operatorx = valueStack->floatStack[oldIndex + i - 2];
-                    float right = valueStack->floatStack[oldIndex + i - 1];
-
-                    float evaluation = 0;
-
-                    switch (operatorx) {
-                      case F_plus: 
-                        evaluation = left + right;
-                        break;
-                      case F_minus: 
-                        evaluation = left - right;
-                        break;
-                      case F_multiplication: 
-                        evaluation = left * right;
-                        break;
-                      case F_division: {
-                        if (right == 0)
-                        {
-                          right = 1;
-                          ERROR_ARTI("%s division by 0 not possible, divisor ignored for %f\n", spaces+50-depth, left);
-                        }
-                        evaluation = left / right;
-                        break;
-                      }
-                      case F_modulo: {
-                        if (right == 0) {
-                          evaluation = left;
-                          ERROR_ARTI("%s mod 0 not possible, mod ignored %f\n", spaces+50-depth, left);
-                        }
-                        else 
-                          evaluation = fmod(left, right);
-                        break;
-                      }
-                      case F_bitShiftLeft: 
-                        evaluation = (int)left << (int)right; //only works on integers
-                        break;
-                      case F_bitShiftRight: 
-                        evaluation = (int)left >> (int)right; //only works on integers
-                        break;
-                      case F_equal: 
-                        evaluation = left == right;
-                        break;
-                      case F_notEqual: 
-                        evaluation = left != right;
-                        break;
-                      case F_lessThen: 
-                        evaluation = left < right;
-                        break;
-                      case F_lessThenOrEqual: 
-                        evaluation = left <= right;
-                        break;
-                      case F_greaterThen: 
-                        evaluation = left > right;
-                        break;
-                      case F_greaterThenOrEqual: 
-                        evaluation = left >= right;
-                        break;
-                      case F_and: 
-                        evaluation = left && right;
-                        break;
-                      case F_or: 
-                        evaluation = left || right;
-                        break;
-                      default:
-                        ERROR_ARTI("%s Programming error: unknown operator %u\n", spaces+50-depth, operatorx);
-                    }
+    Node *n = &syntaxTree->nodes[node];
 
-                    RUNLOG_ARTI("%s %f %s %f = %f (pop %u, push %u)\n", spaces+50-depth, left, tokenToString(operatorx), right, evaluation, valueStack->stack_index - i, valueStack->stack_index - i + 1);
+    switch (n->kind)
+    {
+      case F_Function: //member function, see transpile
+        if (!transpileMain)
+          transpileNotSupported("nested function");
+        break;
+      case F_Call:
+      {
+        char actuals[arrayLength][charLength];
+        uint8_t nrOfActuals = transpileValues(n->child, depth, actuals, arrayLength);
 
-                    left = evaluation;
-                  }
+        if (n->external != noExternal)
+        {
+          if (nrOfActuals > 5)
+            transpileNotSupported("number of actuals", nrOfActuals);
 
-                  valueStack->stack_index = oldIndex;
-    
-                  valueStack->push(left);
-                }
-                else if (valueStack->stack_index - oldIndex == 2) // unary: operator and 1 operand
-                {
-                  uint8_t operatorx = valueStack->floatStack[oldIndex];
-                  if (operatorx == F_minus) 
-                  {
-                    valueStack->stack_index = oldIndex;
-                    valueStack->push(-valueStack->floatStack[oldIndex + 1]);
-                    RUNLOG_ARTI("%s unary - %f (push %u)\n", spaces+50-depth, valueStack->floatStack[oldIndex + 1], valueStack->stack_index );
-                  }
-                  else
-                    RUNLOG_ARTI("%s unary operator not supported %u %s\n", spaces+50-depth, operatorx, tokenToString(operatorx));
-                }
+          char arguments[6 * charLength];
+          transpileArguments(arguments, actuals, nrOfActuals>5?5:nrOfActuals);
+          transpileLine(depth, "%sarti_external_function(F_%s%s);", transpileReceiver, externalName(n->external), arguments);
+        }
+        else
+        {
+          Symbol* function_symbol = n->symbol;
+          ScopedSymbolTable* function_scope = function_symbol->function_scope;
+
+          //a new record like interpret, missing actuals are 0 like compile
+          transpileLine(depth, "{");
+          transpileLine(depth + 1, "float callAr[%u] = {0};", function_scope->recordSize());
+          for (uint8_t i=0; i<function_scope->nrOfFormals && i<nrOfActuals && i<arrayLength; i++)
+            transpileLine(depth + 1, "callAr[%u] = %s;", function_scope->symbols[i]->scope_index, actuals[i]);
+          transpileLine(depth + 1, "%s(callAr, program);", function_symbol->name);
+          transpileLine(depth, "}");
+        }
+        break;
+      }
+      case F_Assign:
+      {
+        uint16_t exprList = syntaxTree->child(node, 1);
+        bool hasExpr = syntaxTree->nodes[exprList].child != noNode;
 
-                visitedAlready = true;
-                break;
-              }
-              case F_For: 
-              {
-                RUNLOG_ARTI("%s For (%u)\n", spaces+50-depth, valueStack->stack_index);
+        char value[charLength];
+        strcpy(value, "floatNull"); //e.g. ++ on external: no value like interpret
+        if (hasExpr)
+          transpileListValue(exprList, depth, value);
 
-                interpret(value, "assign", current_scope, depth + 1); //creates the assignment
-                ActivationRecord* ar = this->callStack->peek();
+        char indices[2][charLength];
+        uint8_t nrOfIndices = transpileValues(syntaxTree->child(node, 0), depth, indices, 2);
 
-                bool continuex = true;
-                uint16_t counter = 0;
-                while (continuex && counter < 2000) //to avoid endless loops
-                {
-                  RUNLOG_ARTI("%s iteration\n", spaces+50-depth);
+        if (n->external != noExternal)
+        {
+          if (nrOfIndices > 2)
+            transpileNotSupported("number of indices", nrOfIndices);
 
-                  RUNLOG_ARTI("%s check to condition\n", spaces+50-depth);
-                  interpret(value, "expr", current_scope, depth + 1); //pushes result of to
+          char arguments[3 * charLength];
+          transpileArguments(arguments, indices, nrOfIndices>2?2:nrOfIndices);
+          transpileLine(depth, "%sarti_set_external_variable(%s, F_%s%s);", transpileReceiver, value, externalName(n->external), arguments);
+          break;
+        }
 
-                  float conditionResult = valueStack->popFloat();
+        char variable[charLength];
+        transpileVariable(n->level, n->index, variable);
 
-                  RUNLOG_ARTI("%s conditionResult (pop %u)\n", spaces+50-depth, valueStack->stack_index);
+        if (!hasExpr && n->token != F_plusplus && n->token != F_minmin)
+          transpileNotSupported("assign without expression");
 
-                  if (conditionResult == 1) { //conditionResult is true
-                    RUNLOG_ARTI("%s 1 => run block\n", spaces+50-depth);
-                    interpret(value["block"], nullptr, current_scope, depth + 1);
+        switch (n->token)
+        {
+          case F_plus:
+            transpileLine(depth, "%s += %s;", variable, value);
+            break;
+          case F_minus:
+            transpileLine(depth, "%s -= %s;", variable, value);
+            break;
+          case F_multiplication:
+            transpileLine(depth, "%s *= %s;", variable, value);
+            break;
+          case F_division:
+            transpileLine(depth, "%s = artiDivision(%s, %s);", variable, variable, value);
+            break;
+          case F_plusplus:
+            transpileLine(depth, "%s += 1;", variable);
+            break;
+          case F_minmin:
+            transpileLine(depth, "%s -= 1;", variable);
+            break;
+          default:
+            transpileLine(depth, "%s = %s;", variable, value);
+        }
+        break;
+      }
+      case F_For:
+      {
+        uint16_t assignList = syntaxTree->child(node, 0);
+        transpileStatements(assignList, depth);
+
+        //pascal mode increments the last assigned variable, like closureFor
+        uint16_t loopVariable = noNode;
+        for (uint16_t child = syntaxTree->nodes[assignList].child; child != noNode; child = syntaxTree->nodes[child].next)
+          if (syntaxTree->nodes[child].kind == F_Assign && syntaxTree->nodes[child].external == noExternal)
+            loopVariable = child;
+
+        char counter[charLength];
+        char condition[charLength];
+        transpileTemp(counter);
+        transpileLine(depth, "for (uint16_t %s = 0; ; %s++)", counter, counter);
+        transpileLine(depth, "{");
+        transpileLine(depth + 1, "if (%s >= maxForIterations)", counter);
+        transpileLine(depth + 1, "{");
+        transpileLine(depth + 2, "ERROR_ARTI(\"too many iterations in for loop %%u\\n\", maxForIterations);");
+        transpileLine(depth + 2, "break;");
+        transpileLine(depth + 1, "}");
+        transpileListValue(syntaxTree->child(node, 1), depth + 1, condition);
+        transpileLine(depth + 1, "if (%s == 1) //C mode: run block and increment", condition);
+        transpileLine(depth + 1, "{");
+        transpileStatements(syntaxTree->child(node, 2), depth + 2);
+        transpileStatements(syntaxTree->child(node, 3), depth + 2);
+        transpileLine(depth + 1, "}");
+        transpileLine(depth + 1, "else if (%s == 0)", condition);
+        transpileLine(depth + 2, "break;");
+        if (loopVariable != noNode)
+        {
+          char variable[charLength];
+          char varValue[charLength];
+          transpileVariable(syntaxTree->nodes[loopVariable].level, syntaxTree->nodes[loopVariable].index, variable);
+          transpileTemp(varValue);
+          transpileLine(depth + 1, "else //pascal mode: run block and increment loop variable");
+          transpileLine(depth + 1, "{");
+          transpileLine(depth + 2, "float %s = %s;", varValue, variable);
+          transpileLine(depth + 2, "if (%s > %s)", varValue, condition);
+          transpileLine(depth + 3, "break;");
+          transpileStatements(syntaxTree->child(node, 2), depth + 2);
+          transpileLine(depth + 2, "%s = %s + 1;", variable, varValue);
+          transpileLine(depth + 1, "}");
+        }
+        else
+        {
+          transpileLine(depth + 1, "else");
+          transpileLine(depth + 2, "break;");
+        }
+        transpileLine(depth, "}");
+        break;
+      }
+      case F_If:
+      {
+        uint16_t exprList = syntaxTree->child(node, 0);
+        uint16_t elseList = syntaxTree->child(node, 2);
 
-                    RUNLOG_ARTI("%s assign next value\n", spaces+50-depth);
-                    interpret(value["increment"], nullptr, current_scope, depth + 1); //pushes increment result
-                    // MEMORY_ARTI("%s Iteration %u %u\n", spaces+50-depth, counter, FREE_SIZE);
-                  }
-                  else 
-                  {
-                    if (conditionResult == 0) { //conditionResult is false
-                      RUNLOG_ARTI("%s 0 => end of For\n", spaces+50-depth);
-                      continuex = false;
-                    }
-                    else // conditionResult is a value (e.g. in pascal)
-                    {
-                      //get the variable from assignment
-                      float varValue = ar->getFloat(ar->lastSetIndex);
-
-                      float evaluation = varValue <= conditionResult;
-                      RUNLOG_ARTI("%s %s.(%u) %f <= %f = %f\n", spaces+50-depth, ar->name, ar->lastSetIndex, varValue, conditionResult, evaluation);
-
-                      if (evaluation == 1) 
-                      {
-                        RUNLOG_ARTI("%s 1 => run block\n", spaces+50-depth);
-                        interpret(value["block"], nullptr, current_scope, depth + 1);
-
-                        //increment
-                        ar->set(ar->lastSetIndex, varValue + 1);
-                      }
-                      else 
-                      {
-                        RUNLOG_ARTI("%s 0 => end of For\n", spaces+50-depth);
-                        continuex = false;
-                      }
-                    }
-                  }
-                  counter++;
-                };
+        if (syntaxTree->nodes[exprList].child == noNode)
+        {
+          transpileNotSupported("if without expression");
+          break;
+        }
 
-                if (continuex)
-                  ERROR_ARTI("%s too many iterations in for loop %u\n", spaces+50-depth, counter);
+        char condition[charLength];
+        transpileListValue(exprList, depth, condition);
+        transpileLine(depth, "if (%s == 1)", condition);
+        transpileLine(depth, "{");
+        transpileStatements(syntaxTree->child(node, 1), depth + 1);
+        transpileLine(depth, "}");
+        if (syntaxTree->nodes[elseList].child != noNode)
+        {
+          transpileLine(depth, "else");
+          transpileLine(depth, "{");
+          transpileStatements(elseList, depth + 1);
+          transpileLine(depth, "}");
+        }
+        break;
+      }
+      default:
+        transpileNotSupported("statement", n->kind);
+    }
+  }
 
-                visitedAlready = true;
-                break;
-              }  // case
-              case F_If: 
-              {
-                RUNLOG_ARTI("%s If (stack %u)\n", spaces+50-depth, valueStack->stack_index);
+  //writes the syntaxTree as a C++ struct with a member function per function, so the program can be compiled natively
+  //externals are called as receiver.arti_external_function(F_name, ...) e.g. strip. in WLED, see arti_wled_transpile.cpp
+  //header: included before the transpiled file, declares the receiver, the F_ externals and the globals used by transpileLoop
+  bool transpile(const char *fileName, const char *structName, const char *receiver, const char *header)
+  {
+    if (syntaxTree == nullptr || global_scope == nullptr)
+    {
+      ERROR_ARTI("Transpile: no syntax tree, setup with E_TreeWalker\n");
+      return false;
+    }
 
-                RUNLOG_ARTI("%s condition\n", spaces+50-depth);
-                if (value.containsKey("expr"))
-                  interpret(value, "expr", current_scope, depth + 1);
-                // else if (value.containsKey("varref"))
-                //   interpret(value, "varref", current_scope, depth + 1);
+    transpileFile = fopen(fileName, "w");
+    if (transpileFile == nullptr)
+    {
+      ERROR_ARTI("Transpile: cannot create %s\n", fileName);
+      return false;
+    }
 
-                float conditionResult = valueStack->popFloat();
+    transpileReceiver = receiver;
+    transpileTemps = 0;
+    transpileError = false;
+
+    transpileLine(0, "//program %s transpiled by ARTI::transpile, do not edit", global_scope->scope_name);
+    transpileLine(0, "//needs %s, included before this file: %sarti_external_function, the F_ externals and its globals", header, receiver);
+    transpileLine(0, "");
+    transpileLine(0, "#pragma once");
+    transpileLine(0, "");
+    transpileLine(0, "struct %s", structName);
+    transpileLine(0, "{");
+    transpileLine(1, "float program[%u]; //activation record of the program", global_scope->recordSize());
+    for (uint8_t i=0; i<global_scope->symbolsIndex; i++)
+      if (global_scope->symbols[i]->symbol_type != F_Function)
+        transpileLine(1, "//program[%u] %s", global_scope->symbols[i]->scope_index, global_scope->symbols[i]->name);
+    transpileLine(0, "");
+
+    for (uint16_t program = syntaxTree->nodes[0].child; program != noNode; program = syntaxTree->nodes[program].next)
+    {
+      if (syntaxTree->nodes[program].kind != F_Program) continue;
 
-                RUNLOG_ARTI("%s (pop %u)\n", spaces+50-depth, valueStack->stack_index);
+      uint16_t block = syntaxTree->child(program, 0);
 
-                if (conditionResult == 1) //conditionResult is true
-                  interpret(value, "block", current_scope, depth + 1);
-                else
-                  interpret(value, "elseBlock", current_scope, depth + 1);
+      //functions: ar is the activation record of the function, parent the record below it on the call stack
+      for (uint16_t function = syntaxTree->nodes[block].child; function != noNode; function = syntaxTree->nodes[function].next)
+      {
+        if (syntaxTree->nodes[function].kind != F_Function) continue;
+
+        Symbol* function_symbol = syntaxTree->nodes[function].symbol;
+        ScopedSymbolTable* function_scope = function_symbol->function_scope;
+
+        if (strcmp(function_symbol->name, "setup") == 0 || strcmp(function_symbol->name, "loop") == 0 || strcmp(function_symbol->name, "program") == 0)
+          transpileNotSupported(function_symbol->name);
+
+        //first without writing: parameters not used by the function are unnamed
+        FILE *file = transpileFile;
+        uint16_t temps = transpileTemps;
+        transpileFile = nullptr;
+        transpileUsesAr = false;
+        transpileUsesParent = false;
+        transpileMain = false;
+        transpileStatements(syntaxTree->child(function, 0), 2);
+        transpileFile = file;
+        transpileTemps = temps;
+
+        transpileLine(1, "void %s(float *%s, float *%s)", function_symbol->name, transpileUsesAr?"ar":"", transpileUsesParent?"parent":"");
+        transpileLine(1, "{");
+        for (uint8_t i=0; i<function_scope->symbolsIndex; i++)
+          transpileLine(2, "//ar[%u] %s", function_scope->symbols[i]->scope_index, function_scope->symbols[i]->name);
+        transpileStatements(syntaxTree->child(function, 0), 2);
+        transpileLine(1, "}");
+        transpileLine(0, "");
+      }
 
-                visitedAlready = true;
-                break;
-              }  // case
-              case F_Cex: 
-              {
-                RUNLOG_ARTI("%s Cex (stack %u)\n", spaces+50-depth, valueStack->stack_index);
+      transpileLine(1, "//runs the main block of the program, like ARTI::setup");
+      transpileLine(1, "void setup()");
+      transpileLine(1, "{");
+      transpileLine(2, "memset(program, 0, sizeof(program));");
+      transpileLine(2, "frameCounter = 0;");
+      transpileMain = true;
+      transpileStatements(block, 2);
+      transpileLine(1, "}");
+      transpileLine(0, "");
+    }
 
-                RUNLOG_ARTI("%s condition\n", spaces+50-depth);
-                interpret(value, "expr", current_scope, depth + 1);
+    transpileLoop();
 
-                float conditionResult = valueStack->popFloat();
+    transpileLine(0, "}; //%s", structName);
 
-                RUNLOG_ARTI("%s (pop %u)\n", spaces+50-depth, valueStack->stack_index);
+    fclose(transpileFile);
+    transpileFile = nullptr;
 
-                if (conditionResult == 1) //conditionResult is true
-                  interpret(value, "trueExpr", current_scope, depth + 1);
-                else
-                  interpret(value, "falseExpr", current_scope, depth + 1);
+    if (transpileError)
+      ERROR_ARTI("Transpile of %s failed\n", global_scope->scope_name);
+    else
+      MEMORY_ARTI("transpile %s into %s ✓\n", global_scope->scope_name, fileName);
 
-                visitedAlready = true;
-                break;
-              }  // case
-              default:  //visitedalready false => recursive call
-                break;
-            }
-          } // is key is node_name
+    return !transpileError;
+  } //transpile
 
-          if (!visitedAlready && value.size() > 0) // if size == 0 then injected key/value like operator
-            interpret(value, nullptr, current_scope, depth + 1);
-        } // if treeelement
-                // RUNLOG_ARTI("%s before end for %u\n", spaces+50-depth, depth);
-      } // for (JsonPair)
-    }
-    else if (parseTree.is<JsonArray>()) 
-    {
-      for (JsonVariant newParseTree: parseTree.as<JsonArray>()) 
-      {
-        // RUNLOG_ARTI("%s\n", spaces+50-depth, "Array ", parseTree[i], "  ";
-        interpret(newParseTree, nullptr, current_scope, depth + 1);
-      }
-    }
-    else { //not array
-      ERROR_ARTI("%s Error: parseTree should be array or object %s (%u)\n", spaces+50-depth, parseTree.as<std::string>().c_str(), depth);
-    }
+  #endif
 
-    return !errorOccurred;
-  } //interpret
+  //runs the block of a function (e.g. renderFrame) with the selected engine, its activation record must be pushed already
+  bool run(Symbol* function_symbol, uint8_t depth = 0)
+  {
+    if (engine == E_TreeWalker)
+      return interpretStatements(function_symbol->block_node, depth);
+    else if (engine == E_RegisterVM || engine == E_JIT)
+      return runRegisters(function_symbol->code_entry);
+    else if (engine == E_Closures)
+      return runClosures(function_symbol->closure);
+    else
+      return execute(function_symbol->code_entry);
+  }
+
+  //true if setup created something to run
+  bool programLoaded()
+  {
+    if (engine == E_TreeWalker)
+      return syntaxTree != nullptr;
+    else if (engine == E_RegisterVM || engine == E_JIT)
+      return registerCode != nullptr;
+    else if (engine == E_Closures)
+      return closureProgram != nullptr;
+    else
+      return byteCode != nullptr;
+  }
 
   void closeLog() 
   {
@@ -2435,12 +8875,19 @@ public:
     #endif
   }
 
-  bool setup(const char *definitionName, const char *programName)
+  //engine: E_TreeWalker interprets the syntaxTree each frame, other engines compile it once
+  bool setup(const char *definitionName, const char *programName, uint8_t engine = ARTI_ENGINE)
   {
     errorOccurred = false;
     frameCounter = 0;
+    colors.reset(); //handles of the previous program are not used anymore
+    this->engine = engine;
 
-    logToFile = true;
+    #ifdef ARTI_BENCHMARK
+      logToFile = false; //keep the logs of the test
+    #else
+      logToFile = true;
+    #endif
     //open logFile
     if (logToFile)
     {
@@ -2515,6 +8962,23 @@ public:
       ERROR_ARTI("Setup Error: No start node found in definition file %s\n", definitionName);
       return false;
     }
+    if (metaData["fastMath"] == true)
+      fastMath = true;
+
+    //external variables which do not change during a frame, see snapshotUniforms
+    uniformsLength = 0;
+    uint8_t external = 0;
+    for (JsonPair externalsPair: definitionJson["EXTERNALS"].as<JsonObject>())
+    {
+      if (externalsPair.value()["frameConstant"] == true)
+      {
+        if (uniformsLength < nrOfUniforms)
+          uniformExternals[uniformsLength++] = external;
+        else
+          WARNING_ARTI("more than %u frameConstant externals, %s read each time\n", nrOfUniforms, externalsPair.key().c_str());
+      }
+      external++;
+    }
 
     #if ARTI_PLATFORM == ARTI_ARDUINO
       File programFile;
@@ -2530,20 +8994,36 @@ public:
       return  false;
     }
 
-    //open programFile
+    //open programFile: the whole file, tokens have 16 bit positions
     char * programText;
-    uint16_t programFileSize;
+    uint32_t programFileSize;
     #if ARTI_PLATFORM == ARTI_ARDUINO
       programFileSize = programFile.size();
-      programText = (char *)malloc(programFileSize+1);
+    #else
+      programFile.seekg(0, std::ios::end);
+      programFileSize = programFile.tellg();
+      programFile.seekg(0, std::ios::beg);
+    #endif
+    if (programFileSize >= UINT16_MAX)
+    {
+      ERROR_ARTI("Program file %s too long: %u bytes, at most %u\n", programName, (unsigned int)programFileSize, UINT16_MAX - 1);
+      programFile.close();
+      return false;
+    }
+    programText = (char *)malloc(programFileSize + 1);
+    if (programText == nullptr)
+    {
+      ERROR_ARTI("Program file %s: no memory for %u bytes\n", programName, (unsigned int)programFileSize);
+      programFile.close();
+      return false;
+    }
+    #if ARTI_PLATFORM == ARTI_ARDUINO
       programFile.read((byte *)programText, programFileSize);
       programText[programFileSize] = '\0';
     #else
-      programText = (char *)malloc(programTextSize);
-      programFile.read(programText, programTextSize);
+      programFile.read(programText, programFileSize);
       DEBUG_ARTI("programFile size %lu bytes\n", programFile.gcount());
       programText[programFile.gcount()] = '\0';
-      programFileSize = strlen(programText);
     #endif
     programFile.close();
 
@@ -2555,7 +9035,7 @@ public:
     #if ARTI_PLATFORM == ARTI_ARDUINO
       parseTreeJsonDoc = new DynamicJsonDocument(32768); //less memory on arduino: 32 vs 64 bit?
     #else
-      parseTreeJsonDoc = new DynamicJsonDocument(65536);
+      parseTreeJsonDoc = new DynamicJsonDocument(programFileSize * 96 > 65536?programFileSize * 96:65536); //the Examples and long lists of statements need up to 70 bytes per character
     #endif
 
     MEMORY_ARTI("parseTree %u => %u ✓\n", (unsigned int)parseTreeJsonDoc->capacity(), FREE_SIZE);
@@ -2578,26 +9058,38 @@ public:
     {
       parseTreeJson = parseTreeJsonDoc->as<JsonVariant>();
 
-      lexer = new Lexer(programText, definitionJson);
-      lexer->get_next_token();
+      grammar = new Grammar(definitionJson);
+      uint16_t start = grammar->compile(startNode);
+      if (start == noElement)
+        return false;
+
+      lexer = new Lexer(programText, grammar);
+      if (!lexer->tokenize())
+        return false;
 
       if (stages < 2) {close(); return true;}
 
-      uint8_t result = parse(parseTreeJson, startNode, '&', lexer->definitionJson[startNode], 0);
+      uint8_t result = parse(parseTreeJson, startNode, '&', grammar->nodes[start].element, 0);
 
-      if (this->lexer->pos != strlen(this->lexer->text)) 
+      Token *token = this->lexer->current_token();
+      if (token->kind != endKind) 
       {
-        ERROR_ARTI("Node %s Program not entirely parsed (%u,%u) %u of %u\n", startNode, this->lexer->lineno, this->lexer->column, this->lexer->pos, (unsigned int)strlen(this->lexer->text));
+        ERROR_ARTI("Node %s Program not entirely parsed (%u,%u) %u of %u\n", startNode, token->lineno, token->column, token->pos, this->lexer->length);
         return false;
       }
       else if (result == ResultFail) 
       {
-        ERROR_ARTI("Node %s Program parsing failed (%u,%u) %u of %u\n", startNode, this->lexer->lineno, this->lexer->column, this->lexer->pos, (unsigned int)strlen(this->lexer->text));
+        ERROR_ARTI("Node %s Program parsing failed (%u,%u) %u of %u\n", startNode, token->lineno, token->column, token->pos, this->lexer->length);
+        return false;
+      }
+      else if (parseTreeJsonDoc->overflowed())
+      {
+        ERROR_ARTI("Node %s Program too large for the parseTree (%u bytes)\n", startNode, (unsigned int)parseTreeJsonDoc->capacity());
         return false;
       }
       else
       {
-        DEBUG_ARTI("Node %s Parsed until (%u,%u) %u of %u\n", startNode, this->lexer->lineno, this->lexer->column, this->lexer->pos, (unsigned int)strlen(this->lexer->text));
+        DEBUG_ARTI("Node %s Parsed until (%u,%u) %u of %u\n", startNode, token->lineno, token->column, token->pos, this->lexer->length);
         MEMORY_ARTI("parse %u ✓\n", FREE_SIZE);
       }
 
@@ -2608,6 +9100,7 @@ public:
       MEMORY_ARTI("garbageCollect %u / %u%% -> %u / %u%%\n", (unsigned int)memBefore, 100 * memBefore / parseTreeJsonDoc->capacity(), (unsigned int)parseTreeJsonDoc->memoryUsage(), 100 * parseTreeJsonDoc->memoryUsage() / parseTreeJsonDoc->capacity());
 
       delete lexer; lexer =  nullptr;
+      delete grammar; grammar = nullptr;
     }
     else
     {
@@ -2621,9 +9114,7 @@ public:
         }
       #endif
     }
-    #if ARTI_PLATFORM == ARTI_ARDUINO //not on windows as cause crash???
-      free(programText);
-    #endif
+    free(programText);
 
     if (stages >= 3)
     {
@@ -2665,18 +9156,180 @@ public:
 
     if (stages < 5 || errorOccurred) {close(); return !errorOccurred;}
 
+    if (global_scope != nullptr)
+    {
+      DEBUG_ARTI("\nSyntax tree\n");
+      syntaxTree = new SyntaxTree();
+      astParent = noNode;
+      astLast = noNode;
+      openNode(addNode(F_List)); //root: node 0
+      if (!buildSyntaxTree(parseTreeJson))
+      {
+        ERROR_ARTI("Build syntax tree failed\n");
+        return false;
+      }
+      if (hoisting && !hoist("renderLed"))
+        return false;
+      #if ARTI_THREADS
+        checkParallel("renderLed");
+      #endif
+      checkFrameSkipping();
+      #ifdef ARTI_DEBUG
+        syntaxTree->dump(0);
+      #endif
+      MEMORY_ARTI("syntaxTree %u nodes of %u bytes %u ✓\n", syntaxTree->nodesIndex, (unsigned int)sizeof(Node), FREE_SIZE);
+
+      //the parseTree is not needed anymore, all engines run from the syntaxTree
+      MEMORY_ARTI("parseTree %u freed\n", (unsigned int)parseTreeJsonDoc->capacity());
+      delete parseTreeJsonDoc; parseTreeJsonDoc = nullptr;
+    }
+
     //interpret main
-    callStack = new CallStack();
     valueStack = new ValueStack();
 
+    if (global_scope != nullptr && this->engine == E_Closures)
+    {
+      DEBUG_ARTI("\nClosures\n");
+      compileError = false;
+      contextsIndex = 0;
+      closureValuesIndex = 0;
+
+      if (buildClosures(0) && closureProgram != nullptr)
+        MEMORY_ARTI("closures %u of %u bytes %u ✓\n", closuresLength - (closuresPerChunk - closureChunkIndex), (unsigned int)sizeof(Closure), FREE_SIZE);
+      else
+      {
+        if (errorOccurred)
+          return false;
+        WARNING_ARTI("Build closures failed, falling back to interpret\n");
+        freeClosures();
+        closureProgram = nullptr;
+        this->engine = E_TreeWalker;
+      }
+    }
+    else if (global_scope != nullptr && this->engine != E_TreeWalker)
+    {
+      DEBUG_ARTI("\nCompiler\n");
+      byteCode = new ByteCode();
+      compileError = false;
+      contextsIndex = 0;
+
+      if (compile(0) && byteCode->maxStackDepth <= arrayLength)
+      {
+        #ifdef ARTI_DEBUG
+          byteCode->dump();
+        #endif
+        MEMORY_ARTI("compile %u bytes, stack %u %u ✓\n", byteCode->length, byteCode->maxStackDepth, FREE_SIZE);
+      }
+      else
+      {
+        if (errorOccurred)
+          return false;
+        WARNING_ARTI("Compile failed (stack %u), falling back to interpret\n", byteCode->maxStackDepth);
+        delete byteCode; byteCode = nullptr;
+        this->engine = E_TreeWalker;
+      }
+    }
+
+    if (byteCode != nullptr && (this->engine == E_RegisterVM || this->engine == E_JIT))
+    {
+      DEBUG_ARTI("\nRegister code\n");
+      registerCode = new RegisterCode();
+
+      if (registerCode->translate(byteCode) && registerCode->maxStackDepth <= arrayLength)
+      {
+        //the stack based byteCode is not needed anymore
+        delete byteCode; byteCode = nullptr;
+
+        #ifdef ARTI_DEBUG
+          registerCode->dump();
+        #endif
+        if (!registerCode->decode())
+          return false;
+        MEMORY_ARTI("translate %u bytes, %u instructions, %u constants, temps %u %u ✓\n", registerCode->length, registerCode->instructionsLength, registerCode->constantsIndex, registerCode->maxStackDepth, FREE_SIZE);
+
+        if (this->engine == E_JIT)
+        {
+          #if ARTI_JIT
+            if (jit())
+              MEMORY_ARTI("jit %u bytes %u ✓\n", jitCode->length, FREE_SIZE);
+            else
+            {
+              if (errorOccurred)
+                return false;
+              WARNING_ARTI("JIT failed, falling back to register code\n");
+              delete jitCode; jitCode = nullptr;
+              this->engine = E_RegisterVM;
+            }
+          #else
+            WARNING_ARTI("JIT not available on this platform, falling back to register code\n");
+            this->engine = E_RegisterVM;
+          #endif
+        }
+
+        if (this->engine == E_RegisterVM && superinstructions)
+        {
+          uint16_t fused = registerCode->fuse();
+          (void)fused; //only used by MEMORY_ARTI
+          if (errorOccurred)
+            return false;
+          MEMORY_ARTI("fuse %u superinstructions, %u instructions ✓\n", fused, registerCode->instructionsLength);
+        }
+      }
+      else
+      {
+        if (errorOccurred)
+          return false;
+        WARNING_ARTI("Translate failed (temps %u), falling back to byteCode\n", registerCode->maxStackDepth);
+        delete registerCode; registerCode = nullptr;
+        this->engine = E_StackVM;
+      }
+    }
+
+    if (syntaxTree != nullptr)
+      sizeArena();
+    callStack = new CallStack(arenaLength);
+
+    //compiled engines do not need the syntaxTree anymore
+    if (this->engine != E_TreeWalker && syntaxTree != nullptr)
+    {
+      delete syntaxTree; syntaxTree = nullptr;
+    }
+
     if (global_scope != nullptr) //due to undefined functions??? wip
     { 
       RUNLOG_ARTI("\ninterpret %s %u %u\n", global_scope->scope_name, global_scope->scope_level, global_scope->symbolsIndex); 
 
-      if (!interpret(parseTreeJson)) 
+      snapshotUniforms();
+
+      if (this->engine == E_TreeWalker)
       {
-        ERROR_ARTI("Interpret main failed\n");
-        return false;
+        if (!interpret(0)) 
+        {
+          ERROR_ARTI("Interpret main failed\n");
+          return false;
+        }
+      }
+      else
+      {
+        // do not release main stack and program ar as used in subsequent calls (see interpret program)
+        ActivationRecord* ar = this->callStack->allocate(global_scope->scope_name, 1, global_scope->recordSize());
+        if (ar == nullptr)
+          return false;
+        this->callStack->push(ar);
+
+        bool result;
+        if (this->engine == E_Closures)
+          result = runClosures(closureProgram);
+        else if (this->engine == E_RegisterVM || this->engine == E_JIT)
+          result = runRegisters(0);
+        else
+          result = execute(0);
+
+        if (!result) 
+        {
+          ERROR_ARTI("Execute main failed\n");
+          return false;
+        }
       }
     }
     else
@@ -2690,13 +9343,39 @@ public:
     return !errorOccurred;
   } // setup
 
+  //E_RegisterVM: number of instructions and, if ARTI_COUNT, the instructions run so far (see arti_wled_superinstructions.cpp)
+  void registerCounts(uint16_t *instructions, uint32_t *executed)
+  {
+    *instructions = registerCode != nullptr?registerCode->instructionsLength:0;
+    *executed = registerCode != nullptr?registerCode->executedInstructions:0;
+  }
+
   void close() {
     MEMORY_ARTI("closing Arti %u\n", FREE_SIZE);
 
+    #if ARTI_THREADS
+      stopParallel();
+      parallelFunction = nullptr;
+    #endif
     if (callStack != nullptr) {delete callStack; callStack = nullptr;}
     if (valueStack != nullptr) {delete valueStack; valueStack = nullptr;}
+    colors.release();
+    if (byteCode != nullptr) {delete byteCode; byteCode = nullptr;}
+    if (registerCode != nullptr) {delete registerCode; registerCode = nullptr;}
+    #if ARTI_JIT
+      if (jitCode != nullptr) {delete jitCode; jitCode = nullptr;}
+    #endif
+    if (laneCode != nullptr) {delete laneCode; laneCode = nullptr;}
+    lanesBuilt = false;
+    free(previousRecord); previousRecord = nullptr;
+    frameInputsValid = false;
+    if (syntaxTree != nullptr) {delete syntaxTree; syntaxTree = nullptr;}
+    freeClosures();
+    closureProgram = nullptr;
     if (global_scope != nullptr) {delete global_scope; global_scope = nullptr;}
 
+    if (grammar != nullptr) {delete grammar; grammar = nullptr;}
+
     if (definitionJsonDoc != nullptr) {
       MEMORY_ARTI("definitionJson  %u / %u%% (%u %u %u)\n", (unsigned int)definitionJsonDoc->memoryUsage(), 100 * definitionJsonDoc->memoryUsage() / definitionJsonDoc->capacity(), (unsigned int)definitionJsonDoc->size(), definitionJsonDoc->overflowed(), (unsigned int)definitionJsonDoc->nesting());
       delete definitionJsonDoc; definitionJsonDoc = nullptr;
@@ -54,6 +54,18 @@ float ARTI::arti_get_external_variable(uint8_t variable, float par1, float par2,
 void ARTI::arti_set_external_variable(float value, uint8_t variable, float par1, float par2, float par3) {
 }
 
+uint8_t ARTI::arti_external_state(uint8_t external) {
+  return external; //printf
+}
+
+void ARTI::arti_external_store_call(uint8_t variable, uint8_t function, float par1, float par2, float par3, float index1, float index2) {
+  arti_set_external_variable(arti_external_function(function, par1, par2, par3), variable, index1, index2);
+}
+
+uint8_t ARTI::arti_external_frame(uint8_t external) {
+  return frameDependent; //printf
+}
+
 bool ARTI::loop() {
   //pas example has no loop function
 
@@ -64,17 +76,19 @@ bool ARTI::loop() {
 
   if (function_symbol != nullptr) //calling undefined function: pre-defined functions e.g. print
   {
-    ActivationRecord* ar = new ActivationRecord(function_name, "Function", function_symbol->scope_level + 1);
+    ActivationRecord* ar = this->callStack->allocate(function_name, function_symbol->scope_level + 1, function_symbol->function_scope->recordSize());
+    if (ar == nullptr)
+      return false;
 
     RUNLOG_ARTI("%s %s %s (%u)\n", spaces+50-depth, "Call", function_name, this->callStack->recordsCounter);
 
     this->callStack->push(ar);
 
-    interpret(function_symbol->block, nullptr, global_scope, depth + 1);
+    run(function_symbol, depth + 1);
 
     this->callStack->pop();
 
-    delete ar; ar = nullptr;
+    this->callStack->release(ar);
   }
   else 
   {
@@ -84,3 +98,10 @@ bool ARTI::loop() {
 
   return true;
 } // loop
+
+#if ARTI_PLATFORM != ARTI_ARDUINO
+void ARTI::transpileLoop() {
+  //pas example has no loop function, see wled for renderFrame and renderLed
+  transpileLine(1, "bool loop() { return true; }");
+}
+#endif
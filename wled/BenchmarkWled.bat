@@ -0,0 +1,4 @@
+g++.exe -std=c++11 -O2 -DARTI_DISPATCH=ARTI_SWITCH arti_wled_benchmark.cpp -pthread -o arti_wled_benchmark_switch.exe
+g++.exe -std=c++11 -O2 -DARTI_DISPATCH=ARTI_THREADED arti_wled_benchmark.cpp -pthread -o arti_wled_benchmark_threaded.exe
+.\arti_wled_benchmark_switch.exe
+.\arti_wled_benchmark_threaded.exe
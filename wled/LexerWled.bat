@@ -0,0 +1,2 @@
+g++.exe -std=c++11 -O2 arti_wled_lexer.cpp -pthread -o arti_wled_lexer.exe
+.\arti_wled_lexer.exe
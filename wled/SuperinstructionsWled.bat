@@ -0,0 +1,3 @@
+g++.exe -std=c++11 -O2 arti_wled_superinstructions.cpp -o arti_wled_superinstructions.exe
+.\arti_wled_superinstructions.exe > superinstructions.md
+type superinstructions.md
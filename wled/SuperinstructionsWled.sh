@@ -0,0 +1,3 @@
+g++ -std=c++11 -O2 arti_wled_superinstructions.cpp -o arti_wled_superinstructions
+./arti_wled_superinstructions > superinstructions.md
+cat superinstructions.md
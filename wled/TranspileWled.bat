@@ -0,0 +1,4 @@
+g++.exe -std=c++11 -g arti_wled_transpile.cpp -o arti_wled_transpile.exe
+for %%p in (Subpixel PhaseShift Mover WaveSins Sinelon drip PerlinMove ripple Kitt beatmania) do .\arti_wled_transpile.exe Examples/%%p.wled wled.json
+g++.exe -std=c++11 -O2 arti_wled_transpile_test.cpp -o arti_wled_transpile_test.exe
+.\arti_wled_transpile_test.exe
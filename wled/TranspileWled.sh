@@ -0,0 +1,7 @@
+g++ -std=c++11 -g arti_wled_transpile.cpp -o arti_wled_transpile
+for program in Subpixel PhaseShift Mover WaveSins Sinelon drip PerlinMove ripple Kitt beatmania
+do
+  ./arti_wled_transpile Examples/$program.wled wled.json
+done
+g++ -std=c++11 -O2 arti_wled_transpile_test.cpp -o arti_wled_transpile_test
+./arti_wled_transpile_test
@@ -89,13 +89,26 @@ enum Externals
 };
 
 #if ARTI_PLATFORM != ARTI_ARDUINO
+  #define hostLedsLength 4096
+
   class WS2812FX {
   public:
     uint16_t matrixWidth = 16, matrixHeight = 16;
+    uint16_t ledCount = 3; // used in testing e.g. for i = 1 to ledCount
+    bool serpentine = false; //odd rows from right to left, e.g. to test the layout of LedMap
+    uint32_t setPixelsCount = 0; //leds shown, e.g. to test skipped frames
+    float leds[hostLedsLength]; // colors set by the program e.g. to compare engines, see arti_wled_transpile_test.cpp
+
+    void setLed(uint16_t index, float color)
+    {
+      leds[index%hostLedsLength] = color;
+    }
 
     uint16_t XY(uint16_t x, uint16_t y)
     {
-      return x%matrixWidth + y%matrixHeight * matrixWidth;
+      x %= matrixWidth;
+      y %= matrixHeight;
+      return (serpentine && y%2?matrixWidth - 1 - x:x) + y * matrixWidth;
     }
 
     uint32_t millis()
@@ -114,21 +127,379 @@ enum Externals
 
 #endif
 
+//colors with white of the externals of strip: of the ARTI calling them (see ARTI::arti_external_function), else of a transpiled program (reclaimed by its loop)
+ColorTable transpiledColors;
+ColorTable *stripColors = &transpiledColors;
+
+#if ARTI_PLATFORM == ARTI_ARDUINO
+  float colorToValue(uint32_t color)
+  {
+    return stripColors->value(color);
+  }
+
+  uint32_t valueToColor(float value)
+  {
+    return stripColors->color(value);
+  }
+#endif
+
+#define sinTableLength 256 //steps of one period: linear interpolation is within (2 * PI / 256)^2 / 8 = 0.000075 of sin
+
+//sin of one period in sinTableLength steps, for fastMath (see fastSinTurns)
+struct SinTable {
+  float values[sinTableLength + 1]; //+1: the next value of the last step
+
+  SinTable()
+  {
+    for (uint16_t i = 0; i <= sinTableLength; i++)
+      values[i] = sin(i * 2 * PI / sinTableLength);
+  }
+};
+
+SinTable sinTable;
+
+//sin of turns (1 turn is 2 * PI radians), interpolated between the values of the sin table
+float fastSinTurns(float turns)
+{
+  float position = (turns - floorf(turns)) * sinTableLength;
+  uint16_t step = position;
+  if (step >= sinTableLength) //turns just below a whole number
+    step = sinTableLength - 1;
+  return sinTable.values[step] + (position - step) * (sinTable.values[step + 1] - sinTable.values[step]);
+}
+
+//same as sin(radians), the error is the error of the table plus the rounding of radians / (2 * PI) in floats: 0.00008 up to 100 radians, 0.00012 up to 1000 (see arti_wled_fastmath.cpp)
+float fastSin(float radians)
+{
+  return fastSinTurns(radians * (float)(1 / (2 * PI)));
+}
+
+//leds[i] = hsv(h, s, v) of R_CallExtStore: h, s and v are kept per led and converted for all leds at once, before the leds are used (see ARTI::arti_external_store_call)
+struct HsvLeds {
+  uint16_t length = 0;
+  float *hue = nullptr;
+  float *saturation = nullptr;
+  float *value = nullptr;
+  bool *set = nullptr; //set since the last convert
+  #if ARTI_THREADS
+    std::atomic<bool> pending{false}; //also set by the threads of runParallel
+  #else
+    bool pending = false;
+  #endif
+
+  ~HsvLeds()
+  {
+    free(hue);
+    free(saturation);
+    free(value);
+    free(set);
+  }
+
+  bool update(uint16_t ledCount)
+  {
+    if (ledCount == length && set != nullptr)
+      return true;
+
+    convert(); //the leds set with the previous length
+
+    free(hue); free(saturation); free(value); free(set);
+    hue = (float *)malloc(ledCount * sizeof(float));
+    saturation = (float *)malloc(ledCount * sizeof(float));
+    value = (float *)malloc(ledCount * sizeof(float));
+    set = (bool *)calloc(ledCount, sizeof(bool));
+    if (hue == nullptr || saturation == nullptr || value == nullptr || set == nullptr)
+    {
+      ERROR_ARTI("HsvLeds: no memory for %u leds\n", ledCount);
+      errorOccurred = true;
+      free(hue); free(saturation); free(value); free(set);
+      hue = nullptr; saturation = nullptr; value = nullptr; set = nullptr;
+      length = 0;
+      return false;
+    }
+    length = ledCount;
+    return true;
+  }
+
+  //false if led is not kept: no buffer yet (e.g. in main)
+  bool store(uint16_t led, float h, float s, float v)
+  {
+    if (led >= length)
+      return false;
+    hue[led] = h;
+    saturation[led] = s;
+    value[led] = v;
+    set[led] = true;
+    pending = true;
+    return true;
+  }
+
+  //the colors of the leds set, in one loop without the dispatch of hsv
+  void convert()
+  {
+    if (!pending)
+      return;
+    pending = false;
+
+    for (uint16_t i = 0; i < length; i++)
+    {
+      if (!set[i])
+        continue;
+      set[i] = false;
+      #if ARTI_PLATFORM == ARTI_ARDUINO
+        CRGB rgb;
+        hsv2rgb_rainbow(CHSV(hue[i], saturation[i], value[i]), rgb);
+        strip.arti_set_external_variable(colorToValue(crgb_to_col(rgb)), F_leds, i);
+      #else
+        strip.arti_set_external_variable(hue[i] + saturation[i] + value[i], F_leds, i); //same as hsv of the host
+      #endif
+    }
+  }
+
+}; //HsvLeds
+
+HsvLeds hsvLeds;
+
+#if ARTI_PLATFORM == ARTI_ARDUINO
+//led of degrees on the largest circle of the matrix, fast: sin and cos of the sin table
+uint16_t circle2D(float degrees, bool fast)
+{
+  uint16_t circleLength = min(strip.matrixWidth, strip.matrixHeight);
+  uint16_t deltaWidth=0, deltaHeight=0;
+
+  if (circleLength < strip.matrixHeight) //portrait
+    deltaHeight = (strip.matrixHeight - circleLength) / 2;
+  if (circleLength < strip.matrixWidth) //portrait
+    deltaWidth = (strip.matrixWidth - circleLength) / 2;
+
+  float halfLength = (circleLength-1)/2.0;
+
+  float sinValue = fast?fastSinTurns(degrees / 360):sin(radians(degrees));
+  float cosValue = fast?fastSinTurns(degrees / 360 + 0.25f):cos(radians(degrees));
+
+  //calculate circle positions, round to 5 digits and then round again to cater for radians inprecision (e.g. 3.49->3.5->4)
+  int x = round(round((sinValue * halfLength + halfLength) * 10)/10) + deltaWidth;
+  int y = round(round((halfLength - cosValue * halfLength) * 10)/10) + deltaHeight;
+  return strip.XY(x,y);
+}
+#endif
+
+//fastMath (see ARTI::fastMath): the math externals without libm (sin, fmod), else the externals of strip
 float ARTI::arti_external_function(uint8_t function, float par1, float par2, float par3, float par4, float par5)
 {
-  return strip.arti_external_function(function, par1, par2, par3, par4, par5);
+  #if ARTI_PLATFORM == ARTI_ARDUINO
+    stripColors = &colors; //no threads here
+  #endif
+  if (hsvLeds.pending && arti_external_state(function) == F_leds)
+    hsvLeds.convert();
+
+  if (fastMath)
+  {
+    switch (function)
+    {
+      case F_sin:
+        return fastSin(par1);
+      case F_cos:
+        return fastSinTurns(par1 * (float)(1 / (2 * PI)) + 0.25f);
+      case F_time: { //fmod(myVal, 1.0) of libm: truncf keeps the sign of negative values
+        float myVal = strip.arti_external_function(F_millis) / 65535.0f / par1;
+        return myVal - truncf(myVal);
+      }
+      case F_triangle: //fmod(2 * par1, 2.0) of libm is 2 * (par1 - truncf(par1)), exact in floats
+        return 1 - fabsf(2 * (par1 - truncf(par1)) - 1);
+      case F_wave:
+        return (1 + fastSinTurns(par1)) / 2;
+      case F_square:
+        return (1 + fastSinTurns(par1)) / 2 >= par2 ? 1 : 0;
+      #if ARTI_PLATFORM == ARTI_ARDUINO
+        case F_circle2D:
+          return circle2D(par1, true);
+      #endif
+    }
+  }
+  float result = strip.arti_external_function(function, par1, par2, par3, par4, par5);
+  if (frameInputsRecording)
+    frameInputRead(function, par1, par2, par3, result);
+  return result;
 }
 
 float ARTI::arti_get_external_variable(uint8_t variable, float par1, float par2, float par3)
 {
+  #if ARTI_PLATFORM == ARTI_ARDUINO
+    stripColors = &colors;
+  #endif
+  if (hsvLeds.pending && variable == F_leds)
+    hsvLeds.convert();
   return strip.arti_get_external_variable(variable, par1, par2, par3);
 }
 
 void ARTI::arti_set_external_variable(float value, uint8_t variable, float par1, float par2, float par3)
 {
+  #if ARTI_PLATFORM == ARTI_ARDUINO
+    stripColors = &colors;
+  #endif
+  if (hsvLeds.pending && variable == F_leds)
+    hsvLeds.convert();
   strip.arti_set_external_variable(value, variable, par1, par2, par3);
 }
 
+#define nrOfLayoutLeds 6
+
+//x, y and led index of each led of the matrix in row order: renderLed(x, y) and leds[x, y] look them up instead of dividing (and serpentine etc. of XY), made again if the geometry or the layout changes
+struct LedMap {
+  uint16_t width = 0, height = 0, ledCount = 0;
+  uint16_t layout[nrOfLayoutLeds]; //see layoutOf
+  uint16_t length = 0; //ledCount or width * height if more
+  float *x = nullptr; //formals of renderLed of led i
+  float *y = nullptr;
+  uint16_t *index = nullptr; //XY(x, y) of led i
+  bool changed = false; //made again by the last update
+
+  ~LedMap()
+  {
+    free(x);
+    free(y);
+    free(index);
+  }
+
+  //XY of the corners and of the second led of the first row and column: other if the segment is made serpentine, rotated, mirrored or transposed
+  static void layoutOf(uint16_t width, uint16_t height, uint16_t *layout)
+  {
+    uint16_t lastColumn = width - 1, lastRow = height > 0?height - 1:0;
+    layout[0] = strip.XY(0, 0);
+    layout[1] = strip.XY(lastColumn, 0);
+    layout[2] = strip.XY(0, lastRow);
+    layout[3] = strip.XY(lastColumn, lastRow);
+    layout[4] = strip.XY(1 % width, 0);
+    layout[5] = strip.XY(0, lastRow > 0?1:0);
+  }
+
+  bool update(uint16_t width, uint16_t height, uint16_t ledCount)
+  {
+    if (width == 0)
+      width = 1; //1D
+    uint16_t layout[nrOfLayoutLeds];
+    layoutOf(width, height, layout);
+
+    changed = false;
+    if (width == this->width && height == this->height && ledCount == this->ledCount && memcmp(layout, this->layout, sizeof(layout)) == 0 && index != nullptr)
+      return true;
+    changed = true;
+
+    uint32_t newLength = (uint32_t)width * height > ledCount?(uint32_t)width * height:ledCount;
+    if (newLength > UINT16_MAX)
+      newLength = UINT16_MAX;
+    if (newLength == 0)
+      newLength = 1;
+
+    free(x); free(y); free(index);
+    x = (float *)malloc(newLength * sizeof(float));
+    y = (float *)malloc(newLength * sizeof(float));
+    index = (uint16_t *)malloc(newLength * sizeof(uint16_t));
+    if (x == nullptr || y == nullptr || index == nullptr)
+    {
+      ERROR_ARTI("LedMap: no memory for %u leds\n", newLength);
+      errorOccurred = true;
+      free(x); free(y); free(index);
+      x = nullptr; y = nullptr; index = nullptr;
+      this->width = 0;
+      return false;
+    }
+
+    this->width = width;
+    this->height = height;
+    this->ledCount = ledCount;
+    memcpy(this->layout, layout, sizeof(layout));
+    length = newLength;
+    for (uint16_t i = 0; i < length; i++)
+    {
+      x[i] = i%width;
+      y[i] = i/width;
+      index[i] = strip.XY(i%width, i/width);
+    }
+    return true;
+  }
+
+  //led of leds[x, y]: XY if outside the matrix (or no map yet e.g. in main)
+  uint16_t led(uint16_t column, uint16_t row)
+  {
+    if (column < width && row < height)
+      return index[column + row * width];
+    return strip.XY(column, row);
+  }
+
+}; //LedMap
+
+#if ARTI_PLATFORM == ARTI_ARDUINO
+  #define nrOfLedMaps MAX_NUM_SEGMENTS
+#else
+  #define nrOfLedMaps 1
+#endif
+
+LedMap ledMaps[nrOfLedMaps]; //segments have their own geometry and layout
+uint8_t ledSegment = 0; //segment of the frame, set by the effect running the program (see mode_customEffect)
+LedMap *ledMap = &ledMaps[0]; //of ledSegment, see ARTI::loop
+
+//the leds, the random generator and the output are changed by externals, the others only depend on their parameters during a frame (see ARTI::buildLanes)
+uint8_t ARTI::arti_external_state(uint8_t external)
+{
+  switch (external)
+  {
+    case F_leds:
+    case F_setPixelColor:
+    case F_setPixels:
+    case F_setRange:
+    case F_fill:
+    case F_fadeToBlackBy:
+    case F_fadeOut:
+    case F_shift:
+      return F_leds;
+    case F_seed:
+    case F_random:
+      return F_random;
+    case F_printf:
+      return F_printf;
+  }
+  return noExternal;
+}
+
+//millis, time functions, random and the externals using the leds of the previous frame change each frame, segcolor and the palette can change between frames
+//only setting the leds (e.g. fill) does not depend on the frame, the frameConstant externals are compared as uniforms (see ARTI::skipFrame)
+uint8_t ARTI::arti_external_frame(uint8_t external)
+{
+  switch (external)
+  {
+    case F_leds: //read
+    case F_setPixelColor: //color from palette, not returned
+    case F_beatSin:
+    case F_fadeToBlackBy:
+    case F_fadeOut:
+    case F_shift:
+    case F_seed:
+    case F_random:
+    case F_hour:
+    case F_minute:
+    case F_second:
+    case F_millis:
+    case F_time:
+    case F_printf:
+      return frameDependent;
+    case F_colorFromPalette:
+    case F_segcolor:
+    case F_ledCount:
+    case F_matrixWidth:
+    case F_matrixHeight:
+    case F_counter:
+    case F_speedSlider:
+    case F_intensitySlider:
+    case F_custom1Slider:
+    case F_custom2Slider:
+    case F_custom3Slider:
+    case F_sampleAvg:
+      return frameInput;
+  }
+  return frameIndependent;
+}
+
 float WS2812FX::arti_external_function(uint8_t function, float par1, float par2, float par3, float par4, float par5) { 
   // MEMORY_ARTI("fun %d(%f, %f, %f)\n", function, par1, par2, par3);
   #if ARTI_PLATFORM == ARTI_ARDUINO
@@ -144,22 +515,22 @@ float WS2812FX::arti_external_function(uint8_t function, float par1, float par2,
         setPixels(leds);
         return floatNull;
       case F_hsv:
-        return crgb_to_col(CHSV(par1, par2, par3));
+        return colorToValue(crgb_to_col(CHSV(par1, par2, par3)));
 
       case F_setRange: {
-        setRange((uint16_t)par1, (uint16_t)par2, (uint32_t)par3);
+        setRange((uint16_t)par1, (uint16_t)par2, valueToColor(par3));
         return floatNull;
       }
       case F_fill: {
-        fill((uint32_t)par1);
+        fill(valueToColor(par1));
         return floatNull;
       }
       case F_colorBlend:
-        return color_blend((uint32_t)par1, (uint32_t)par2, (uint16_t)par3);
+        return colorToValue(color_blend(valueToColor(par1), valueToColor(par2), (uint16_t)par3));
       case F_colorWheel:
-        return color_wheel((uint8_t)par1);
+        return colorToValue(color_wheel((uint8_t)par1));
       case F_colorFromPalette:
-        return crgb_to_col(ColorFromPalette(currentPalette, (uint8_t)par1, (uint8_t)par2, LINEARBLEND));
+        return colorToValue(crgb_to_col(ColorFromPalette(currentPalette, (uint8_t)par1, (uint8_t)par2, LINEARBLEND)));
       case F_beatSin:
         return beatsin8((uint8_t)par1, (uint8_t)par2, (uint8_t)par3, (uint8_t)par4, (uint8_t)par5);
       case F_fadeToBlackBy:
@@ -172,7 +543,7 @@ float WS2812FX::arti_external_function(uint8_t function, float par1, float par2,
         return floatNull;
 
       case F_segcolor:
-        return SEGCOLOR((uint8_t)par1);
+        return colorToValue(SEGCOLOR((uint8_t)par1));
 
       case F_shift: {
         uint32_t saveFirstPixel = getPixelColor(0);
@@ -183,22 +554,8 @@ float WS2812FX::arti_external_function(uint8_t function, float par1, float par2,
         setPixelColor(SEGLEN - 1, saveFirstPixel);
         return floatNull;
       }
-      case F_circle2D: {
-        uint16_t circleLength = min(strip.matrixWidth, strip.matrixHeight);
-        uint16_t deltaWidth=0, deltaHeight=0;
-
-        if (circleLength < strip.matrixHeight) //portrait
-          deltaHeight = (strip.matrixHeight - circleLength) / 2;
-        if (circleLength < strip.matrixWidth) //portrait
-          deltaWidth = (strip.matrixWidth - circleLength) / 2;
-
-        float halfLength = (circleLength-1)/2.0;
-
-        //calculate circle positions, round to 5 digits and then round again to cater for radians inprecision (e.g. 3.49->3.5->4)
-        int x = round(round((sin(radians(par1)) * halfLength + halfLength) * 10)/10) + deltaWidth;
-        int y = round(round((halfLength - cos(radians(par1)) * halfLength) * 10)/10) + deltaHeight;
-        return strip.XY(x,y);
-      }
+      case F_circle2D:
+        return circle2D(par1, false);
 
       case F_constrain:
         return constrain(par1, par2, par3);
@@ -220,9 +577,11 @@ float WS2812FX::arti_external_function(uint8_t function, float par1, float par2,
     {
       case F_setPixelColor:
         PRINT_ARTI("%s(%f, %f)\n", "setPixelColor", par1, par2);
+        setLed((uint16_t)par1%ledCount, par2);
         return floatNull;
       case F_setPixels:
         PRINT_ARTI("%s\n", "setPixels(leds)");
+        setPixelsCount++;
         return floatNull;
       case F_hsv:
         PRINT_ARTI("%s(%f, %f, %f)\n", "hsv", par1, par2, par3);
@@ -232,6 +591,8 @@ float WS2812FX::arti_external_function(uint8_t function, float par1, float par2,
         return par1 + par2 + par3;
       case F_fill:
         PRINT_ARTI("%s(%f)\n", "fill", par1);
+        for (uint16_t i=0; i<ledCount; i++)
+          setLed(i, par1);
         return floatNull;
       case F_colorBlend:
         return par1 + par2 + par3;
@@ -349,9 +710,9 @@ float WS2812FX::arti_get_external_variable(uint8_t variable, float par1, float p
           return floatNull;
         }
         else if (par2 == floatNull)
-          return leds[(uint16_t)par1];
+          return colorToValue(crgb_to_col(leds[(uint16_t)par1]));
         else
-          return leds[XY((uint16_t)par1, (uint16_t)par2)]; //2D value!!
+          return colorToValue(crgb_to_col(leds[ledMap->led((uint16_t)par1, (uint16_t)par2)])); //2D value!!
 
       case F_counter:
         return SEGENV.call;
@@ -379,7 +740,7 @@ float WS2812FX::arti_get_external_variable(uint8_t variable, float par1, float p
     switch (variable)
     {
       case F_ledCount:
-        return 3; // used in testing e.g. for i = 1 to ledCount
+        return strip.ledCount;
       case F_matrixWidth:
         return 2;
       case F_matrixHeight:
@@ -424,7 +785,31 @@ float WS2812FX::arti_get_external_variable(uint8_t variable, float par1, float p
   return variable;
 }
 
-bool ledsSet; //check if leds is set 
+#if ARTI_THREADS
+  std::atomic<bool> ledsSet(false); //check if leds is set, also by the threads of runParallel
+#else
+  bool ledsSet; //check if leds is set 
+#endif
+
+//leds[i] = hsv(h, s, v) is converted later by hsvLeds (1D leds), other calls and stores as without R_CallExtStore
+void ARTI::arti_external_store_call(uint8_t variable, uint8_t function, float par1, float par2, float par3, float index1, float index2)
+{
+  if (variable == F_leds && function == F_hsv && index1 != floatNull && index2 == floatNull && hsvLeds.length > 0 && hsvLeds.store((uint16_t)index1 % hsvLeds.length, par1, par2, par3))
+  {
+    ledsSet = true;
+    return;
+  }
+  arti_set_external_variable(arti_external_function(function, par1, par2, par3), variable, index1, index2);
+}
+
+#if ARTI_THREADS
+//formals of the call of renderLed for led i: x and y
+void ledFormals(uint16_t i, float *formals)
+{
+  formals[0] = ledMap->x[i];
+  formals[1] = ledMap->y[i];
+}
+#endif
 
 void WS2812FX::arti_set_external_variable(float value, uint8_t variable, float par1, float par2, float par3) {
   #if ARTI_PLATFORM == ARTI_ARDUINO
@@ -438,9 +823,9 @@ void WS2812FX::arti_set_external_variable(float value, uint8_t variable, float p
           errorOccurred = true;
         }
         else if (par2 == floatNull)
-          leds[realPixelIndex((uint16_t)par1%SEGLEN)] = value;
+          leds[realPixelIndex((uint16_t)par1%SEGLEN)] = valueToColor(value);
         else
-          leds[XY((uint16_t)par1%SEGMENT.width, (uint16_t)par2%SEGMENT.height)] = value; //2D value!!
+          leds[ledMap->led((uint16_t)par1%SEGMENT.width, (uint16_t)par2%SEGMENT.height)] = valueToColor(value); //2D value!!
 
         ledsSet = true;
         return;
@@ -455,9 +840,15 @@ void WS2812FX::arti_set_external_variable(float value, uint8_t variable, float p
           errorOccurred = true;
         }
         else if (par2 == floatNull)
+        {
           RUNLOG_ARTI("arti_set_external_variable: leds(%f) := %f\n", par1, value);
+          setLed((uint16_t)par1%ledCount, value);
+        }
         else
+        {
           RUNLOG_ARTI("arti_set_external_variable: leds(%f, %f) := %f\n", par1, par2, value);
+          setLed(ledMap->led((uint16_t)par1, (uint16_t)par2), value); //2D value!!
+        }
 
         ledsSet = true;
         return;
@@ -472,7 +863,7 @@ bool ARTI::loop()
 {
   if (stages < 5) {close(); return true;}
 
-  if (parseTreeJsonDoc == nullptr || parseTreeJsonDoc->isNull()) 
+  if (!programLoaded()) 
   {
     ERROR_ARTI("Loop: No parsetree created\n");
     errorOccurred = true;
@@ -482,32 +873,73 @@ bool ARTI::loop()
   {
     uint8_t depth = 8;
 
+    snapshotUniforms(); //ledCount, sliders etc. are read once per frame
+
+    uint16_t ledCount = arti_get_external_variable(F_ledCount);
+    ledMap = &ledMaps[ledSegment % nrOfLedMaps];
+    if (!ledMap->update(strip.matrixWidth, strip.matrixHeight, ledCount) || !hsvLeds.update(ledCount))
+      return false;
+
+    if (ledMap->changed) //renderLed runs for other leds
+      frameInputsValid = false;
+    if (skipFrame()) //same as the previous frame: its leds are shown again (the pixels of the segment may have been changed since, e.g. by a transition). No frameDone: nothing is recorded
+    {
+      if (ledsSet) //by the last frame which ran
+        arti_external_function(F_setPixels);
+      frameCounter++;
+      return true;
+    }
+
     bool foundRenderFunction = false;
     
     const char * function_name = "renderFrame";
     Symbol* function_symbol = global_scope->lookup(function_name);
 
     ledsSet = false;
+    colors.reclaim(); //colors with white of the previous frame
 
     if (function_symbol != nullptr) { //calling undefined function: pre-defined functions e.g. print
 
       foundRenderFunction = true;
 
-      ActivationRecord* ar = new ActivationRecord(function_name, "Function", function_symbol->scope_level + 1);
+      ActivationRecord* ar = this->callStack->allocate(function_name, function_symbol->scope_level + 1, function_symbol->function_scope->recordSize());
+      if (ar == nullptr)
+        return false;
 
       RUNLOG_ARTI("%s %s %s (%u)\n", spaces+50-depth, "Call", function_name, this->callStack->recordsCounter);
 
       this->callStack->push(ar);
 
-      if (!interpret(function_symbol->block, nullptr, global_scope, depth + 1))
+      if (!run(function_symbol, depth + 1))
         return false;
 
       this->callStack->pop();
 
-      delete ar; ar = nullptr;
+      this->callStack->release(ar);
 
     } //function_symbol != nullptr
 
+    //the subexpressions of renderLed which are the same for all leds (see hoist)
+    function_name = "renderLedInvariants";
+    function_symbol = global_scope->lookup(function_name);
+
+    if (function_symbol != nullptr) {
+
+      ActivationRecord* ar = this->callStack->allocate(function_name, function_symbol->scope_level + 1, function_symbol->function_scope->recordSize());
+      if (ar == nullptr)
+        return false;
+
+      this->callStack->push(ar);
+
+      if (!run(function_symbol, depth + 1))
+        return false;
+
+      this->callStack->pop();
+
+      this->callStack->release(ar);
+
+    }
+
     function_name = "renderLed";
     function_symbol = global_scope->lookup(function_name);
 
@@ -515,23 +947,61 @@ bool ARTI::loop()
 
       foundRenderFunction = true;
 
-      ActivationRecord* ar = new ActivationRecord(function_name, "function", function_symbol->scope_level + 1);
+      ActivationRecord* ar = this->callStack->allocate(function_name, function_symbol->scope_level + 1, function_symbol->function_scope->recordSize());
+      if (ar == nullptr)
+        return false;
+
+      uint8_t nrOfFormals = function_symbol->function_scope->nrOfFormals == 2?2:1; // x or x and y are set
 
-      for (int i = 0; i< arti_get_external_variable(F_ledCount); i++)
+      #if ARTI_THREADS
+        //each call must set other leds: leds[x] if x differs for each led, leds[x, y] if x and y differ (see ledFormals)
+        uint8_t indices;
+        bool parallel = parallelSupported(function_symbol, &indices) && (indices == 0 || (indices == 1 && ledCount <= strip.matrixWidth) || (indices == 2 && nrOfFormals == 2 && ledCount <= strip.matrixWidth * strip.matrixHeight));
+        if (parallel)
+        {
+          if (!runParallel(function_symbol, nrOfFormals, ledCount, ledFormals))
+            return false;
+        }
+        else
+      #endif
+      if (lanesSupported(function_symbol, nrOfFormals))
       {
-        ar->set(function_symbol->function_scope->symbols[0]->scope_index, i%strip.matrixWidth); // set x
-        if (function_symbol->function_scope->nrOfFormals == 2) // 2D
-          ar->set(function_symbol->function_scope->symbols[1]->scope_index, i/strip.matrixWidth); // set y
+        float formals[2][ARTI_LANES];
+        for (uint16_t i = 0; i < ledCount; i += ARTI_LANES)
+        {
+          uint8_t count = (ledCount - i < ARTI_LANES)?ledCount - i:ARTI_LANES;
+          for (uint8_t lane = 0; lane < count; lane++)
+          {
+            formals[0][lane] = ledMap->x[i + lane];
+            formals[1][lane] = ledMap->y[i + lane];
+          }
 
-        this->callStack->push(ar);
+          this->callStack->push(ar);
 
-        if (!interpret(function_symbol->block, nullptr, global_scope, depth + 1))
-          return false;
+          if (!runLanes(formals, count))
+            return false;
 
-        this->callStack->pop();
+          this->callStack->pop();
+        }
       }
+      else
+      {
+        for (uint16_t i = 0; i < ledCount; i++)
+        {
+          ar->set(function_symbol->function_scope->symbols[0]->scope_index, ledMap->x[i]); // set x
+          if (function_symbol->function_scope->nrOfFormals == 2) // 2D
+            ar->set(function_symbol->function_scope->symbols[1]->scope_index, ledMap->y[i]); // set y
+
+          this->callStack->push(ar);
 
-      delete ar; ar = nullptr;
+          if (!run(function_symbol, depth + 1))
+            return false;
+
+          this->callStack->pop();
+        }
+      }
+
+      this->callStack->release(ar);
 
     }
 
@@ -549,6 +1019,8 @@ bool ARTI::loop()
       errorOccurred = true;
       return false;
     }
+
+    frameDone(true);
   }
   frameCounter++;
 
@@ -565,6 +1037,73 @@ bool ARTI::loop()
   return true;
 } // loop
 
+#if ARTI_PLATFORM != ARTI_ARDUINO
+//writes the loop of a transpiled program, same calls as ARTI::loop
+void ARTI::transpileLoop()
+{
+  Symbol* renderFrame = global_scope->lookup("renderFrame");
+  Symbol* renderLed = global_scope->lookup("renderLed");
+
+  if (renderFrame == nullptr && renderLed == nullptr)
+  {
+    ERROR_ARTI("Transpile: renderFrame or renderLed not found\n");
+    transpileError = true;
+    return;
+  }
+
+  transpileLine(1, "//renders a frame, like ARTI::loop");
+  transpileLine(1, "bool loop()");
+  transpileLine(1, "{");
+  transpileLine(2, "ledsSet = false;");
+  transpileLine(2, "stripColors = &transpiledColors;");
+  transpileLine(2, "transpiledColors.reclaim();");
+  transpileLine(2, "ledMap = &ledMaps[ledSegment %% nrOfLedMaps];");
+  transpileLine(2, "if (!ledMap->update(%smatrixWidth, %smatrixHeight, %sarti_get_external_variable(F_ledCount)))", transpileReceiver, transpileReceiver, transpileReceiver);
+  transpileLine(3, "return false;");
+
+  if (renderFrame != nullptr)
+  {
+    transpileLine(2, "{");
+    transpileLine(3, "float ar[%u] = {0};", renderFrame->function_scope->recordSize());
+    transpileLine(3, "renderFrame(ar, program);");
+    transpileLine(2, "}");
+  }
+
+  Symbol* renderLedInvariants = global_scope->lookup("renderLedInvariants");
+  if (renderLedInvariants != nullptr)
+  {
+    transpileLine(2, "{");
+    transpileLine(3, "float ar[%u] = {0};", renderLedInvariants->function_scope->recordSize());
+    transpileLine(3, "renderLedInvariants(ar, program);");
+    transpileLine(2, "}");
+  }
+
+  if (renderLed != nullptr)
+  {
+    ScopedSymbolTable* function_scope = renderLed->function_scope;
+
+    transpileLine(2, "{");
+    transpileLine(3, "float ar[%u] = {0}; //one record for all leds", function_scope->recordSize());
+    transpileLine(3, "uint16_t ledCount = %sarti_get_external_variable(F_ledCount);", transpileReceiver);
+    transpileLine(3, "for (uint16_t i = 0; i < ledCount; i++)");
+    transpileLine(3, "{");
+    if (function_scope->symbolsIndex > 0)
+      transpileLine(4, "ar[%u] = ledMap->x[i]; // set x", function_scope->symbols[0]->scope_index);
+    if (function_scope->nrOfFormals == 2) // 2D
+      transpileLine(4, "ar[%u] = ledMap->y[i]; // set y", function_scope->symbols[1]->scope_index);
+    transpileLine(4, "renderLed(ar, program);");
+    transpileLine(3, "}");
+    transpileLine(2, "}");
+  }
+
+  transpileLine(2, "if (ledsSet)");
+  transpileLine(3, "%sarti_external_function(F_setPixels);", transpileReceiver);
+  transpileLine(2, "frameCounter++;");
+  transpileLine(2, "return true;");
+  transpileLine(1, "}");
+}
+#endif
+
 #if ARTI_PLATFORM == ARTI_ARDUINO
 
 ARTI * arti;
@@ -642,6 +1181,8 @@ uint16_t WS2812FX::mode_customEffect(void)
   if (SEGENV.call == 0)
     strcpy(previousEffect, ""); //force init
 
+  ledSegment = _segment_index; //the map of the leds of this segment (see ARTI::loop)
+
   char currentEffect[charLength];
   strcpy(currentEffect, (SEGMENT.name != nullptr)?SEGMENT.name:"default"); //note: switching preset with segment name to preset without does not clear the SEGMENT.name variable, but not gonna solve here ;-)
 
@@ -0,0 +1,102 @@
+/*
+   @title   Arduino Real Time Interpreter (ARTI)
+   @file    arti_wled_benchmark.cpp
+   @version 0.3.0
+   @date    20220112
+   @author  Ewoud Wijma
+   @repo    https://github.com/ewoudwijma/ARTI
+   @remarks
+          - Frames per second of the Examples for each engine, see BenchmarkWled.sh
+          - The dispatch of the register engine is set at compile time with ARTI_DISPATCH
+          - jit runs the register code as machine code (x86-64 hosts), on other hosts it is the register engine
+          - lanes is the register engine running renderLed for ARTI_LANES pixels at once (register: one pixel at a time)
+          - threads: renderLed of a strip of hostLedsLength leds on the register engine, on one thread and on all cores (see ARTI::runParallel)
+ */
+
+#define ARTI_BENCHMARK 1 //no logging
+
+#include "arti_wled.h"
+
+#define benchmarkSeconds 0.5 //per program and engine
+
+float benchmark(const char *programName, uint8_t engine, bool lanes = true, uint8_t threads = 1) 
+{
+  ARTI *arti = new ARTI();
+  arti->lanes = lanes;
+  arti->threads = threads;
+  float fps = 0;
+
+  if (arti->setup("wled.json", programName, engine)) 
+  {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    uint32_t frames = 0;
+    float seconds = 0;
+    while (seconds < benchmarkSeconds && arti->loop())
+    {
+      frames++;
+      seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    if (seconds > 0)
+      fps = frames / seconds;
+  }
+  else
+    printf("setup fail %s\n", programName);
+
+  arti->close();
+  delete arti; arti = nullptr;
+
+  return fps;
+}
+
+int main() 
+{
+  const char * programs[] = {"Subpixel", "PhaseShift", "Mover", "WaveSins", "Sinelon", "drip", "PerlinMove", "block_reflections", "ripple", "Kitt", "beatmania", "halloween_color_twinkles", "matrix_2D_pulse"};
+
+  strip.ledCount = 300;
+
+  printf("Performance (fps) leds %u, dispatch %s\n", strip.ledCount, ARTI_DISPATCH == ARTI_THREADED?"threaded":"switch");
+  printf("%-26s %10s %10s %10s %10s %10s %10s %12s\n", "program", "walker", "stack", "register", "lanes", "closures", "jit", "jit/walker");
+
+  for (uint8_t i=0; i<sizeof(programs) / sizeof(programs[0]); i++)
+  {
+    char programName[fileNameLength];
+    strcpy(programName, "Examples/");
+    strcat(programName, programs[i]);
+    strcat(programName, ".wled");
+
+    float walker = benchmark(programName, E_TreeWalker);
+    float stack = benchmark(programName, E_StackVM);
+    float registers = benchmark(programName, E_RegisterVM, false);
+    float lanes = benchmark(programName, E_RegisterVM);
+    float closures = benchmark(programName, E_Closures);
+    float jit = benchmark(programName, E_JIT);
+
+    printf("%-26s %10.0f %10.0f %10.0f %10.0f %10.0f %10.0f %11.1fx\n", programs[i], walker, stack, registers, lanes, closures, jit, walker > 0?jit / walker:0);
+  }
+
+  //a strip: each call of renderLed sets its own led, so it can run on threads (see ARTI::parallelSupported)
+  const char * renderLedPrograms[] = {"Subpixel", "WaveSins", "block_reflections", "halloween_color_twinkles"};
+  strip.ledCount = hostLedsLength;
+  strip.matrixWidth = hostLedsLength;
+  strip.matrixHeight = 1;
+  uint8_t threads = std::thread::hardware_concurrency();
+  threads = threads < 2?2:threads > nrOfThreads?nrOfThreads:threads;
+
+  printf("\nThreads (fps) leds %u, register engine\n", strip.ledCount);
+  printf("%-26s %10s %10s %12s\n", "program", "1 thread", "threads", "speedup");
+
+  for (uint8_t i=0; i<sizeof(renderLedPrograms) / sizeof(renderLedPrograms[0]); i++)
+  {
+    char programName[fileNameLength];
+    strcpy(programName, "Examples/");
+    strcat(programName, renderLedPrograms[i]);
+    strcat(programName, ".wled");
+
+    float single = benchmark(programName, E_RegisterVM);
+    float parallel = benchmark(programName, E_RegisterVM, true, threads);
+
+    printf("%-26s %10.0f %10.0f %11.1fx (%u threads)\n", renderLedPrograms[i], single, parallel, single > 0?parallel / single:0, threads);
+  }
+}
@@ -0,0 +1,129 @@
+/*
+   @title   Arduino Real Time Interpreter (ARTI)
+   @file    arti_wled_fastmath.cpp
+   @version 0.3.0
+   @date    20220112
+   @author  Ewoud Wijma
+   @repo    https://github.com/ewoudwijma/ARTI
+   @remarks
+          - Accuracy and speed of the math externals with fastMath (lookup tables) compared to libm, see FastMathWled.sh
+          - Ranges with negative values: time and triangle keep the sign of fmod
+          - square is 0 or 1, so it differs by 1 where wave is within the error of the table from the duty cycle
+          - Frames per second of the Examples using math externals without and with fastMath
+ */
+
+#define ARTI_BENCHMARK 1 //no logging
+
+#include "arti_wled.h"
+
+#define nrOfValues 1000000
+#define benchmarkSeconds 0.5 //per program
+
+float values[nrOfValues];
+volatile float sink; //results are used so the calls are not optimized away
+
+//largest difference between fastMath and libm of function for par1 in [from, to), calls per microsecond of both
+void compare(const char *name, uint8_t function, float from, float to, float par2 = floatNull)
+{
+  ARTI *libm = new ARTI();
+  ARTI *fast = new ARTI();
+  fast->fastMath = true;
+
+  for (uint32_t i = 0; i < nrOfValues; i++)
+    values[i] = from + (to - from) * i / nrOfValues;
+
+  float maxError = 0;
+  for (uint32_t i = 0; i < nrOfValues; i++)
+  {
+    float error = fabsf(fast->arti_external_function(function, values[i], par2) - libm->arti_external_function(function, values[i], par2));
+    if (error > maxError)
+      maxError = error;
+  }
+
+  float speed[2];
+  ARTI *artis[2] = {libm, fast};
+  for (uint8_t j = 0; j < 2; j++)
+  {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    float sum = 0;
+    for (uint32_t i = 0; i < nrOfValues; i++)
+      sum += artis[j]->arti_external_function(function, values[i], par2);
+    sink = sum;
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    speed[j] = seconds > 0?nrOfValues / seconds / 1000000:0;
+  }
+
+  printf("%-10s %8.2f %8.2f %12.7f %10.0f %10.0f %9.1fx\n", name, from, to, maxError, speed[0], speed[1], speed[0] > 0?speed[1] / speed[0]:0);
+
+  delete libm; libm = nullptr;
+  delete fast; fast = nullptr;
+}
+
+float benchmark(const char *programName, bool fastMath)
+{
+  ARTI *arti = new ARTI();
+  arti->fastMath = fastMath;
+  float fps = 0;
+
+  if (arti->setup("wled.json", programName, E_RegisterVM))
+  {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    uint32_t frames = 0;
+    float seconds = 0;
+    while (seconds < benchmarkSeconds && arti->loop())
+    {
+      frames++;
+      seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    if (seconds > 0)
+      fps = frames / seconds;
+  }
+  else
+    printf("setup fail %s\n", programName);
+
+  arti->close();
+  delete arti; arti = nullptr;
+
+  return fps;
+}
+
+int main()
+{
+  printf("Math externals with fastMath compared to libm, %u values per range (calls per microsecond)\n", nrOfValues);
+  printf("%-10s %8s %8s %12s %10s %10s %10s\n", "external", "from", "to", "max error", "libm", "fastMath", "speedup");
+
+  compare("sin", F_sin, -2 * PI, 2 * PI);
+  compare("sin", F_sin, -100, 100);
+  compare("sin", F_sin, -1000, 1000);
+  compare("cos", F_cos, -2 * PI, 2 * PI);
+  compare("cos", F_cos, -100, 100);
+  compare("wave", F_wave, 0, 1);
+  compare("wave", F_wave, -100, 100);
+  compare("triangle", F_triangle, 0, 1);
+  compare("triangle", F_triangle, -1, 0);
+  compare("triangle", F_triangle, -100, 100);
+  compare("square", F_square, 0, 1, 0.5);
+  compare("square", F_square, -100, 100, 0.5);
+  compare("time", F_time, 0.001, 1);
+  compare("time", F_time, -1, -0.001);
+
+  const char * programs[] = {"WaveSins", "block_reflections", "matrix_2D_pulse"};
+
+  strip.ledCount = 300;
+
+  printf("\nPerformance (fps) leds %u, register engine\n", strip.ledCount);
+  printf("%-26s %10s %10s\n", "program", "libm", "fastMath");
+
+  for (uint8_t i=0; i<sizeof(programs) / sizeof(programs[0]); i++)
+  {
+    char programName[fileNameLength];
+    snprintf(programName, sizeof(programName), "Examples/%s.wled", programs[i]);
+
+    float libm = benchmark(programName, false);
+    float fast = benchmark(programName, true);
+
+    printf("%-26s %10.0f %10.0f\n", programs[i], libm, fast);
+  }
+}
@@ -0,0 +1,109 @@
+/*
+   @title   Arduino Real Time Interpreter (ARTI)
+   @file    arti_wled_lexer.cpp
+   @version 0.3.0
+   @date    20220112
+   @author  Ewoud Wijma
+   @repo    https://github.com/ewoudwijma/ARTI
+   @remarks
+          - Throughput of the Lexer on synthetic programs up to 50 KB, see LexerWled.sh
+          - Time per KB should not grow with the size of the program
+ */
+
+#define ARTI_BENCHMARK 1 //no logging
+
+#include "arti_wled.h"
+
+#define programLength 51200
+#define benchmarkSeconds 0.5 //per size
+
+char program[programLength + 1];
+
+//statements using ids, keywords, numbers, operators and comments, variables are numbered by line
+const char * lines[] = {
+  "  var%u = (var%u + 3) * 2.5 - counter %% 7 // assign\n",
+  "  if (var%u >= 10 && var%u != 2) { leds[var%u] = hsv(var%u, 255, 128) } else { var%u -= 1 }\n",
+  "  /* comment %u */ for (i%u = 0; i%u < ledCount; i%u++) { setPixelColor(i%u, colorWheel(i%u << 2)) }\n",
+  "  function f%u(a, b) { c%u = ? a > b ? a : b / 1.25 }\n"
+};
+
+//program of length characters made of lines
+uint16_t generate(uint16_t length)
+{
+  uint16_t pos = snprintf(program, programLength, "program Synthetic\n{\n");
+  for (uint16_t line = 0; ; line++)
+  {
+    char statement[200];
+    const char * format = lines[line % (sizeof(lines) / sizeof(lines[0]))];
+    unsigned int n = line;
+    uint16_t statementLength = snprintf(statement, sizeof(statement), format, n, n, n, n, n, n);
+    if (pos + statementLength + 2 > length) break;
+    strcpy(program + pos, statement);
+    pos += statementLength;
+  }
+  strcpy(program + pos, "}\n");
+  return pos + 2;
+}
+
+//tokens of program, 0 if lexer error
+uint32_t lex(Grammar *grammar)
+{
+  Lexer *lexer = new Lexer(program, grammar);
+  uint32_t tokens = 0;
+
+  if (lexer->tokenize() && lexer->pos == lexer->length)
+    tokens = lexer->tokensLength - 1; //without the end of the program
+
+  delete lexer; lexer = nullptr;
+  return tokens;
+}
+
+int main()
+{
+  std::fstream definitionFile;
+  definitionFile.open("wled.json", std::ios::in);
+  DynamicJsonDocument *definitionJsonDoc = new DynamicJsonDocument(16384);
+  DeserializationError err = deserializeJson(*definitionJsonDoc, definitionFile);
+  if (err)
+  {
+    printf("deserializeJson() of wled.json failed with code %s\n", err.c_str());
+    return 1;
+  }
+  Grammar *grammar = new Grammar(definitionJsonDoc->as<JsonObject>());
+
+  printf("Lexer throughput on synthetic programs (wled.json)\n");
+  printf("%10s %10s %12s %12s %12s\n", "bytes", "tokens", "us per run", "us per KB", "MB/s");
+
+  bool result = true;
+  for (uint32_t length = programLength / 8; length <= programLength; length *= 2)
+  {
+    uint16_t bytes = generate(length);
+    uint32_t tokens = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint32_t runs = 0;
+    float seconds = 0;
+    while (seconds < benchmarkSeconds)
+    {
+      tokens = lex(grammar);
+      if (tokens == 0) break;
+      runs++;
+      seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    if (tokens == 0 || runs == 0)
+    {
+      printf("%10u lexer error\n", bytes);
+      result = false;
+      break;
+    }
+
+    float microseconds = seconds * 1000000 / runs;
+    printf("%10u %10u %12.0f %12.1f %12.1f\n", bytes, tokens, microseconds, microseconds * 1024 / bytes, bytes / microseconds);
+  }
+
+  delete grammar; grammar = nullptr;
+  delete definitionJsonDoc; definitionJsonDoc = nullptr;
+
+  return result?0:1;
+}
@@ -0,0 +1,85 @@
+/*
+   @title   Arduino Real Time Interpreter (ARTI)
+   @file    arti_wled_superinstructions.cpp
+   @version 0.3.0
+   @date    20220112
+   @author  Ewoud Wijma
+   @repo    https://github.com/ewoudwijma/ARTI
+   @remarks
+          - Instructions of the register engine per Example without and with superinstructions (RegisterCode::fuse), see SuperinstructionsWled.sh
+          - Output is markdown, superinstructions.md is made with it
+ */
+
+#define ARTI_BENCHMARK 1 //no logging
+#define ARTI_COUNT 1 //count the instructions run by executeRegisters
+#define ARTI_LANES 1 //renderLed one pixel at a time: runLanes does not count
+
+#include "arti_wled.h"
+
+#define nrOfFrames 10
+
+//instructions of the register code and instructions run per frame
+bool count(const char *programName, bool superinstructions, uint16_t *instructions, uint32_t *executed)
+{
+  ARTI *arti = new ARTI();
+  arti->superinstructions = superinstructions;
+
+  srand(1);
+
+  bool result = arti->setup("wled.json", programName, E_RegisterVM);
+  uint32_t setupExecuted = 0;
+  if (result)
+    arti->registerCounts(instructions, &setupExecuted);
+
+  for (uint8_t frame = 0; frame < nrOfFrames && result; frame++)
+    result = arti->loop();
+
+  if (result)
+  {
+    arti->registerCounts(instructions, executed);
+    *executed = (*executed - setupExecuted) / nrOfFrames;
+  }
+  else
+    printf("setup or loop fail %s\n", programName);
+
+  arti->close();
+  delete arti; arti = nullptr;
+
+  return result;
+}
+
+int main()
+{
+  const char * programs[] = {"Subpixel", "PhaseShift", "Mover", "WaveSins", "Sinelon", "drip", "PerlinMove", "block_reflections", "ripple", "Kitt", "beatmania", "halloween_color_twinkles", "matrix_2D_pulse"};
+
+  strip.ledCount = 300;
+
+  printf("# Superinstructions\n\n");
+  printf("Instructions of the register engine without and with superinstructions, leds %u, average of %u frames (made by SuperinstructionsWled.sh)\n\n", strip.ledCount, nrOfFrames);
+  printf("| %-24s | %12s | %12s | %16s | %16s | %9s |\n", "program", "instructions", "fused", "run per frame", "fused", "reduction");
+  printf("|%s|%s|%s|%s|%s|%s|\n", "--------------------------", "-------------:", "-------------:", "-----------------:", "-----------------:", "----------:");
+
+  uint32_t totalExecuted = 0;
+  uint32_t totalFused = 0;
+  for (uint8_t i=0; i<sizeof(programs) / sizeof(programs[0]); i++)
+  {
+    char programName[fileNameLength];
+    strcpy(programName, "Examples/");
+    strcat(programName, programs[i]);
+    strcat(programName, ".wled");
+
+    uint16_t instructions = 0, fusedInstructions = 0;
+    uint32_t executed = 0, fusedExecuted = 0;
+    if (count(programName, false, &instructions, &executed) && count(programName, true, &fusedInstructions, &fusedExecuted))
+    {
+      printf("| %-24s | %12u | %12u | %16u | %16u | %8.1f%% |\n", programs[i], instructions, fusedInstructions, executed, fusedExecuted, executed > 0?100.0 * (executed - fusedExecuted) / executed:0);
+      totalExecuted += executed;
+      totalFused += fusedExecuted;
+    }
+  }
+
+  printf("| %-24s | %12s | %12s | %16u | %16u | %8.1f%% |\n", "total", "", "", totalExecuted, totalFused, totalExecuted > 0?100.0 * (totalExecuted - totalFused) / totalExecuted:0);
+
+  printf("\nSuperinstructions (the most frequent pairs run by the Examples): muladd a * b + c, mulsub a * b - c, mulmul a * b * c, divmul a / b * c, addmul (a + b) * c and callextstore e.g. leds[i] = hsv(h, s, v).\n");
+  printf("x = y op constant and x += expression are already one instruction: operands of register instructions can be variables and constants.\n");
+}
@@ -35,8 +35,193 @@ void execute(const char *definitionName, const char *programName)
   printf("done\n");
 }
 
+//decoded colors of numbers and of colors with white (see ColorTable)
+bool checkColors()
+{
+  struct {float value; uint32_t color;} numbers[] = {{0, 0}, {255, 0xFF}, {127.5, 0x7F}, {0xFFFFFF, 0xFFFFFF}, {-1, 0xFFFFFFFF}, {-0.5, 0}, {16777216.0f * 16, 0x10000000}, {colorNumbers, 0}, {1e20, 0}};
+  uint32_t colors[] = {0x123456, 0x01000000, 0x7F7F7F7F, 0xFF000000, 0xFFFFFFFF, 0xFF010203};
+
+  ColorTable table;
+  bool result = true;
+  logToFile = false; //the warnings and errors of the table, no ARTI opened the log
+  for (uint8_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++)
+    if (table.color(numbers[i].value) != numbers[i].color)
+    {
+      printf("color fail: number %f is %08x, not %08x\n", numbers[i].value, table.color(numbers[i].value), numbers[i].color);
+      result = false;
+    }
+  if (table.noColors != 2) //the numbers from 2^32 on
+    result = false;
+
+  float setupValue = table.value(0xAA000001); //made by setup: kept
+  table.reclaim();
+
+  //a frame, the worker reads the colors of the table
+  ColorTable worker;
+  worker.owner = 1;
+  worker.shared = &table;
+  worker.framesStarted = true;
+  worker.reclaim();
+  float values[sizeof(colors) / sizeof(colors[0])];
+  for (uint8_t i = 0; i < sizeof(colors) / sizeof(colors[0]); i++)
+  {
+    values[i] = table.value(colors[i]);
+    if (table.color(values[i]) != colors[i] || worker.color(values[i]) != colors[i] || table.value(colors[i]) != values[i] || !isfinite(values[i])) //a handle is a number
+    {
+      printf("color fail: %08x is %08x\n", colors[i], table.color(values[i]));
+      result = false;
+    }
+  }
+  float workerValue = worker.value(0xBB000002);
+  if (worker.color(workerValue) != 0xBB000002 || table.color(workerValue) != 0 || table.color(values[1] * 2) != 0) //not a color of the table: owner worker, calculated
+    result = false;
+  if (table.noColors != 2) //the numbers were reported by reclaim
+    result = false;
+
+  //the next frame: the colors of the previous frame are reclaimed
+  table.reclaim();
+  if (table.color(values[1]) != 0 || table.noColors != 1 || table.color(setupValue) != 0xAA000001 || table.length != 1)
+    result = false;
+  if (table.value(0xCC000003) == values[1]) //another handle for the reused slot
+    result = false;
+
+  //more colors than slots is an error
+  for (uint16_t i = 0; !errorOccurred && i <= nrOfColorSlots; i++)
+    table.value(0x01000000 + i);
+  if (!errorOccurred || table.length != nrOfColorSlots)
+    result = false;
+  errorOccurred = false;
+
+  table.release();
+  worker.release();
+  logToFile = true;
+  printf("colors %s\n", result?"ok":"fail");
+  return result;
+}
+
+//a valid program followed by text which is not part of it must not be set up
+bool checkTrailing()
+{
+  const char * program = "program Trailing\n{\n  function renderFrame()\n  {\n    x = 1\n  }\n}\n";
+  const char * trailings[] = {"", "plus", "mod 2", "and", "x = 2", "}"}; //"": the program without trailing text
+  const char * programName = "trailing.wled";
+
+  bool result = true;
+  for (uint8_t i = 0; i < sizeof(trailings) / sizeof(trailings[0]); i++)
+  {
+    FILE *programFile = fopen(programName, "w");
+    fprintf(programFile, "%s%s\n", program, trailings[i]);
+    fclose(programFile);
+
+    ARTI *arti = new ARTI();
+    bool setup = arti->setup("wled.json", programName);
+    arti->close();
+    delete arti; arti = nullptr;
+
+    if (setup != (trailings[i][0] == '\0'))
+    {
+      printf("trailing fail: \"%s\" after the program %s\n", trailings[i], setup?"set up":"not set up");
+      result = false;
+    }
+  }
+  remove(programName);
+  remove("trailing.wled.log");
+  remove("trailing.wled.json");
+
+  printf("trailing %s\n", result?"ok":"fail");
+  return result;
+}
+
+//a frame after the layout of the matrix changed runs with the leds of the new layout
+bool checkLayout()
+{
+  const char * programName = "layout.wled";
+  FILE *programFile = fopen(programName, "w");
+  fprintf(programFile, "program Layout\n{\n  function renderLed(x, y)\n  {\n    leds[x, y] = x + 100 * y + 1\n  }\n}\n");
+  fclose(programFile);
+
+  uint16_t matrixWidth = strip.matrixWidth, matrixHeight = strip.matrixHeight, ledCount = strip.ledCount;
+  strip.matrixWidth = 4; strip.matrixHeight = 2; strip.ledCount = 8;
+
+  ARTI *arti = new ARTI();
+  bool result = arti->setup("wled.json", programName);
+  memset(strip.leds, 0, sizeof(strip.leds));
+  result = result && arti->loop() && strip.leds[5] == 102; //x 1, y 1
+  strip.serpentine = true;
+  memset(strip.leds, 0, sizeof(strip.leds));
+  result = result && arti->loop() && strip.leds[6] == 102 && strip.leds[4] == 104; //the second row from right to left
+  arti->close();
+  delete arti; arti = nullptr;
+
+  strip.serpentine = false;
+  strip.matrixWidth = matrixWidth; strip.matrixHeight = matrixHeight; strip.ledCount = ledCount;
+  remove(programName);
+  remove("layout.wled.log");
+  remove("layout.wled.json");
+
+  printf("layout %s\n", result?"ok":"fail");
+  return result;
+}
+
+//a skipped frame shows the leds of the previous frame again
+bool checkSkipped()
+{
+  const char * programName = "skipped.wled";
+  FILE *programFile = fopen(programName, "w");
+  fprintf(programFile, "program Skipped\n{\n  function renderLed(x)\n  {\n    leds[x] = x + 1\n  }\n}\n");
+  fclose(programFile);
+
+  ARTI *arti = new ARTI();
+  bool result = arti->setup("wled.json", programName);
+  strip.setPixelsCount = 0;
+  result = result && arti->loop() && strip.setPixelsCount == 1;
+  memset(strip.leds, 0, sizeof(strip.leds));
+  result = result && arti->loop() && strip.leds[0] == 0 && strip.setPixelsCount == 2; //not run, shown
+  arti->close();
+  delete arti; arti = nullptr;
+
+  remove(programName);
+  remove("skipped.wled.log");
+  remove("skipped.wled.json");
+
+  printf("skipped %s\n", result?"ok":"fail");
+  return result;
+}
+
+//a program longer than 5000 characters is set up completely
+bool checkLong()
+{
+  const char * programName = "long.wled";
+  FILE *programFile = fopen(programName, "w");
+  fprintf(programFile, "program Long\n{\n  function renderFrame()\n  {\n    y = 0\n");
+  for (uint16_t i = 0; i < 500; i++)
+    fprintf(programFile, "    y = y + 1\n");
+  fprintf(programFile, "  }\n  function renderLed(x)\n  {\n    leds[x] = y\n  }\n}\n");
+  long length = ftell(programFile);
+  fclose(programFile);
+
+  ARTI *arti = new ARTI();
+  memset(strip.leds, 0, sizeof(strip.leds));
+  bool result = length > 5000 && arti->setup("wled.json", programName) && arti->loop() && strip.leds[0] == 500;
+  arti->close();
+  delete arti; arti = nullptr;
+
+  remove(programName);
+  remove("long.wled.log");
+  remove("long.wled.json");
+
+  printf("long %s\n", result?"ok":"fail");
+  return result;
+}
+
 int main() 
 {
+  bool result = checkColors();
+  result = checkTrailing() && result;
+  result = checkLayout() && result;
+  result = checkSkipped() && result;
+  result = checkLong() && result;
+
   execute("wled.json", "Examples/Subpixel.wled");
   execute("wled.json", "Examples/PhaseShift.wled");
   execute("wled.json", "Examples/Mover.wled");
@@ -50,6 +235,8 @@ int main()
   execute("wled.json", "Examples/beatmania.wled");
   execute("wled.json", "Examples/halloween_color_twinkles.wled");
   execute("wled.json", "Examples/matrix_2D_pulse.wled");
+
+  return result?0:1;
 }
 
 // Performance (fps) leds 50  300 prev 50  300   
@@ -0,0 +1,53 @@
+/*
+   @title   Arduino Real Time Interpreter (ARTI)
+   @file    arti_wled_transpile.cpp
+   @version 0.3.0
+   @date    20220112
+   @author  Ewoud Wijma
+   @repo    https://github.com/ewoudwijma/ARTI
+   @remarks
+          - Transpiles a wled program to a C++ struct with setup and loop, e.g. Examples/Kitt.wled to Examples/Kitt.wled.h with struct Kitt
+          - usage: arti_wled_transpile <program> [definition], see TranspileWled.sh
+          - The generated code calls the externals on strip, so it can be used in a WLED mode, see help.md
+ */
+
+#include "arti_wled.h"
+
+int main(int argc, char *argv[])
+{
+  if (argc < 2)
+  {
+    printf("usage: %s <program> [definition]\n", argv[0]);
+    return 1;
+  }
+
+  const char *programName = argv[1];
+  const char *definitionName = argc > 2?argv[2]:"wled.json";
+
+  char fileName[fileNameLength];
+  snprintf(fileName, sizeof(fileName), "%s.h", programName);
+
+  //struct name is the file name without folder and extension
+  char structName[charLength];
+  const char *baseName = strrchr(programName, '/');
+  strncpy(structName, baseName?baseName + 1:programName, sizeof(structName) - 1);
+  structName[sizeof(structName) - 1] = '\0';
+  char *extension = strchr(structName, '.');
+  if (extension)
+    *extension = '\0';
+
+  ARTI *arti = new ARTI();
+
+  //the transpiler uses the syntax tree of the tree walker
+  bool result = arti->setup(definitionName, programName, E_TreeWalker) && arti->transpile(fileName, structName, "strip.", "arti_wled.h");
+
+  arti->close();
+  delete arti; arti = nullptr;
+
+  if (result)
+    printf("transpiled %s into %s (struct %s)\n", programName, fileName, structName);
+  else
+    printf("transpile of %s failed, see %s.log\n", programName, programName);
+
+  return result?0:1;
+}
@@ -0,0 +1,122 @@
+/*
+   @title   Arduino Real Time Interpreter (ARTI)
+   @file    arti_wled_transpile_test.cpp
+   @version 0.3.0
+   @date    20220112
+   @author  Ewoud Wijma
+   @repo    https://github.com/ewoudwijma/ARTI
+   @remarks
+          - Runs the Examples with each engine and their transpiled versions and compares the leds after each frame, see TranspileWled.sh
+          - Examples using time (hour, minute, second) are not deterministic on the host so not compared
+ */
+
+#define ARTI_BENCHMARK 1 //no logging, only leds are compared
+
+#include "arti_wled.h"
+
+#include "Examples/Subpixel.wled.h"
+#include "Examples/PhaseShift.wled.h"
+#include "Examples/Mover.wled.h"
+#include "Examples/WaveSins.wled.h"
+#include "Examples/Sinelon.wled.h"
+#include "Examples/drip.wled.h"
+#include "Examples/PerlinMove.wled.h"
+#include "Examples/ripple.wled.h"
+#include "Examples/Kitt.wled.h"
+#include "Examples/beatmania.wled.h"
+
+#define nrOfFrames 50
+
+float interpretedLeds[nrOfFrames][hostLedsLength];
+
+//runs a program with an engine, then its transpiled version, returns if the leds are the same after each frame
+template <class Transpiled>
+bool compare(const char *programName, uint8_t engine)
+{
+  ARTI *arti = new ARTI();
+
+  memset(strip.leds, 0, sizeof(strip.leds));
+  srand(1);
+
+  bool result = arti->setup("wled.json", programName, engine);
+  for (uint8_t frame = 0; frame < nrOfFrames && result; frame++)
+  {
+    result = arti->loop();
+    memcpy(interpretedLeds[frame], strip.leds, sizeof(strip.leds));
+  }
+
+  arti->close();
+  delete arti; arti = nullptr;
+
+  if (!result)
+  {
+    printf("setup or loop fail %s\n", programName);
+    return false;
+  }
+
+  Transpiled *transpiled = new Transpiled();
+
+  memset(strip.leds, 0, sizeof(strip.leds));
+  srand(1);
+
+  transpiled->setup();
+  for (uint8_t frame = 0; frame < nrOfFrames && result; frame++)
+  {
+    transpiled->loop();
+    for (uint16_t i = 0; i < hostLedsLength && result; i++)
+    {
+      if (memcmp(&strip.leds[i], &interpretedLeds[frame][i], sizeof(float)) != 0)
+      {
+        printf("%s frame %u led %u: interpreted %f transpiled %f\n", programName, frame, i, interpretedLeds[frame][i], strip.leds[i]);
+        result = false;
+      }
+    }
+  }
+
+  delete transpiled; transpiled = nullptr;
+
+  return result;
+}
+
+template <class Transpiled>
+bool compareEngines(const char *name)
+{
+  char programName[fileNameLength];
+  snprintf(programName, sizeof(programName), "Examples/%s.wled", name);
+
+  bool result = true;
+  printf("%-26s", name);
+  for (uint8_t engine = E_TreeWalker; engine <= E_JIT; engine++)
+  {
+    bool same = compare<Transpiled>(programName, engine);
+    printf(" %10s", same?"ok":"different");
+    result = result && same;
+  }
+  printf("\n");
+
+  return result;
+}
+
+int main()
+{
+  strip.ledCount = 64; //4 rows for renderLed(x, y)
+
+  printf("Transpiled compared to interpreted, leds %u, frames %u\n", strip.ledCount, nrOfFrames);
+  printf("%-26s %10s %10s %10s %10s %10s\n", "program", "walker", "stack", "register", "closures", "jit");
+
+  bool result = true;
+  result = compareEngines<Subpixel>("Subpixel") && result;
+  result = compareEngines<PhaseShift>("PhaseShift") && result;
+  result = compareEngines<Mover>("Mover") && result;
+  result = compareEngines<WaveSins>("WaveSins") && result;
+  result = compareEngines<Sinelon>("Sinelon") && result;
+  result = compareEngines<drip>("drip") && result;
+  result = compareEngines<PerlinMove>("PerlinMove") && result;
+  result = compareEngines<ripple>("ripple") && result;
+  result = compareEngines<Kitt>("Kitt") && result;
+  result = compareEngines<beatmania>("beatmania") && result;
+
+  printf("%s\n", result?"all the same":"differences found");
+
+  return result?0:1;
+}